@@ -1,3 +1,3 @@
 #!/bin/bash
 
-java -jar OBJCooker.jar $1
\ No newline at end of file
+java -jar OBJCooker.jar "$@"
\ No newline at end of file
@@ -3,6 +3,8 @@ import java.io.IOException;
 import java.io.InputStreamReader;
 import java.io.PrintWriter;
 import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.List;
 
 import javax.swing.JFileChooser;
 import javax.xml.parsers.DocumentBuilder;
@@ -34,6 +36,10 @@ public class Main {
 						
 		String filename = infile.substring(0, infile.lastIndexOf('.') );
 		
+		//the next arguments are the lower LODs, as file.obj:screenSize from the most to the least detailed
+		List< Mesh > lods = new ArrayList< Mesh >();
+		List< Float > screenSizes = new ArrayList< Float >();
+		
 		Mesh m;
 		long t;
 		try {
@@ -47,10 +53,19 @@ public class Main {
 			
 			System.out.print( "Parsed " + m.getVertexCount() + " vertices and " + m.getIndexCount() + " indices... ");
 			System.out.println( t + " ms" );
+			
+			for( int i = 1; i < args.length; ++i ) {
+				int separator = args[i].lastIndexOf( ':' );
+				
+				System.out.println( "parsing LOD " + i + " " + args[i].substring( 0, separator ) + "..." );
+				
+				lods.add( new Mesh( args[i].substring( 0, separator ) ) );
+				screenSizes.add( Float.parseFloat( args[i].substring( separator + 1 ) ) );
+			}
 		
 			t = System.currentTimeMillis();
 			
-			m.write( filename + ".mesh", ByteOrder.LITTLE_ENDIAN );
+			m.write( filename + ".mesh", ByteOrder.LITTLE_ENDIAN, lods, screenSizes );
 			
 			System.out.println( (System.currentTimeMillis()-t) + " ms" );
 			
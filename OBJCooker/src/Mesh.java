@@ -384,4 +384,23 @@ public class Mesh {
 		//open file
 		write(	new EndiannessFilterStream(	endianness,	new FileOutputStream( outfile ) ) );
 	}
+	
+	public void write( String outfile, ByteOrder endianness, List< Mesh > lods, List< Float > screenSizes ) throws IOException {
+		
+		EndiannessFilterStream out = new EndiannessFilterStream( endianness, new FileOutputStream( outfile ) );
+		
+		write( out );
+		
+		//the lower LODs follow: their count, then the screen size and the data of each of them
+		if( lods.size() > 0 ) {
+			out.write( lods.size() );
+			
+			for( int i = 0; i < lods.size(); ++i ) {
+				out.writeFloat( screenSizes.get( i ) );
+				lods.get( i ).write( out );
+			}
+		}
+		
+		out.close();
+	}
 }
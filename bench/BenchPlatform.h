@@ -0,0 +1,105 @@
+#pragma once
+
+#include <dojo.h>
+
+#ifdef PLATFORM_WIN32
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace Dojo {
+
+	///A Platform without a window nor a GPU, which renders on the NullRenderDevice so that only the CPU side of the renderer is measured
+	class BenchPlatform : public Platform {
+	public:
+		///creates the BenchPlatform as the Platform singleton
+		static BenchPlatform& create(const Table& config = Table::Empty) {
+			gSingletonPtr = make_unique<BenchPlatform>(config);
+			return (BenchPlatform&)*gSingletonPtr;
+		}
+
+		explicit BenchPlatform(const Table& config) :
+			Platform(config) {
+			screenWidth = windowWidth = 1920;
+			screenHeight = windowHeight = 1080;
+			screenOrientation = DO_LANDSCAPE_RIGHT;
+			locale = "en";
+
+			auto temp = std::getenv("TMPDIR");
+			mTempPath = utf::string(temp ? temp : "/tmp") + "/dojo_bench";
+			mShaderCachePath = mTempPath + "/shadercache_";
+
+#ifdef PLATFORM_WIN32
+			_mkdir(mTempPath.bytes().c_str());
+#else
+			mkdir(mTempPath.bytes().c_str(), 0755);
+#endif
+		}
+
+		virtual void initialize(Unique<Game> g) override {
+			game = std::move(g);
+
+			auto success = NullRenderDevice::load();
+			DEBUG_ASSERT(success, "Cannot load the null render device");
+
+			render = make_unique<Renderer>(
+				RenderSurface{ windowWidth, windowHeight, PixelFormat::RGBA_8_8_8_8 },
+				DO_LANDSCAPE_RIGHT
+			);
+
+			running = true;
+		}
+
+		virtual void shutdown() override {
+			game = {};
+			render = {};
+			running = false;
+		}
+
+		virtual void prepareThreadContext() override {}
+
+		virtual void setFullscreen(bool enabled) override {}
+
+		virtual void acquireContext() override {}
+
+		virtual void step(float dt) override {}
+
+		virtual void loop() override {}
+
+		virtual void submitFrame() override {}
+
+		virtual PixelFormat loadImageFile(std::vector<uint8_t>& imageData, utf::string_view path, uint32_t& width, uint32_t& height, int& pixelSize) override {
+			FAIL("The benchmark doesn't load images");
+		}
+
+		virtual bool isNPOTEnabled() override {
+			return true;
+		}
+
+		virtual utf::string_view getAppDataPath() override {
+			return mTempPath;
+		}
+
+		virtual utf::string_view getRootPath() override {
+			return mTempPath;
+		}
+
+		virtual utf::string_view getResourcesPath() override {
+			return mTempPath;
+		}
+
+		virtual utf::string_view getPicturesPath() override {
+			return mTempPath;
+		}
+
+		virtual utf::string_view getShaderCachePath() override {
+			return mShaderCachePath;
+		}
+
+		virtual void openWebPage(utf::string_view site) override {}
+
+	protected:
+		utf::string mTempPath, mShaderCachePath;
+	};
+}
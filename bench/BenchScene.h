@@ -0,0 +1,181 @@
+#pragma once
+
+#include <dojo.h>
+
+#include <random>
+
+namespace Dojo {
+
+	///describes the kind of synthetic scene to build, the element count is chosen separately
+	struct SceneDesc {
+		const char* name;
+		int layerCount; ///<the elements are spread round-robin over this many layers
+		bool orthographic; ///<2D quads seen by an orthographic Viewport, or 3D boxes seen by a perspective one
+		bool uniqueMeshes; ///<every element has its own Mesh instead of sharing one
+		int shaderCount; ///<how many different Shaders the elements cycle through
+		bool moving; ///<the elements move every frame, which updates their bounds and the spatial index
+		bool spatialIndex; ///<the layers are culled through a spatial index
+		bool occlusion; ///<3D layers use occlusion culling, with a wall in front of the camera hiding part of the elements
+	};
+
+	///A GameState that fills the Renderer with a synthetic scene, of which roughly a quarter is on screen
+	class BenchScene : public GameState {
+	public:
+		BenchScene(Game& game, const SceneDesc& desc, uint32_t elementCount) :
+			GameState(game),
+			mDesc(desc) {
+			auto& renderer = Platform::singleton().getRenderer();
+
+			for (auto i : range(desc.layerCount)) {
+				auto& layer = renderer.getLayer(i);
+				if (not desc.orthographic) {
+					layer.make3D();
+				}
+				if (desc.spatialIndex) {
+					layer.enableSpatialIndex();
+				}
+				layer.occlusionCulling = desc.occlusion;
+			}
+
+			for (auto i : range(desc.shaderCount)) {
+				mShaders.emplace_back(_makeShader(i));
+			}
+
+			if (not desc.uniqueMeshes) {
+				mMeshes.emplace_back(_makeMesh());
+			}
+
+			_addCamera();
+
+			if (desc.occlusion and not desc.orthographic) {
+				_addWall();
+			}
+
+			std::mt19937 random(1234);
+			std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+			for (auto i : range(elementCount)) {
+				Vector position = desc.orthographic ?
+					Vector(unit(random) * ViewWidth, unit(random) * ViewHeight, 0) :
+					Vector(unit(random) * ViewWidth * 0.1f, unit(random) * ViewHeight * 0.1f, -50.f + unit(random) * 50.f);
+
+				auto object = make_unique<Object>(self, position, Vector::One);
+
+				if (desc.moving) {
+					object->speed = Vector(unit(random), unit(random), 0) * (desc.orthographic ? 100.f : 5.f);
+				}
+
+				if (desc.uniqueMeshes) {
+					mMeshes.emplace_back(_makeMesh());
+				}
+
+				RenderLayer::ID layer = i % desc.layerCount;
+				auto& shader = *mShaders[i % mShaders.size()];
+				object->addComponent(make_unique<Renderable>(*object, layer, *mMeshes.back(), shader));
+
+				addChild(std::move(object));
+			}
+		}
+
+		virtual ~BenchScene() {
+			//unregister the elements before their meshes and shaders go away
+			removeAllChildren();
+			Platform::singleton().getRenderer().clearLayers();
+		}
+
+		///runs the game side of a frame, moving the elements
+		void step(float dt) {
+			updateChilds(dt);
+		}
+
+	protected:
+		//the orthographic viewport is 1280x720, and the elements are spread over twice that in each direction
+		static const int ViewWidth = 1280, ViewHeight = 720;
+
+		SceneDesc mDesc;
+		std::vector<Unique<Mesh>> mMeshes;
+		std::vector<Unique<Shader>> mShaders;
+
+		void _addCamera() {
+			auto camera = make_unique<Object>(self, mDesc.orthographic ? Vector::Zero : Vector(0, 0, 60), Vector::One);
+
+			auto& viewport = camera->addComponent(make_unique<Viewport>(
+				*camera,
+				Vector((float)ViewWidth, (float)ViewHeight),
+				Color::Black,
+				mDesc.orthographic ? 0.0_deg : 60.0_deg,
+				0.1f,
+				200.f));
+
+			setViewport(viewport);
+			addChild(std::move(camera));
+		}
+
+		void _addWall() {
+			auto wall = make_unique<Object>(self, Vector(0, 0, 30), Vector::One);
+
+			//the same box as the elements, which share it when they don't have unique meshes
+			mMeshes.emplace_back(_makeMesh(true));
+			auto& mesh = *mMeshes.back();
+			auto renderable = make_unique<Renderable>(*wall, 0, mesh, *mShaders.front());
+			renderable->scale = Vector(30, 20, 2);
+			renderable->setOccluderMesh(mesh);
+
+			wall->addComponent(std::move(renderable));
+			addChild(std::move(wall));
+		}
+
+		Unique<Mesh> _makeMesh(bool dynamic = false) {
+			auto mesh = make_unique<Mesh>();
+			mesh->setDynamic(dynamic);
+
+			if (mDesc.orthographic) {
+				mesh->setVertexFields({ VertexField::Position2D, VertexField::UV0 });
+				mesh->setTriangleMode(PrimitiveMode::TriangleStrip);
+				mesh->begin(4);
+
+				for (auto i : range(4)) {
+					float u = (float)(i & 1), v = (float)(i >> 1);
+					mesh->vertex({ (u - 0.5f) * 16.f, (v - 0.5f) * 16.f });
+					mesh->uv(u, v);
+				}
+			}
+			else {
+				mesh->setVertexFields({ VertexField::Position3D, VertexField::Normal });
+				mesh->setTriangleMode(PrimitiveMode::TriangleList);
+				mesh->begin(8);
+
+				for (auto i : range(8)) {
+					Vector corner((float)(i & 1), (float)((i >> 1) & 1), (float)(i >> 2));
+					mesh->vertex(corner - Vector(0.5f));
+					mesh->normal(glm::normalize(corner - Vector(0.5f)));
+				}
+
+				static const Mesh::IndexType faces[6][4] = {
+					{ 0, 1, 2, 3 }, { 4, 6, 5, 7 }, { 0, 4, 1, 5 }, { 2, 3, 6, 7 }, { 0, 2, 4, 6 }, { 1, 5, 3, 7 }
+				};
+
+				for (auto&& face : faces) {
+					mesh->quad(face[0], face[1], face[2], face[3]);
+				}
+			}
+
+			mesh->end();
+			return mesh;
+		}
+
+		Unique<Shader> _makeShader(int index) {
+			//the sources only need to differ, the null device compiles anything
+			Table desc;
+			desc.set("vertexShader", utf::string("void main() { gl_Position = vec4(" + std::to_string(index) + ".0); }"));
+			desc.set("fragmentShader", utf::string("void main() {}"));
+
+			auto path = Platform::singleton().getAppDataPath() + "/shader" + utf::to_string(index) + ".shader";
+			Platform::singleton().save(desc, path);
+
+			auto shader = make_unique<Shader>(self, path);
+			shader->onLoad();
+			return shader;
+		}
+	};
+}
@@ -0,0 +1,142 @@
+#include <dojo.h>
+
+#include "BenchPlatform.h"
+#include "BenchScene.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace Dojo;
+
+//dojo_bench renders synthetic scenes on the null device and reports the CPU cost of each stage of Renderer::renderFrame
+//usage: dojo_bench [--frames N] [--max-count N] [--scene filter]
+
+class BenchGame : public Game {
+public:
+	BenchGame() :
+		Game("dojo_bench", 1280, 720) {
+
+	}
+};
+
+static const SceneDesc SCENES[] = {
+	//name						layers	ortho	unique	shaders	moving	index	occlusion
+	{ "2d_static",				1,		true,	false,	1,		false,	false },
+	{ "2d_moving",				1,		true,	false,	1,		true,	false },
+	{ "2d_unique",				1,		true,	true,	64,		false,	false },
+	{ "2d_8_layers",			8,		true,	false,	1,		false,	false },
+	{ "2d_static_index",		1,		true,	false,	1,		false,	true },
+	{ "2d_moving_index",		1,		true,	false,	1,		true,	true },
+	{ "3d_static",				1,		false,	false,	1,		false,	false },
+	{ "3d_moving",				1,		false,	false,	1,		true,	false },
+	{ "3d_unique",				1,		false,	true,	64,		false,	false },
+	{ "3d_8_layers",			8,		false,	false,	8,		false,	false },
+	{ "3d_static_index",		1,		false,	false,	1,		false,	true },
+	{ "3d_moving_index",		1,		false,	false,	1,		true,	true },
+	{ "3d_static_occluded",		1,		false,	false,	1,		false,	false,	true },
+	{ "3d_moving_occluded",		1,		false,	false,	1,		true,	false,	true },
+};
+
+static const uint32_t ELEMENT_COUNTS[] = { 1000, 10000, 100000, 1000000 };
+
+static const int WARMUP_FRAMES = 10;
+
+///collects the per-frame samples of a stage, in milliseconds
+struct Samples {
+	std::vector<double> values;
+
+	void add(double seconds) {
+		values.push_back(seconds * 1000.0);
+	}
+
+	double percentile(double p) {
+		DEBUG_ASSERT(values.size() > 0, "No samples");
+		auto idx = std::min((size_t)(p * values.size()), values.size() - 1);
+		std::nth_element(values.begin(), values.begin() + idx, values.end());
+		return values[idx];
+	}
+};
+
+void _printRow(const char* scene, uint32_t count, Samples& update, Samples& cull, Samples& submit, Samples& total, uint32_t drawCalls) {
+	printf("%-18s %9u", scene, count);
+	for (auto stage : { &update, &cull, &submit, &total }) {
+		printf(" %9.3f %9.3f", stage->percentile(0.5), stage->percentile(0.99));
+	}
+	printf(" %9u\n", drawCalls);
+	fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+	int frames = 100;
+	uint32_t maxCount = UINT32_MAX;
+	const char* sceneFilter = nullptr;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--frames") == 0) {
+			frames = std::max(atoi(argv[i + 1]), 1);
+		}
+		else if (strcmp(argv[i], "--max-count") == 0) {
+			maxCount = (uint32_t)atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--scene") == 0) {
+			sceneFilter = argv[i + 1];
+		}
+	}
+
+	auto& platform = BenchPlatform::create();
+	platform.initialize(make_unique<BenchGame>());
+
+	auto& renderer = platform.getRenderer();
+
+#if defined(DOJO_SIMD_AVX)
+	const char* simd = "AVX";
+#elif defined(DOJO_SIMD_SSE)
+	const char* simd = "SSE";
+#else
+	const char* simd = "none";
+#endif
+
+	printf("dojo_bench: %d frames per run, SIMD culling: %s, times in ms as median/p99\n", frames, simd);
+	printf("%-18s %9s %19s %19s %19s %19s %9s\n", "scene", "elements", "update", "cull", "submit", "frame", "draws");
+
+	const float dt = 1.f / 60.f;
+
+	for (auto&& desc : SCENES) {
+		if (sceneFilter and not strstr(desc.name, sceneFilter)) {
+			continue;
+		}
+
+		for (auto count : ELEMENT_COUNTS) {
+			if (count > maxCount) {
+				continue;
+			}
+
+			auto scene = make_unique<BenchScene>(platform.getGame(), desc, count);
+
+			Samples update, cull, submit, total;
+			uint32_t drawCalls = 0;
+
+			for (int i = 0; i < WARMUP_FRAMES + frames; ++i) {
+				scene->step(dt);
+
+				NullRenderDevice::resetStats();
+				renderer.renderFrame(dt);
+				renderer.endFrame();
+
+				if (i >= WARMUP_FRAMES) {
+					update.add(renderer.getLastFrameUpdateTime());
+					cull.add(renderer.getLastFrameCullTime());
+					submit.add(renderer.getLastFrameSubmitTime());
+					total.add(renderer.getLastFrameUpdateTime() + renderer.getLastFrameCullTime() + renderer.getLastFrameSubmitTime());
+					drawCalls = NullRenderDevice::getStats().drawCalls;
+				}
+			}
+
+			_printRow(desc.name, count, update, cull, submit, total, drawCalls);
+		}
+	}
+
+	Platform::shutdownPlatform();
+	return 0;
+}
@@ -3,6 +3,8 @@
 #include <dojo/AnimatedQuad.h>
 #include <dojo/ApplicationListener.h>
 #include <dojo/AStar.h>
+#include <dojo/AtlasPacker.h>
+#include <dojo/AtlasPage.h>
 #include <dojo/SPSCQueue.h>
 #include <dojo/BackgroundWorker.h>
 #include <dojo/Base64.h>
@@ -23,9 +25,14 @@
 #include <dojo/Keyboard.h>
 #include <dojo/KeyCode.h>
 #include <dojo/Log.h>
+#include <dojo/MappedFile.h>
 #include <dojo/Mesh.h>
+#include <dojo/MeshOptimizer.h>
+#include <dojo/MeshPack.h>
 #include <dojo/MPSCQueue.h>
 #include <dojo/Noise.h>
+#include <dojo/NullRenderDevice.h>
+#include <dojo/OcclusionBuffer.h>
 #include <dojo/Object.h>
 #include <dojo/Oscillator.h>
 #include <dojo/Plane.h>
@@ -39,6 +46,7 @@
 #include <dojo/RenderState.h>
 #include <dojo/Renderable.h>
 #include <dojo/ResourceGroup.h>
+#include <dojo/ResourceLoader.h>
 #include <dojo/SoundBuffer.h>
 #include <dojo/SoundListener.h>
 #include <dojo/SoundManager.h>
@@ -51,9 +59,12 @@
 #include <dojo/Tessellation.h>
 #include <dojo/TextArea.h>
 #include <dojo/Texture.h>
+#include <dojo/TextureContainer.h>
+#include <dojo/TextureStreamer.h>
 #include <dojo/TimedEvent.h>
 #include <dojo/Timer.h>
 #include <dojo/TouchArea.h>
+#include <dojo/TransformSystem.h>
 #include <dojo/Vector.h>
 #include <dojo/Viewport.h>
 #include <dojo/WorkerPool.h>
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "SpatialIndex.h"
+
+namespace Dojo {
+
+	///An AABBTree is a dynamic bounding volume hierarchy, meant for 3D layers
+	/**
+	Leaves hold a "fat" box slightly bigger than the element, so that small movements don't touch the tree at all;
+	insertions pick the sibling that grows the tree the least, and rotations keep it balanced.
+	*/
+	class AABBTree : public SpatialIndex {
+	public:
+		///how much the leaf boxes are enlarged, relative to the size of the element
+		static const float FatMargin;
+
+		AABBTree();
+
+		virtual Proxy insert(Renderable& r, const AABB& bounds) override;
+		virtual void move(Proxy proxy, const AABB& bounds) override;
+		virtual void remove(Proxy proxy) override;
+		virtual void query(const BoundsTest& test, const Visitor& visit) const override;
+
+		virtual size_t size() const override {
+			return mLeafCount;
+		}
+
+		///returns the height of the tree, log2 of the size when balanced
+		int getHeight() const;
+
+	protected:
+		static const int Null = -1;
+
+		struct Node {
+			AABB bounds;
+			Renderable* renderable = nullptr;
+			int parent = Null; //doubles as the next free node
+			int child1 = Null, child2 = Null;
+			int height = 0; //-1 for free nodes
+
+			bool isLeaf() const {
+				return child1 == Null;
+			}
+		};
+
+		std::vector<Node> mNodes;
+		int mRoot = Null, mFreeList = Null;
+		size_t mLeafCount = 0;
+
+		int _allocateNode();
+		void _freeNode(int node);
+
+		void _insertLeaf(int leaf);
+		void _removeLeaf(int leaf);
+		int _balance(int node);
+
+		void _query(int node, const BoundsTest& test, const Visitor& visit) const;
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///An AtlasPacker places rectangles in a page with the skyline bottom-left heuristic
+	/**
+	The page keeps the "skyline" of the top edges of the rectangles placed so far, as horizontal segments;
+	a new rectangle goes where its top edge is the lowest, so the waste under the skyline stays small.
+	Placing the rectangles from the tallest works best.
+	*/
+	class AtlasPacker {
+	public:
+		AtlasPacker(uint32_t width, uint32_t height);
+
+		///finds a place for a rectangle and reserves it
+		/**
+		\returns false if the rectangle doesn't fit in the page anymore
+		*/
+		bool insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+		///returns the right edge of the rightmost rectangle placed so far
+		uint32_t getUsedWidth() const {
+			return mUsedWidth;
+		}
+
+		///returns the top edge of the highest rectangle placed so far
+		uint32_t getUsedHeight() const {
+			return mUsedHeight;
+		}
+
+	protected:
+		struct Segment {
+			uint32_t x, y, width;
+		};
+
+		uint32_t mWidth, mHeight;
+		uint32_t mUsedWidth = 0, mUsedHeight = 0;
+
+		std::vector<Segment> mSkyline;
+
+		///tells if a rectangle fits starting at the given segment, and at which height it would lie
+		bool _fits(size_t segment, uint32_t width, uint32_t height, uint32_t& y) const;
+	};
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Texture.h"
+
+namespace Dojo {
+	///An AtlasPage is a Texture composed at load time from many loose image files, that become its tiles
+	/**
+	A ResourceGroup with packLooseFrames creates the pages: it packs the small frames of its FrameSets with an
+	AtlasPacker and turns their Textures into tiles of the pages, see Texture::loadFromAtlas.
+	onPrepare() decodes the images and copies them in the page, onLoad() uploads it.
+
+	The tiles are separated by a gutter where their borders are repeated, so that filtering doesn't blend the neighbors.
+	*/
+	class AtlasPage : public Texture {
+	public:
+		///the biggest side of a page
+		static const uint32_t MaxSide = 2048;
+
+		///the frames bigger than this on either side stay loose
+		static const uint32_t MaxTileSide = 256;
+
+		///the pixels between the tiles, half on each side
+		static const uint32_t Gutter = 2;
+
+		struct Tile {
+			utf::string path;
+			uint32_t x, y, width, height;
+		};
+
+		AtlasPage(optional_ref<ResourceGroup> creator, uint32_t width, uint32_t height);
+
+		///adds the image file that will be copied at x, y
+		void addTile(utf::string_view path, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+		const std::vector<Tile>& getTiles() const {
+			return mTiles;
+		}
+
+		uint32_t getPageWidth() const {
+			return mPageWidth;
+		}
+
+		uint32_t getPageHeight() const {
+			return mPageHeight;
+		}
+
+		///decodes the images of the tiles into the page
+		virtual void onPrepare() override;
+
+		///uploads the page, composing it first if it wasn't prepared
+		virtual bool onLoad() override;
+
+		///the page can always be composed again, so it's unloaded by soft unloads too
+		virtual void onUnload(bool soft = false) override;
+
+	protected:
+		uint32_t mPageWidth, mPageHeight;
+		std::vector<Tile> mTiles;
+
+		std::vector<uint8_t> mPixels;
+		PixelFormat mFormat = PixelFormat::RGBA_8_8_8_8;
+	};
+}
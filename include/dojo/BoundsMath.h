@@ -0,0 +1,56 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "AABB.h"
+
+namespace Dojo {
+	class Plane;
+
+	///The side planes of a frustum, laid out to be tested all at once
+	struct FrustumPlanes {
+		static const int Count = 4;
+
+		alignas(16) float nx[Count], ny[Count], nz[Count], d[Count];
+		alignas(16) float absNx[Count], absNy[Count], absNz[Count];
+
+		void setup(const Plane* planes);
+	};
+
+	///A structure-of-arrays of AABBs stored as centers and half extents, so that they can be culled many at a time
+	class AABBArray {
+	public:
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+
+		size_t size() const {
+			return centerX.size();
+		}
+
+		///resizes the arrays, they keep their capacity when shrinking
+		void resize(size_t size);
+
+		void set(size_t i, const AABB& bb);
+
+		///stores the world space bounds of a local box, see BoundsMath::transform
+		void set(size_t i, const Matrix& transform, const AABB& local);
+
+		AABB get(size_t i) const;
+	};
+
+	///BoundsMath implements the hot AABB operations used by culling, with SSE/AVX paths and a scalar fallback
+	class BoundsMath {
+	public:
+		///returns the world AABB of a local AABB, from its transformed center and extents rather than its 8 corners
+		static AABB transform(const Matrix& transform, const AABB& local);
+
+		///tells if an AABB isn't completely behind any of the frustum planes
+		static bool isInFrustum(const FrustumPlanes& frustum, const AABB& bb);
+
+		///tests the AABBs in [begin, end) against the frustum, writing the indices of the visible ones in ascending order
+		/**
+		\returns how many indices were written to outIndices, which must have room for end - begin
+		*/
+		static uint32_t cullFrustum(const FrustumPlanes& frustum, const AABBArray& boxes, uint32_t begin, uint32_t end, uint32_t* outIndices);
+	};
+}
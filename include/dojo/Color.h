@@ -140,6 +140,14 @@ namespace Dojo {
 						a * invs + c.a * s);
 		}
 
+		bool operator ==(const Color& c) const {
+			return r == c.r and g == c.g and b == c.b and a == c.a;
+		}
+
+		bool operator !=(const Color& c) const {
+			return not (self == c);
+		}
+
 		void operator *=(float s) {
 			r *= s;
 			g *= s;
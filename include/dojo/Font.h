@@ -25,6 +25,7 @@ namespace Dojo {
 	class Texture;
 	class ResourceGroup;
 	class Tessellation;
+	class Table;
 
 	class Font : public Resource {
 	public:
@@ -124,6 +125,9 @@ namespace Dojo {
 
 		virtual ~Font();
 
+		///reads the descriptor and the typeface file, the pages are rendered by onLoad
+		virtual void onPrepare();
+
 		virtual bool onLoad();
 		///purges all the loaded pages from memory and prompts a rebuild
 		virtual void onUnload(bool soft = false);
@@ -206,6 +210,10 @@ namespace Dojo {
 
 		FT_Face face;
 
+		//read by onPrepare
+		Unique<Table> mDescriptor;
+		std::vector<uint8_t> mFaceFile;
+
 		///this has to be called each time that we need to use the face
 		void _prepareFace();
 
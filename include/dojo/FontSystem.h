@@ -14,7 +14,11 @@ namespace Dojo {
 
 		virtual ~FontSystem();
 
-		FT_Face getFace(utf::string_view fileName);
+		///returns the face for a file, creating it if needed
+		/**
+		\param fileContent the content of the file if it was already read, else it's read when the face is created
+		*/
+		FT_Face getFace(utf::string_view fileName, std::vector<uint8_t> fileContent = {});
 
 		FT_Stroker getStroker(float width);
 
@@ -25,7 +29,7 @@ namespace Dojo {
 
 		FT_Library freeType;
 
-		FT_Face _createFaceForFile(utf::string_view fileName);
+		FT_Face _createFaceForFile(utf::string_view fileName, std::vector<uint8_t> buf);
 
 	private:
 	};
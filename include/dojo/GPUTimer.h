@@ -0,0 +1,73 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "RenderLayer.h"
+
+namespace Dojo {
+	class Viewport;
+
+	///A GPUTimer measures how long the GPU spends on each section of a frame, using GL_TIME_ELAPSED queries
+	/**
+	Each frame records its sections in its own pool of queries, and a pool is read back only once all of its results are available,
+	which usually takes a couple of frames: the GPU is never waited on.
+	If the pool of a frame is still busy when the frame starts, that frame simply isn't measured.
+	*/
+	class GPUTimer {
+	public:
+		///what a section of the frame was rendering
+		struct Section {
+			const Viewport* viewport;
+			RenderLayer::ID layer; ///<InvalidID for the work of the viewport itself, eg. clearing its target
+		};
+
+		///the GPU time of a whole frame, in milliseconds
+		struct Timings {
+			float frame = 0;
+			std::vector<std::pair<const Viewport*, float>> viewports;
+			std::vector<float> layers; ///<indexed by layer ID, summed over all the viewports
+		};
+
+		///tells if the context can measure GPU time
+		static bool isSupported();
+
+		GPUTimer();
+
+		~GPUTimer();
+
+		///reads back the frames that finished on the GPU, and starts recording a new one
+		void beginFrame();
+
+		///starts timing a section, sections can't be nested
+		void begin(const Section& section);
+
+		///ends the section started by the last begin()
+		void end();
+
+		void endFrame();
+
+		///returns the timings of the last frame that was read back
+		const Timings& getLastTimings() const {
+			return mLastTimings;
+		}
+
+	protected:
+		//how many frames can be in flight before a frame goes unmeasured
+		static const int PoolCount = 3;
+
+		struct Pool {
+			std::vector<uint32_t> queries;
+			std::vector<Section> sections;
+			bool pending = false;
+		};
+
+		std::array<Pool, PoolCount> mPools;
+		int mCurrentPool = 0;
+		optional_ref<Pool> mRecording;
+
+		Timings mLastTimings;
+
+		bool _isAvailable(const Pool& pool) const;
+		void _collect(Pool& pool);
+	};
+}
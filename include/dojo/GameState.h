@@ -65,6 +65,23 @@ namespace Dojo {
 		///sets the primary Viewport (ie. camera) on this GameState, needed for pixel-perfect behaviour! (Sprites and TextAreas)
 		void setViewport(Viewport& v);
 
+		///moves the transforms of all the Objects in this GameState to a TransformSystem, updated in parallel at the end of each onLoop()
+		/**
+		It pays off on big hierarchies: the Objects' world transforms are computed one depth level at a time from flat arrays,
+		but they aren't updated during the Objects' onAction anymore, only once all of them acted.
+		*/
+		void enableTransformSystem();
+
+		///goes back to updating the world transforms in each Object's onAction
+		void disableTransformSystem();
+
+		optional_ref<TransformSystem> getTransformSystem() {
+			if (mTransforms) {
+				return *mTransforms;
+			}
+			return{};
+		}
+
 		///"touches" all the touchAreas with the given touch
 		/**touched TouchAreas will fire onTouchAreaPressed() on their listeners as soon as updateClickableState() is called*/
 		void touchAreaAtPoint(const Touch& touch);
@@ -91,5 +108,7 @@ namespace Dojo {
 		Game& game;
 
 		optional_ref<Viewport> camera;
+
+		Unique<TransformSystem> mTransforms;
 	};
 }
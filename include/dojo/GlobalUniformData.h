@@ -5,8 +5,23 @@
 namespace Dojo {
 	class GlobalUniformData {
 	public:
-		Matrix view, projection, world, worldView, worldViewProjection;
+		Matrix view, projection, viewProjection, world, worldView, worldViewProjection;
 		Vector viewDirection, targetDimension;
+		float time = 0.f;
+	};
+
+	///The std140 layout of the VIEW_UNIFORMS block, see Shader::UniformBlock
+	struct ViewUniformBlock {
+		Matrix view, projection, viewProjection;
+		glm::vec4 viewDirection; ///<xyz
+		glm::vec4 targetDimension; ///<xy is the size in pixels, zw is the size of a pixel in UV space
+		glm::vec4 time; ///<x
+	};
+
+	///The std140 layout of the DRAW_UNIFORMS block, see Shader::UniformBlock
+	struct DrawUniformBlock {
+		Matrix world, worldView, worldViewProjection;
+		glm::vec4 objectColor;
 	};
 }
 
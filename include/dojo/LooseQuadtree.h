@@ -0,0 +1,64 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "SpatialIndex.h"
+
+namespace Dojo {
+
+	///A LooseQuadtree indexes the elements of a 2D layer on the XY plane
+	/**
+	Each cell reaches out twice its size, so an element always lives in the single cell that contains its center
+	at the depth matching its size; moving an element is just relinking it when it changes cell.
+	The root grows to fit the elements that fall out of it, so the world doesn't need to be known in advance.
+	*/
+	class LooseQuadtree : public SpatialIndex {
+	public:
+		///how many times a cell can be split
+		static const int MaxDepth = 10;
+
+		LooseQuadtree();
+
+		virtual Proxy insert(Renderable& r, const AABB& bounds) override;
+		virtual void move(Proxy proxy, const AABB& bounds) override;
+		virtual void remove(Proxy proxy) override;
+		virtual void query(const BoundsTest& test, const Visitor& visit) const override;
+
+		virtual size_t size() const override {
+			return mElementCount;
+		}
+
+	protected:
+		static const int Null = -1;
+
+		struct Cell {
+			Vector center;
+			float halfSize;
+			int depth;
+			std::array<int, 4> children = { { Null, Null, Null, Null } };
+			int firstElement = Null;
+		};
+
+		struct Element {
+			AABB bounds;
+			Renderable* renderable = nullptr;
+			int cell = Null;
+			int prev = Null, next = Null; //next doubles as the next free element
+		};
+
+		std::vector<Cell> mCells;
+		std::vector<Element> mElements;
+		int mFreeElements = Null;
+		size_t mElementCount = 0;
+
+		//the z range of all the elements ever inserted, as the cells don't split on z
+		float mMinZ = FLT_MAX, mMaxZ = -FLT_MAX;
+
+		int _findCell(const AABB& bounds, bool create);
+		void _link(int element, int cell);
+		void _unlink(int element);
+		void _growToFit(const AABB& bounds);
+
+		void _query(int cell, const BoundsTest& test, const Visitor& visit) const;
+	};
+}
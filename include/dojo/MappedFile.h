@@ -0,0 +1,52 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	///A MappedFile maps a whole file read-only in memory, so that it's read from the disk only when its pages are used
+	/**
+	The data is valid as long as the MappedFile exists. When the file can't be mapped, it's read in a buffer instead.
+	*/
+	class MappedFile {
+	public:
+		explicit MappedFile(utf::string_view path);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile();
+
+		///tells if the file was found and isn't empty
+		bool isValid() const {
+			return mSize > 0;
+		}
+
+		///tells if the data is a mapping of the file rather than a copy
+		bool isMapped() const {
+			return mMapped;
+		}
+
+		const uint8_t* getData() const {
+			return mData;
+		}
+
+		size_t getSize() const {
+			return mSize;
+		}
+
+		///reads the pages of a range on the calling thread, so that using them later doesn't wait for the disk
+		void prefetch(size_t offset, size_t size) const;
+
+	protected:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		bool mMapped = false;
+
+		std::vector<uint8_t> mBuffer;
+
+#ifdef PLATFORM_WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#endif
+	};
+}
@@ -16,11 +16,13 @@
 #include "VertexField.h"
 #include "PrimitiveMode.h"
 #include "AABB.h"
+#include "MeshOptimizer.h"
 
 namespace Dojo {
 	class Color;
 	class ResourceGroup;
 	class Shader;
+	class MeshPack;
 
 	///A Mesh is the only primitive Dojo can render.
 	/**
@@ -33,12 +35,24 @@ namespace Dojo {
 	and specifying vertex features using color(), normal() and uv() methods.
 
 	Calling end() is required before the mesh can be used, so that its data is loaded to the GPU.
+
+	A Mesh can own a chain of lower detail versions of itself, its LODs: 3D layers draw the LOD that fits the size of each Renderable on screen.
+	LOD 0 is the Mesh itself.
 	*/
 	class Mesh : public Resource {
 	public:
 		static bool gBufferBindingsDirty;
 		typedef unsigned int IndexType;
 
+		///counts the VAOs reused and created by bindVertexArray(), the Renderer reads and resets them every frame
+		static uint32_t gVertexArrayHits, gVertexArrayMisses;
+
+		///how many VAOs a Mesh keeps, one for each vertex layout it was last drawn with
+		static const int MAX_VERTEX_ARRAYS = 4;
+
+		///returns how many bytes a VertexField takes in each vertex
+		static uint8_t getVertexFieldSize(VertexField f, bool positionQuantized = false);
+
 		static const int VERTEX_PAGE_SIZE = 256;
 		static const int INDEX_PAGE_SIZE = 256;
 
@@ -48,6 +62,9 @@ namespace Dojo {
 		///Creates a new Mesh bound to the file at filePath
 		Mesh(optional_ref<ResourceGroup> creator, utf::string_view filePath);
 
+		///Creates a new Mesh bound to an entry of a MeshPack, that is uploaded straight from the mapped pack
+		Mesh(optional_ref<ResourceGroup> creator, std::shared_ptr<MeshPack> pack, uint32_t entry);
+
 		virtual ~Mesh();
 
 		///frees all CPU-side memory (done automatically on static meshes)
@@ -66,18 +83,49 @@ namespace Dojo {
 		void setVertexFields(const std::initializer_list<VertexField>& fs);
 
 		///A dynamic mesh set as dynamic won't clear its CPU cache when loaded, allowing for quick editing
+		/**
+		Dynamic meshes keep their own GL buffers, and each end() respecifies them whole with glBufferData so that the driver
+		can orphan the old storage. They aren't sub-allocated from the streaming rings on purpose: the rings recycle their
+		data every frame, while a dynamic mesh such as a TextArea is usually drawn unchanged for many frames.
+		Meshes that are rebuilt every frame should use setStreaming instead.
+		*/
 		void setDynamic(bool d);
 
 		bool isDynamic() const {
 			return dynamic;
 		}
 
+		///A streaming mesh is a dynamic mesh that end() writes to the Renderer's streaming rings instead of its own GL buffers
+		/**
+		This avoids reallocating the buffers of meshes that are rebuilt every frame, such as sprite batches;
+		meshes that are drawn unchanged for many frames, like most text, should stay plain dynamic meshes.
+		The ring only keeps the data for the frame it was written in, so a streaming mesh that is drawn again in a later frame
+		copies its CPU data to the ring once more.
+		Without a ring (no GLES3-class context) it falls back to a dynamic mesh.
+		*/
+		void setStreaming(bool s);
+
+		///starts rewriting a streaming mesh with vertexCount unindexed vertices, written straight in the Renderer's vertex ring
+		/**
+		\returns where to write the vertices in the format of this mesh, or nullptr if there is no ring big enough:
+		then the mesh has to be built with begin() as usual.
+		The vertices aren't kept on the CPU, so the mesh can only be drawn until the ring is fenced, ie. in the same frame.
+		*/
+		void* beginStream(IndexType vertexCount);
+
+		///ends the writes started by beginStream(), the vertices can be drawn from now on
+		bool endStream();
+
+		bool isStreaming() const {
+			return streaming;
+		}
+
 		///Sets the primitive for the rendering of this mesh
 		void setTriangleMode(PrimitiveMode m) {
 			triangleMode = m;
 		}
 
-		PrimitiveMode getTriangleMode() {
+		PrimitiveMode getTriangleMode() const {
 			return triangleMode;
 		}
 
@@ -93,6 +141,33 @@ namespace Dojo {
 			return center;
 		}
 
+		///adds a lower detail version of this Mesh, drawn when the Renderable covers less than screenSize of the viewport's height
+		/**
+		LODs are added from the most to the least detailed, so screenSize must be smaller than the one of the previous LOD.
+		*/
+		void addLOD(Unique<Mesh> lod, float screenSize);
+
+		///returns how many LODs this Mesh has, counting itself as LOD 0
+		uint32_t getLODCount() const {
+			return 1 + (uint32_t)mLODs.size();
+		}
+
+		Mesh& getLOD(uint32_t lod) {
+			return lod == 0 ? self : *mLODs[lod - 1].mesh;
+		}
+
+		///returns the screen size under which the given LOD is used, LOD 0 is used at any size
+		float getLODScreenSize(uint32_t lod) const {
+			return lod == 0 ? FLT_MAX : mLODs[lod - 1].screenSize;
+		}
+
+		///returns the LOD to draw at the given screen size
+		/**
+		\param currentLOD the LOD drawn last time
+		\param hysteresis how far, relative to the thresholds, the size has to go past a threshold before switching away from currentLOD
+		*/
+		uint32_t selectLOD(float screenSize, uint32_t currentLOD = 0, float hysteresis = 0.f) const;
+
 		bool hasVertexTransparency() const {
 			return vertexTransparency;
 		}
@@ -158,6 +233,9 @@ namespace Dojo {
 		//Removes the given vertices from the mesh
 		void cutSection(IndexType i1, IndexType i2);
 
+		///reads the file passed in the constructor, leaving the upload to onLoad
+		virtual void onPrepare() override;
+
 		///loads the whole file passed in the constructor
 		virtual bool onLoad() override;
 
@@ -169,6 +247,14 @@ namespace Dojo {
 		///binds the attribute arrays and the Buffer Objects required to render the mesh
 		void bindVertexFormat(const Shader& shader);
 
+		///binds a VAO that holds the buffers of the mesh in the vertex format of the shader, creating it the first time
+		/**
+		The VAOs depend only on the attribute locations, see Shader::getVertexLayout, so Shaders with the same layout share them
+		and a reloaded Shader finds them again.
+		Streamed meshes move around the streaming rings, so they specify their format again on the Renderer's default VAO.
+		*/
+		void bindVertexArray(const Shader& shader);
+
 
 		bool isIndexed() const {
 			return not indices.empty() or indexHandle;
@@ -178,6 +264,11 @@ namespace Dojo {
 			return indexGLType;
 		}
 
+		///returns where the indices start in the bound index buffer
+		uintptr_t getIndexByteOffset() const {
+			return streamed ? streamIndexOffset : 0;
+		}
+
 		bool isVertexFieldEnabled(VertexField f) const {
 			return vertexFieldOffset[(unsigned char)f] != 0xff;
 		}
@@ -195,6 +286,10 @@ namespace Dojo {
 
 		Vector& getVertex(int idx);
 
+		const Vector& getVertex(int idx) const {
+			return const_cast<Mesh&>(self).getVertex(idx);
+		}
+
 		IndexType getIndex(int idxidx) const;
 
 		void eraseIndex(int idxidx);
@@ -203,6 +298,30 @@ namespace Dojo {
 
 		bool supportsShader(const Shader& shader) const;
 
+		///reorders the triangles and vertices of the mesh being edited for the vertex cache, overdraw and vertex fetch, see MeshOptimizer
+		/**
+		Call it before end(); only indexed triangle lists are reordered.
+		With quantizePositions, Position3D is stored as normalized 16 bit integers in the bounds of the mesh:
+		the Shaders drawing it must then compute the position as POSITION.xyz * POSITION_SCALE + POSITION_OFFSET.
+		A quantized mesh can't be edited anymore.
+		\returns the ACMR before and after
+		*/
+		MeshOptimizer::Report optimize(bool quantizePositions = false);
+
+		bool isPositionQuantized() const {
+			return positionQuantized;
+		}
+
+		///returns the scale that turns the stored positions into model space, the size of the bounds if quantized or 1
+		const Vector& getPositionScale() const {
+			return positionScale;
+		}
+
+		///returns the offset that turns the stored positions into model space, the bottom corner of the bounds if quantized or 0
+		const Vector& getPositionOffset() const {
+			return positionOffset;
+		}
+
 		///Creates a new empty mesh with the same format of this one
 		Unique<Mesh> cloneWithSameFormat() const;
 
@@ -210,6 +329,18 @@ namespace Dojo {
 		Unique<Mesh> cloneFromSlice(IndexType vertexStart, IndexType vertexEnd, const Vector& offset = Vector::Zero) const;
 
 	private:
+		friend class MeshPack;
+
+		struct LOD {
+			Unique<Mesh> mesh;
+			float screenSize;
+		};
+
+		std::vector<LOD> mLODs;
+
+		//the LODs read from the file, that wait for onLoad to be uploaded
+		std::vector<LOD> mReadLODs;
+
 		Vector center, dimensions;
 		AABB bounds;
 
@@ -222,8 +353,19 @@ namespace Dojo {
 		uint32_t indexGLType = 0;
 		std::vector<uint8_t> indices;//indices have varying size
 
+		std::shared_ptr<MeshPack> mPack;
+		uint32_t mPackEntry = 0;
+
 		uint32_t vertexHandle = 0, indexHandle = 0;
 
+		struct VertexArray {
+			uint64_t layout;
+			uint32_t handle;
+		};
+
+		//the most recently used first
+		std::vector<VertexArray> mVertexArrays;
+
 		int vertexCount = 0, indexCount = 0;
 
 		std::array<uintptr_t, enum_cast(VertexField::_Count)> vertexFieldOffset;
@@ -231,11 +373,51 @@ namespace Dojo {
 		PrimitiveMode triangleMode = PrimitiveMode::TriangleStrip;
 
 		bool dynamic = false;
+		bool streaming = false, streamed = false;
 		bool editing = false;
 		bool vertexTransparency = false;
 
+		bool positionQuantized = false;
+		Vector positionScale = Vector::One, positionOffset = Vector::Zero;
+
+		//where the data was written in the streaming rings, and when: it's only valid until the rings are fenced again
+		uint32_t streamVertexOffset = 0, streamIndexOffset = 0;
+		uint64_t streamVertexFrame = 0, streamIndexFrame = 0;
+
 		void _prepareVertex(const Vector& v);
 
+		///leaves edit mode discarding everything written since begin(), without uploading it
+		void _abandonEdit();
+
+		void _destroyVertexArrays();
+
+		///repacks the vertices with Position3D as 4 normalized shorts
+		void _quantizePositions();
+
+		///clears the vertex format, before it's read again
+		void _resetFormat();
+
+		///reads a mesh in the cooked format, up to end() excluded
+		/**
+		\returns false if the data before bufferEnd is truncated or invalid
+		*/
+		bool _readBinary(const uint8_t*& ptr, const uint8_t* bufferEnd);
+		///reads the file with its LODs, without touching GL
+		bool _readFile();
+
+		///uploads the mesh and its LODs from the pack
+		bool _loadFromPack();
+		///sets the format of an entry of the pack and uploads its data from the mapping
+		void _loadPackEntry(const MeshPack& pack, uint32_t entry);
+
+		///creates the GL buffers if needed and fills them with the given data
+		void _uploadBuffers(const uint8_t* vertexData, size_t vertexBytes, const uint8_t* indexData, size_t indexBytes);
+
+		///copies the CPU data to the streaming rings
+		void _stream();
+		///tells if the data in the streaming rings is still the one written by the last _stream()
+		bool _isStreamValid() const;
+
 		template<class T>
 		T& _field(VertexField field, uint8_t set = 0) {
 			return *(T*)(currentVertex + vertexFieldOffset[enum_cast(field) + set]);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+
+namespace Dojo {
+
+	///MeshOptimizer reorders the triangles and vertices of indexed triangle lists so that the GPU does less work drawing them
+	/**
+	It works on plain index and vertex arrays and doesn't use GL, so it can run on the loading threads or in a cooker.
+	The passes are meant to run in this order:
+	-optimizeVertexCache() reorders the triangles with Tipsify, so that their vertices are found in the post-transform cache
+	-optimizeOverdraw() sorts clusters of those triangles from the outside in, without losing much of the cache efficiency
+	-optimizeVertexFetch() reorders the vertices by first use, so that the fetches are sequential
+
+	The efficiency of the vertex cache is measured as ACMR, the average number of vertices transformed for each triangle:
+	it's 3 when no vertex is reused, and about 0.5 for a regular grid in a perfect order.
+	*/
+	class MeshOptimizer {
+	public:
+		///the size of the FIFO cache the orders are made for, smaller than the real ones so that the order works on any GPU
+		static const uint32_t DefaultCacheSize = 16;
+
+		///the ACMR of a mesh before and after the optimization
+		struct Report {
+			float ACMRBefore = 0, ACMRAfter = 0;
+		};
+
+		///returns the average number of vertices transformed for each triangle with a FIFO cache of the given size
+		static float computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+		///reorders the triangles for the post-transform vertex cache
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+		///reorders clusters of triangles so that the ones facing outwards are drawn first and hide the others
+		/**
+		The clusters are split where the cache would be cold anyway, and then where their ACMR is within threshold times the one
+		of the whole mesh; a higher threshold makes smaller clusters that sort better, at the cost of more cache misses.
+		\param positions the position of each vertex
+		*/
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vector>& positions, float threshold = 1.05f, uint32_t cacheSize = DefaultCacheSize);
+
+		///reorders the vertices in the order the triangles use them, dropping the unused ones, and remaps the indices
+		/**
+		\returns the new vertex count
+		*/
+		static uint32_t optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<uint8_t>& vertices, uint32_t vertexSize);
+	};
+}
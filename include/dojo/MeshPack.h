@@ -0,0 +1,114 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Mesh;
+	class MappedFile;
+
+	///A MeshPack is a .meshpack file holding many meshes, that are uploaded straight from a mapping of the file
+	/**
+	The file starts with a Header and the table of contents, an Entry for each mesh, followed by the names;
+	the vertices and indices of each mesh are stored as they are uploaded, aligned to DataAlignment,
+	so loading a mesh is a single glBufferData from the mapped file, without any intermediate copy.
+
+	The LODs of a mesh are entries too, stored after their mesh by decreasing screen size.
+
+	ResourceGroup::addMeshes adds a Mesh for each entry that isn't a LOD, named as the entry.
+	The table of contents is read when the pack is created; the file is mapped again while its meshes are loaded,
+	once for all of them, see acquire().
+	*/
+	class MeshPack {
+	public:
+		static const uint32_t Version = 2;
+		static const uint32_t DataAlignment = 16;
+		static const uint32_t NotALOD = 0xffffffff;
+
+		struct Header {
+			char magic[4]; ///<"DMPK"
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t entryOffset;
+		};
+
+		///how a mesh is stored in the file; all the offsets are from the start of the file
+		struct Entry {
+			uint32_t nameOffset, nameLength;
+			uint32_t lodOf; ///<the entry this is a LOD of, or NotALOD
+			float lodScreenSize;
+			uint32_t fields; ///<a bit for each enabled VertexField
+			uint8_t indexSize, triangleMode, vertexSize, positionQuantized;
+			uint32_t vertexCount, indexCount;
+			float boundsMin[3], boundsMax[3];
+			float positionScale[3], positionOffset[3];
+			uint64_t vertexOffset, indexOffset;
+		};
+
+		///a mesh to save in a pack
+		struct Source {
+			utf::string name;
+			const Mesh* mesh;
+			///when not 0, the mesh is a LOD of the last Source that isn't one
+			float lodScreenSize;
+		};
+
+		///writes a pack with the given meshes, which must still have their data, because they are being edited or dynamic
+		static bool save(utf::string_view path, const std::vector<Source>& meshes);
+
+		///reads the table of contents of the pack at path
+		explicit MeshPack(utf::string_view path);
+
+		~MeshPack();
+
+		///tells if the table of contents was read correctly
+		bool isValid() const {
+			return mValid;
+		}
+
+		const utf::string& getPath() const {
+			return mPath;
+		}
+
+		uint32_t getEntryCount() const {
+			return (uint32_t)mEntries.size();
+		}
+
+		const Entry& getEntry(uint32_t entry) const {
+			return mEntries[entry];
+		}
+
+		const utf::string& getEntryName(uint32_t entry) const {
+			return mNames[entry];
+		}
+
+		///maps the file if it isn't already, can be called from any thread
+		/**
+		The file stays mapped until every acquire() is matched by a release().
+		\returns false if the file can't be read
+		*/
+		bool acquire();
+
+		void release();
+
+		///returns the mapped file, valid between acquire() and release()
+		const uint8_t* getData() const;
+
+		///reads the data of an entry and its LODs from the disk, on the calling thread
+		void prefetch(uint32_t entry) const;
+
+	protected:
+		utf::string mPath;
+		bool mValid = false;
+		size_t mFileSize = 0;
+
+		std::vector<Entry> mEntries;
+		std::vector<utf::string> mNames;
+
+		std::mutex mMutex;
+		uint32_t mUsers = 0;
+		Unique<MappedFile> mFile;
+
+		///validates the header and the entries of a mapped file, and copies the table of contents
+		bool _readContents(const uint8_t* data, size_t size);
+	};
+}
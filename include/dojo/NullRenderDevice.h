@@ -0,0 +1,41 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+
+	///The NullRenderDevice is a GL implementation that draws nothing, to run and profile the render path without a GPU
+	/**
+	Dojo calls GL through the function table loaded by glad, so the null device is just another implementation of that table:
+	after load(), every GL call made by the engine lands here instead of in a driver.
+	It keeps the objects and the state that the engine reads back (names, buffer storage, mapped memory, sync objects)
+	and counts the calls, but it doesn't render anything.
+
+	It reports an OpenGL ES 3.0 context with EXT_buffer_storage and EXT_disjoint_timer_query, so that the same paths as on a GPU are taken.
+	Shaders always compile and link, but they report no active attributes and uniforms.
+	*/
+	class NullRenderDevice {
+	public:
+		struct Stats {
+			uint32_t calls = 0; ///<every GL call
+			uint32_t drawCalls = 0;
+			uint32_t stateChanges = 0; ///<object bindings, capabilities, blending, culling and depth state
+			uint64_t uploadedBytes = 0; ///<the buffer and texture data passed to GL, or written to mapped buffers
+		};
+
+		///loads the null device in place of the GL functions of the current platform
+		/**
+		It has to be called before creating the Renderer, and there must be no other GL context in use.
+		\returns false if glad refused the device
+		*/
+		static bool load();
+
+		///tells if load() was called
+		static bool isLoaded();
+
+		///returns the calls made since the last resetStats()
+		static const Stats& getStats();
+
+		static void resetStats();
+	};
+}
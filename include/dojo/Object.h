@@ -15,6 +15,7 @@
 #include "SmallSet.h"
 #include "AABB.h"
 #include "RenderLayer.h"
+#include "TransformSystem.h"
 
 namespace Dojo {
 
@@ -49,9 +50,18 @@ namespace Dojo {
 
 		virtual void reset();
 
+		///counts the world transforms recomputed, the Renderer reads and resets it every frame
+		static uint32_t gTransformUpdateCount;
+
 		//forces an update of the world transform
 		void updateWorldTransform();
 
+		///updates the world transform only if the position, the rotation or the parent's world transform changed since the last update
+		/**
+		in a GameState with a TransformSystem, the world transform is recomputed by the system at the end of the GameState's loop
+		*/
+		void refreshWorldTransform();
+
 		///sets a AABB size
 		void setSize(const Vector& bbSize);
 
@@ -132,8 +142,9 @@ namespace Dojo {
 			return children.size() > 0;
 		}
 
-		const Matrix& getWorldTransform() const {
-			return mWorldTransform;
+		///returns a copy, as the TransformSystem storage moves when objects are added to it
+		Matrix getWorldTransform() const {
+			return mTransformSystem ? mTransformSystem->getWorldTransform(mTransformHandle) : mWorldTransform;
 		}
 
 		Matrix getParentWorldTransform() const;
@@ -199,6 +210,15 @@ namespace Dojo {
 		virtual bool canDestroy() const;
 
 		AABB transformAABB(const AABB& local) const;
+
+		///tracks this Object and its children in the given system, under the parent if it's tracked too
+		void _joinTransformSystem(TransformSystem& system);
+
+		///stops tracking this Object and its children in their TransformSystem, they keep their last world transform
+		void _leaveTransformSystem();
+
+		///called by the TransformSystem when the entry of this Object moved
+		void _setTransformIndex(uint32_t index);
 	protected:
 
 		optional_ref<GameState> gameState;
@@ -211,6 +231,22 @@ namespace Dojo {
 
 		Matrix mWorldTransform;
 
+		//built on demand by getLocalPosition, as most objects never need it
+		mutable Matrix mInverseWorldTransform;
+		mutable bool mInverseWorldTransformDirty = true;
+
+		//what mWorldTransform was computed from, to tell when it's stale
+		Vector mTransformPosition;
+		Quaternion mTransformRotation;
+		uint32_t mTransformVersion = 0, mParentTransformVersion = 0;
+		mutable uint32_t mInverseWorldTransformVersion = 0;
+
+		//the system that owns the world transform, if any
+		TransformSystem* mTransformSystem = nullptr;
+		TransformSystem::Handle mTransformHandle;
+
+		bool _isWorldTransformDirty() const;
+
 		bool active;
 		
 		optional_ref<Object> parent;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "AABB.h"
+
+namespace Dojo {
+	class Mesh;
+
+	///An OcclusionBuffer is a small software depth buffer, used to skip the elements hidden behind big occluders
+	/**
+	Occluder meshes are rasterized on the CPU at low resolution, each triangle at the depth of its farthest vertex so that
+	the buffer never claims more than the real geometry hides. buildHierarchy() then builds a hierarchical-Z chain where each
+	texel keeps the farthest depth of the 4 below it, so a box is tested against a couple of texels whatever its size on screen.
+
+	It doesn't use GL, so it can run on any thread; a single buffer must be used by one thread at a time.
+	*/
+	class OcclusionBuffer {
+	public:
+		static const uint32_t DefaultWidth = 256, DefaultHeight = 128;
+
+		///creates a buffer of the given size, the width is rounded up to a multiple of 4
+		OcclusionBuffer(uint32_t width = DefaultWidth, uint32_t height = DefaultHeight);
+
+		///resets the buffer to the far plane
+		void clear();
+
+		///rasterizes the triangles of an occluder, which must be a dynamic triangle list or strip with positions
+		void drawMesh(const Mesh& mesh, const Matrix& worldViewProjection);
+
+		///rasterizes a triangle given in clip space, only in the texels it covers entirely; triangles crossing the near plane are skipped
+		void drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+		///builds the hierarchical-Z chain from the rasterized depth, needed before testing
+		void buildHierarchy();
+
+		///tells if any part of a world space box might be in front of the occluders
+		bool isVisible(const AABB& bounds, const Matrix& viewProjection) const;
+
+		uint32_t getLevelCount() const {
+			return (uint32_t)mLevels.size();
+		}
+
+		uint32_t getWidth(uint32_t level = 0) const {
+			return mLevels[level].width;
+		}
+
+		uint32_t getHeight(uint32_t level = 0) const {
+			return mLevels[level].height;
+		}
+
+		///returns the depth stored in a texel, from 0 at the near plane to 1 at the far plane
+		float getDepth(uint32_t x, uint32_t y, uint32_t level = 0) const {
+			return mLevels[level].depth[y * mLevels[level].width + x];
+		}
+
+	protected:
+		struct Level {
+			uint32_t width, height;
+			std::vector<float> depth;
+		};
+
+		std::vector<Level> mLevels;
+
+		//the clip space vertices of the mesh being drawn
+		std::vector<glm::vec4> mClipVertices;
+	};
+}
@@ -12,6 +12,25 @@ namespace Dojo {
 		R_8,
 		RG_8,
 		A_8, //same as R_8, but counts as transparent
+
+		//block compressed formats, they can only be loaded from a TextureContainer
+		BC1_RGBA,
+		BC1_RGBA_SRGB,
+		BC3_RGBA,
+		BC3_RGBA_SRGB,
+		BC4_R,
+		BC5_RG,
+		BC7_RGBA,
+		BC7_RGBA_SRGB,
+		ETC2_RGB,
+		ETC2_RGB_SRGB,
+		ETC2_RGBA,
+		ETC2_RGBA_SRGB,
+		EAC_R,
+		EAC_RG,
+		ASTC_4x4_RGBA,
+		ASTC_4x4_RGBA_SRGB,
+
 		Unknown
 	};
 }
@@ -3,6 +3,7 @@
 #include "dojo_common_header.h"
 
 #include "SmallSet.h"
+#include "SpatialIndex.h"
 
 #include "PseudoEnum.h"
 
@@ -23,16 +24,60 @@ namespace Dojo {
 			depthWrite = false,
 			orthographic = true;
 
+		///if true, the visible elements are drawn sorted by render state and depth instead of in insertion order
+		/**
+		Opaque elements are grouped by render state only on layers with depthTest; translucent elements, and every element
+		of layers without it, are drawn back to front, in insertion order at the same depth.
+		*/
+		bool sortElements = false;
+
+		///if true, consecutive sprites from the same atlas are merged in a single draw call, see SpriteBatcher
+		/**
+		only applies to orthographic layers that don't use depth
+		*/
+		bool batchSprites = true;
+
 		void make3D() {
 			depthTest = true;
 			depthWrite = true;
 			orthographic = false;
 		}
 
+		///if true, 3D layers skip the elements hidden behind the occluders of the layer, see Renderable::setOccluderMesh
+		/**
+		the occluders are rasterized in a small OcclusionBuffer for each Viewport that draws the layer, then every element is tested against it.
+		It pays off when a few big occluders hide many elements, eg. walls and buildings.
+		*/
+		bool occlusionCulling = false;
+
 		float zOffset = 0.f;
 		
+		///the elements, while the Renderer updates them a removed element leaves a null in its slot until the end of the pass
 		SmallSet<Renderable*> elements;
-		bool elementsChangedThisFrame = false;
+
+		///the elements added while the Renderer was updating, they join elements at the end of the pass
+		std::vector<Renderable*> addedElements;
+		bool hasRemovedElements = false;
+
+		///if not null, the elements are culled through this index instead of one by one
+		Unique<SpatialIndex> spatialIndex;
+
+		///creates a spatial index over the elements, so that culling only looks at the ones around the Viewport
+		/**
+		orthographic layers get a LooseQuadtree and the others an AABBTree, so enable it after choosing the projection.
+		It pays off on big layers where most elements are off-screen, while a linear scan is faster when most of them are visible.
+		Layers that don't sort their elements are drawn in the order they were added to the index.
+		*/
+		void enableSpatialIndex();
+
+		void disableSpatialIndex();
+
+		void _onElementAdded(Renderable& r);
+		void _onElementRemoved(Renderable& r);
+		void _onElementMoved(Renderable& r);
+
+		///stores in each element from the given one onwards its position in elements, so that the index can report them in order
+		void _updateSlots(size_t first);
 
 		bool usesDepth() const {
 			return depthWrite or depthTest;
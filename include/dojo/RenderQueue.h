@@ -0,0 +1,78 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+#include "RenderLayer.h"
+#include "BoundsMath.h"
+#include "OcclusionBuffer.h"
+
+namespace Dojo {
+	class Renderable;
+	class Mesh;
+	class Shader;
+	class Texture;
+	class Viewport;
+
+	///A DrawPacket is a single Renderable ready to be submitted, with all of its per-draw data already resolved
+	struct DrawPacket {
+		uint64_t key; ///<the sort key, the packets of a queue are drawn in ascending order
+		uint64_t state; ///<the part of the key that identifies shader, textures, mesh and blending
+		uint32_t index; ///<the position of the Renderable in its layer, to keep the sort stable
+
+		Renderable* renderable;
+		Mesh* mesh;
+		Shader* shader;
+		std::array<Texture*, DOJO_MAX_TEXTURES> textures;
+		bool blending;
+
+		Matrix world, worldView, worldViewProjection;
+
+		bool operator<(const DrawPacket& other) const {
+			return key < other.key or (key == other.key and index < other.index);
+		}
+	};
+
+	///A RenderQueue is the flat list of what a Viewport sees of a RenderLayer
+	/**
+	The queues of a frame are built in parallel on worker threads, as building only reads the scene:
+	each layer is culled and packed in fixed size chunks, so the work spreads evenly even when one layer holds most elements.
+	Then they are replayed in order on the GL thread, which doesn't need to look at the scene anymore.
+	*/
+	struct RenderQueue {
+		Viewport* viewport = nullptr;
+		RenderLayer::ID layerID = RenderLayer::InvalidID;
+		const RenderLayer* layer = nullptr;
+
+		Matrix view, projection, viewProjection;
+		float zFar = 1.f;
+
+		///the vertical scale of the perspective projection, used to pick LODs; 0 on orthographic layers, that don't use them
+		float lodScale = 0.f;
+
+		///the height of the viewport in pixels, used to request the mips of streamed textures; 0 when textures aren't streamed
+		float pixelHeight = 0.f;
+
+		///an element that passed culling, with its position in the draw order of the layer
+		struct VisibleElement {
+			Renderable* renderable;
+			uint32_t index;
+		};
+
+		///the layer elements that passed culling, written in place by each cull chunk
+		std::vector<VisibleElement> visible;
+
+		///the world bounds of the candidates of 3D layers and the ones that passed, to cull them in bulk
+		AABBArray bounds;
+		std::vector<uint32_t> inFrustum;
+
+		///the occluders seen by the viewport, when the layer uses occlusion culling
+		Unique<OcclusionBuffer> occlusion;
+		bool occlusionEnabled = false;
+
+		std::vector<DrawPacket> packets;
+
+		int stateChanges = 0;
+		int stateChangesAvoided = 0;
+	};
+}
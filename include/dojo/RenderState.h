@@ -83,6 +83,16 @@ namespace Dojo {
 			return mesh;
 		}
 
+		///returns the Mesh that is drawn, which is one of the LODs of getMesh() in 3D layers
+		optional_ref<Mesh> getDrawnMesh() const {
+			return mDrawnMesh.is_some() ? mDrawnMesh : mesh;
+		}
+
+		///sets the LOD of the Mesh to draw, called by the Renderer
+		void _setDrawnMesh(optional_ref<Mesh> m) {
+			mDrawnMesh = m;
+		}
+
 		///returns the Shader currently bound to this state
 		optional_ref<Shader> getShader() const {
 			return mShader;
@@ -92,21 +102,27 @@ namespace Dojo {
 			return mTransform;
 		}
 
+		const GLBlend& getBlending() const {
+			return blending;
+		}
+
+		///tells if this state sets up exactly the same GL state as other, so that both can be drawn in a single instanced call
+		bool canBeInstancedWith(const RenderState& other) const;
+
 		void apply(const GlobalUniformData& currentState, optional_ref<const RenderState> lastState) const;
 
 	protected:
 		GLBlend blending;
 
-		optional_ref<Mesh> mesh;
+		optional_ref<Mesh> mesh, mDrawnMesh;
 		optional_ref<Shader> mShader;
 		std::array<optional_ref<Texture>, DOJO_MAX_TEXTURES> textures;
 		uint8_t maxTextureSlots = 0;
-		bool mTransparency = false;
 
 		Matrix mTransform;
 
 		void _bindTextureSlot(int i);
 
-		void _updateTransparency();
+		bool _hasTransparency() const;
 	};
 }
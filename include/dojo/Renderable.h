@@ -31,6 +31,9 @@ namespace Dojo {
 		Vector uvOffset;
 		Vector scale = Vector::One;
 
+		///how far the screen size has to go past a LOD threshold before switching LOD, relative to the threshold, see Mesh::selectLOD
+		float lodHysteresis = 0.1f;
+
 		Renderable(Object& parent, RenderLayer::ID layer);
 
 		Renderable(Object& parent, RenderLayer::ID layer, Mesh& m, Shader& shader);
@@ -85,6 +88,44 @@ namespace Dojo {
 
 		virtual void onAttach() override;
 		virtual void onDetach() override;
+
+		///sets a Mesh that hides what's behind this Renderable, in layers with occlusion culling
+		/**
+		it should be a simple closed shape that fits inside the rendered Mesh, eg. the box inside a building; the rendered Mesh can be used too.
+		It's rasterized on the CPU, so it must be dynamic to keep its vertices after end().
+		*/
+		void setOccluderMesh(optional_ref<Mesh> mesh);
+
+		optional_ref<Mesh> getOccluderMesh() const {
+			return mOccluderMesh;
+		}
+
+		///returns the LOD of the Mesh drawn last
+		uint32_t getLOD() const {
+			return mLOD.load(std::memory_order_relaxed);
+		}
+
+		void _setLOD(uint32_t lod) {
+			mLOD.store((uint8_t)lod, std::memory_order_relaxed);
+		}
+
+		SpatialIndex::Proxy _getSpatialProxy() const {
+			return mSpatialProxy;
+		}
+
+		void _setSpatialProxy(SpatialIndex::Proxy proxy) {
+			mSpatialProxy = proxy;
+		}
+
+		///the position of this Renderable in the elements of its layer, only kept up to date on layers with a spatial index
+		uint32_t _getLayerSlot() const {
+			return mLayerSlot;
+		}
+
+		void _setLayerSlot(uint32_t slot) {
+			mLayerSlot = slot;
+		}
+
 	protected:
 
 		bool visible = true;
@@ -98,5 +139,13 @@ namespace Dojo {
 		Color fadeEndColor;
 
 		AABB mWorldBB, mLastMeshBB;
+
+		SpatialIndex::Proxy mSpatialProxy = SpatialIndex::InvalidProxy;
+		uint32_t mLayerSlot = 0;
+
+		optional_ref<Mesh> mOccluderMesh;
+
+		//written by the culling workers, possibly by more than one viewport at once
+		std::atomic<uint8_t> mLOD = { 0 };
 	};
 }
@@ -14,6 +14,7 @@
 #include "RenderLayer.h"
 #include "GlobalUniformData.h"
 #include "RenderSurface.h"
+#include "RenderQueue.h"
 
 namespace Dojo {
 
@@ -24,6 +25,10 @@ namespace Dojo {
 	class Mesh;
 	class Game;
 	class FrameSubmitter;
+	class SpriteBatcher;
+	class StreamingBuffer;
+	class GPUTimer;
+	class TextureStreamer;
 
 	class Renderer {
 	public:
@@ -89,6 +94,92 @@ namespace Dojo {
 			return frameBatchCount;
 		}
 
+		///returns how many Object world transforms were recomputed since the previous frame, static objects aren't counted
+		int getLastFrameTransformUpdateCount() {
+			return frameTransformUpdateCount;
+		}
+
+		///returns how many seconds the CPU spent updating the Renderables in the last frame
+		double getLastFrameUpdateTime() const {
+			return frameUpdateTime;
+		}
+
+		///returns how many seconds the CPU spent culling, packing and sorting the render queues in the last frame
+		double getLastFrameCullTime() const {
+			return frameCullTime;
+		}
+
+		///returns how many seconds the CPU spent submitting the queues to GL in the last frame
+		double getLastFrameSubmitTime() const {
+			return frameSubmitTime;
+		}
+
+		///tells if GPU timer queries are recorded, see the enable_GPU_timing configuration key
+		bool isGPUTimingEnabled() const {
+			return mGPUTimer != nullptr;
+		}
+
+		///returns how many milliseconds the GPU took to render the last measured frame, which lags a few frames behind
+		float getLastFrameGPUTime() const;
+
+		///returns the GPU milliseconds spent on the given Viewport in the last measured frame, or 0 if it wasn't drawn
+		float getLastViewportGPUTime(const Viewport& viewport) const;
+
+		///returns the GPU milliseconds spent on the given layer by all the viewports in the last measured frame
+		float getLastLayerGPUTime(RenderLayer::ID layerID) const;
+
+		///returns how many shader, mesh, texture and blending changes were needed to draw the last frame
+		int getLastFrameStateChangeCount() {
+			return frameStateChangeCount;
+		}
+
+		///returns how many state changes sorting the layers saved compared to drawing them in insertion order
+		int getLastFrameStateChangesAvoided() {
+			return frameStateChangesAvoided;
+		}
+
+		///returns how many elements passed frustum culling but were hidden by occluders in the last frame
+		int getLastFrameOccludedCount() {
+			return frameOccludedCount;
+		}
+
+		///returns how many times the streaming rings wrapped around during the last frame
+		int getLastFrameStreamingWraps() {
+			return frameStreamingWraps;
+		}
+
+		///returns how many times writing to the streaming rings had to wait for the GPU during the last frame
+		int getLastFrameStreamingFenceWaits() {
+			return frameStreamingFenceWaits;
+		}
+
+		///returns how many times a Mesh found its VAO for the Shader it was drawn with since the previous frame
+		int getLastFrameVertexArrayHits() {
+			return frameVertexArrayHits;
+		}
+
+		///returns how many VAOs the Meshes had to create since the previous frame
+		int getLastFrameVertexArrayMisses() {
+			return frameVertexArrayMisses;
+		}
+
+		///binds the VAO that streamed Meshes draw with; it's also bound while index buffers are written, so that no Mesh's VAO is changed
+		void bindDefaultVertexArray();
+
+		///returns the texture bound in place of the ones that are still loading in the background
+		Texture& getPlaceholderTexture() {
+			return *mPlaceholderTexture;
+		}
+
+		///returns the TextureStreamer that manages the mips of the loaded textures, if texture streaming is enabled
+		optional_ref<TextureStreamer> getTextureStreamer();
+
+		///returns the ring that streaming Meshes write their vertices to, if the context supports it
+		optional_ref<StreamingBuffer> getVertexStream();
+
+		///returns the ring that streaming Meshes write their indices to, if the context supports it
+		optional_ref<StreamingBuffer> getIndexStream();
+
 		bool isValid() {
 			return valid;
 		}
@@ -99,6 +190,19 @@ namespace Dojo {
 		void endFrame();
 
 	private:
+		///a slice of the elements of a queue's layer, culled and packed by a single task
+		struct CullChunk {
+			uint32_t queue;
+			uint32_t begin, end;
+			uint32_t visibleCount, packetOffset;
+			uint32_t occludedCount;
+		};
+
+		///the per-instance data read by the INSTANCE_WORLD and INSTANCE_COLOR attributes
+		struct InstanceData {
+			Matrix world;
+			Color color;
+		};
 
 		bool valid;
 
@@ -112,19 +216,94 @@ namespace Dojo {
 		optional_ref<const RenderState> lastRenderState;
 
 		int frameVertexCount, frameTriCount, frameBatchCount;
+		int frameStateChangeCount, frameStateChangesAvoided;
+		int frameStreamingWraps = 0, frameStreamingFenceWaits = 0;
+		int frameTransformUpdateCount = 0;
+		int frameOccludedCount = 0;
+		int frameVertexArrayHits = 0, frameVertexArrayMisses = 0;
+		double frameUpdateTime = 0, frameCullTime = 0, frameSubmitTime = 0;
+
+		//the queues are reused every frame so that their packet arrays keep their capacity
+		std::vector<RenderQueue> mQueues;
+		size_t mQueueCount = 0;
+
+		std::vector<CullChunk> mCullChunks;
+
+		uint32_t mInstanceBuffer = 0;
+		uint32_t mDefaultVAO = 0;
+		std::vector<InstanceData> mInstanceData;
+
+		Unique<SpriteBatcher> mSpriteBatcher;
+
+		//the ring the uniform blocks are streamed to, null when the context has no uniform buffers
+		Unique<StreamingBuffer> mUniformRing;
+		ViewUniformBlock mLastViewBlock;
+		bool mViewBlockUploaded = false;
+
+		//the rings streaming Meshes are written to, null when buffers can't be mapped
+		Unique<StreamingBuffer> mVertexRing, mIndexRing;
+
+		//null when GPU timing is unsupported or disabled
+		Unique<GPUTimer> mGPUTimer;
+
+		//null unless a texture VRAM budget is configured
+		Unique<TextureStreamer> mTextureStreamer;
+
+		Unique<Texture> mPlaceholderTexture;
 
 		bool frameStarted;
 
+		//true during _updateRenderables, when the layers defer their additions and removals
+		bool mUpdatingRenderables = false;
+
 		LayerList layers;
 
 		Matrix mRenderRotation;
 
+		///updates every Renderable once, then applies the additions and removals they made
 		void _updateRenderables(LayerList& layers, float dt);
+		///updates an element by index, as an update can reallocate the layers and null earlier elements
+		void _updateElement(LayerList& layers, size_t layerIdx, size_t elementIdx, float dt);
 
-		///renders a single element using the given viewport
+		///draws a RenderState with the given world matrices already loaded in globalUniforms
+		void _draw(const RenderState& renderState);
+		///renders a single element using the world transform of the given RenderState
 		void _renderElement(const RenderLayer& layer, const RenderState& renderState);
-		void _renderLayer(Viewport& viewport, const RenderLayer& layer);
-		void _renderViewport(Viewport& viewport);
+		///makes the Renderable of a packet draw the LOD selected for it
+		void _useLOD(const DrawPacket& packet);
+		///renders a single packet using its resolved matrices
+		void _renderPacket(const DrawPacket& packet);
+		///renders a run of compatible elements with an instanced Shader in a single draw call
+		void _renderInstanced(const RenderLayer& layer, const DrawPacket* begin, const DrawPacket* end);
+		///renders a run of sprites sharing the same atlas as a single batch
+		void _renderSpriteBatch(const RenderLayer& layer, const DrawPacket* begin, const DrawPacket* end);
+
+		///lists the queues and the cull chunks needed by the viewports for this frame, on the main thread
+		void _prepareQueues();
+
+		//the build stage only reads the scene, so these run on any thread
+		///culls a chunk of elements, writing the visible ones in place in the queue's visible list
+		void _cullChunk(CullChunk& chunk);
+		///draws the occluders that passed culling in the queue's OcclusionBuffer
+		void _drawOccluders(RenderQueue& queue, uint32_t queueIdx);
+		///removes the elements hidden by occluders from a chunk's visible list
+		void _occludeChunk(CullChunk& chunk);
+		///resolves the packets of the visible elements of a chunk
+		void _packChunk(const CullChunk& chunk);
+		///sorts the packets of a queue
+		void _sortQueue(RenderQueue& queue);
+		///replays a built queue on the GL thread
+		void _submitQueue(const RenderQueue& queue);
+		void _beginViewport(Viewport& viewport);
+		void _endViewport(Viewport& viewport);
+
+		///uploads and binds the VIEW_UNIFORMS block from globalUniforms, unless it didn't change
+		void _uploadViewUniforms();
+		///streams and binds the DRAW_UNIFORMS block for a draw, if its Shader uses it
+		void _uploadDrawUniforms(const RenderState& renderState);
+
+		///fences all the streaming rings at the end of the frame and collects their stats
+		void _fenceStreams();
 
 	};
 }
@@ -20,6 +20,7 @@ namespace Dojo {
 		Resource(optional_ref<ResourceGroup> group = {}) :
 			creator(group),
 			loaded(false),
+			prepared(false),
 			size(0) {
 
 		}
@@ -27,6 +28,7 @@ namespace Dojo {
 		Resource(optional_ref<ResourceGroup> group, utf::string_view path) :
 			creator(group),
 			loaded(false),
+			prepared(false),
 			size(0),
 			filePath(path.copy()) {
 			DEBUG_ASSERT( path.not_empty(), "The file path is empty" );
@@ -37,6 +39,13 @@ namespace Dojo {
 			DEBUG_ASSERT( loaded == false, "A Resource was destroyed without being unloaded before (resource leak!)" );
 		}
 
+		///does the part of the loading that doesn't need the main thread, like reading and decoding the files
+		/**
+		A ResourceLoader calls it on a worker before onLoad(), that then only finishes the loading on the main thread.
+		It must not use GL nor the other Resources. The default does nothing and leaves all the work to onLoad()
+		*/
+		virtual void onPrepare() {}
+
 		virtual bool onLoad() = 0;
 		virtual void onUnload(bool soft = false) = 0;
 
@@ -63,6 +72,9 @@ namespace Dojo {
 	protected:
 		bool loaded;
 
+		//set by onPrepare() when onLoad() can use its results
+		bool prepared;
+
 		optional_ref<ResourceGroup> creator;
 
 		int size;
@@ -18,9 +18,12 @@
 #include "Table.h"
 #include "Shader.h"
 #include "ShaderProgram.h"
+#include "AtlasPage.h"
 #include "Log.h"
 
 namespace Dojo {
+	class ResourceLoader;
+
 	///A ResourceGroup manages all of the Resources in Dojo
 	/**
 	Resources and folders are first added to a ResourceGroup via add* methods, but they are NOT loaded;
@@ -32,6 +35,7 @@ namespace Dojo {
 
 	A ResourceGroup can be attached to one or more "sub" ResourceGroups to share their resources. */
 	class ResourceGroup {
+		friend class ResourceLoader;
 	public:
 
 		enum class ResourceType {
@@ -49,6 +53,21 @@ namespace Dojo {
 		//various resource properties TODO: refactor
 		bool disableBilinear, disableMipmaps, disableTiling, logchanges = true;
 
+		///loads the textures of the FrameSets in the background, see Texture::loadAsync
+		bool asyncTextureLoading = false;
+
+		///packs the small loose images of the FrameSets in AtlasPages when the resources are loaded
+		/**
+		The packing is cached in the app data folder, so the next launches only check the sizes of the files
+		*/
+		bool packLooseFrames = false;
+
+		///reorders the loaded Meshes for the vertex cache, overdraw and vertex fetch, see Mesh::optimize
+		bool optimizeMeshes = false;
+
+		///also quantizes the positions of the optimized Meshes, their Shaders must use POSITION_SCALE and POSITION_OFFSET
+		bool quantizeMeshPositions = false;
+
 		typedef std::map<utf::string, Unique<FrameSet>, utf::str_less> FrameSetMap;
 		typedef std::map<utf::string, Unique<Font>, utf::str_less> FontMap;
 		typedef std::map<utf::string, Unique<Mesh>, utf::str_less> MeshMap;
@@ -198,8 +217,24 @@ namespace Dojo {
 		}
 
 		///loads all the resources that are in the group but aren't loaded
+		/**
+		the files are read and decoded in parallel on the background workers, see ResourceLoader
+		*/
 		void loadResources(bool recursive = false);
 
+		///starts loading the resources that aren't loaded in the background, see ResourceLoader
+		/**
+		The files are read and decoded on the background workers, and the main thread finishes a few resources
+		each frame. The callback is called on the main thread when everything is loaded.
+		*/
+		void loadResourcesAsync(AsyncCallback onLoaded = {}, bool recursive = false);
+
+		///tells if a loadResourcesAsync() is still running
+		bool isLoading() const;
+
+		///returns the fraction of the resources loaded by the last loadResourcesAsync(), from 0 to 1
+		float getLoadingProgress() const;
+
 		///empties the group destroying all the resources
 		void unloadResources(bool recursive = false);
 
@@ -233,16 +268,16 @@ namespace Dojo {
 
 		SubgroupList subs;
 
-		///load all unloaded registered resources
-		template <class T>
-		void _load(std::map<utf::string, Unique<T>, utf::str_less>& map) {
-			for (auto&& resourcePair : map) {
-				//unload either if reloadable or if we're purging memory
-				if (not resourcePair.second->isLoaded()) {
-					resourcePair.second->onLoad();
-				}
-			}
-		}
+		std::shared_ptr<ResourceLoader> mLoader;
+
+		std::vector<Unique<AtlasPage>> mAtlasPages;
+
+		///stops a loadResourcesAsync() that is still running
+		void _cancelLoading();
+
+		///turns the loose frames that fit into tiles of new AtlasPages
+		void _packLooseFrames();
+		void _unloadAtlasPages(bool soft);
 
 		template <class T>
 		void _unload(std::map<utf::string, Unique<T>, utf::str_less>& map, bool softUnload) {
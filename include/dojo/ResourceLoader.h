@@ -0,0 +1,87 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Resource;
+	class ResourceGroup;
+
+	///A ResourceLoader loads the Resources of a ResourceGroup as a graph of jobs
+	/**
+	Each Resource that isn't loaded is a node that waits for the nodes it depends on: the tiles of an atlas wait for the
+	atlas Texture, the FrameSets for their Textures and the Shaders for the ShaderPrograms.
+	When a node is ready, Resource::onPrepare() reads and decodes its files on a worker; the prepared nodes are then
+	finished by Resource::onLoad() on the main thread, because that's where GL lives.
+
+	In the background the finishing is done in batches that take a few milliseconds each, so the frames keep going
+	and a loading screen can show getProgress().
+	*/
+	class ResourceLoader : public std::enable_shared_from_this<ResourceLoader> {
+	public:
+		///builds the graph of the Resources of the group that aren't loaded, and of its subgroups if recursive
+		ResourceLoader(ResourceGroup& group, bool recursive);
+
+		///loads all the Resources before returning, reading the files of the ready nodes in parallel
+		/**
+		\remark must be called on the main thread
+		*/
+		void loadNow();
+
+		///starts loading in the background, the callback is called on the main thread when all the Resources are done
+		/**
+		\remark the loader must be owned by a shared_ptr, its jobs keep it alive
+		*/
+		void start(AsyncCallback callback = {});
+
+		///stops a background load: it waits for the files being read, then the Resources that weren't finished stay unloaded
+		void cancel();
+
+		///returns the fraction of the Resources that are done, from 0 to 1
+		float getProgress() const;
+
+		bool isDone() const {
+			return mDoneCount == mNodes.size();
+		}
+
+	private:
+		struct Node {
+			Resource* resource;
+			uint32_t waitingFor = 0;
+			std::vector<uint32_t> dependents;
+		};
+
+		std::vector<Node> mNodes;
+		size_t mDoneCount = 0;
+
+		//the nodes that were prepared and wait for the main thread
+		std::vector<uint32_t> mPrepared;
+		bool mFinishQueued = false;
+		std::atomic<bool> mCancelled = { false };
+		uint32_t mInFlight = 0;
+
+		AsyncCallback mCallback;
+
+		static void _collectGroups(ResourceGroup& group, bool recursive, std::vector<ResourceGroup*>& groups);
+		uint32_t _addNode(Resource& resource);
+		void _addDependency(uint32_t node, uint32_t dependency);
+
+		///adds a node for each Resource of the map that isn't loaded
+		template <class T>
+		void _addAll(std::map<utf::string, Unique<T>, utf::str_less>& map, std::vector<uint32_t>* nodes = nullptr) {
+			for (auto&& pair : map) {
+				if (not pair.second->isLoaded()) {
+					auto node = _addNode(*pair.second);
+					if (nodes) {
+						nodes->push_back(node);
+					}
+				}
+			}
+		}
+
+		void _prepare(uint32_t node);
+		void _queueFinish();
+		void _finishPrepared();
+		///loads a node and collects the dependents that it made ready
+		void _finish(uint32_t node, std::vector<uint32_t>& ready);
+	};
+}
@@ -42,13 +42,41 @@ namespace Dojo {
 			BU_PROJECTION, ///<The projection matrix
 			BU_WORLDVIEW, ///<The world view matrix
 			BU_WORLDVIEWPROJ, ///<The complete transformation matrix
+			BU_VIEWPROJ, ///<The view projection matrix, to be combined with INSTANCE_WORLD in instanced shaders
 			BU_OBJECT_COLOR, ///<The object's color (vec4)
 
 			BU_VIEW_DIRECTION, ///<The current world-space direction of the view (vec3)
 
 			BU_TIME, ///<Time in seconds since the start of the program (float)
 			BU_TARGET_DIMENSION, ///<The dimensions in pixels of the currently bound target (vec2)
-			BU_TARGET_DIMENSION_INV ///<The dimension in the UV space of one pixel
+			BU_TARGET_DIMENSION_INV, ///<The dimension in the UV space of one pixel
+
+			BU_POSITION_SCALE, ///<The scale from the stored positions of the drawn mesh to model space, see Mesh::isPositionQuantized (vec3)
+			BU_POSITION_OFFSET ///<The offset from the stored positions of the drawn mesh to model space (vec3)
+		};
+
+		///A built-in instance attribute is a per-instance "attribute" that Dojo fills when drawing many Renderables with one call
+		/**
+		A Shader that declares INSTANCE_WORLD is instanced: all the compatible Renderables using it are drawn together,
+		and the world matrix and color of each of them are read from these attributes rather than from WORLD and OBJECT_COLOR
+		*/
+		enum class InstanceAttribute {
+			World, ///<The world matrix of the instance (mat4)
+			Color, ///<The object's color of the instance (vec4)
+			_Count
+		};
+
+		///A built-in uniform block is a std140 block of built-in uniforms that Dojo uploads once and binds by offset
+		/**
+		A Shader that declares a block receives its members from a uniform buffer instead of a glUniform call each;
+		VIEW_UNIFORMS is uploaded once for each layer of a Viewport, DRAW_UNIFORMS is streamed for each draw.
+		Shaders for GLES2-class contexts just don't declare them and keep using the single uniforms.
+		See ViewUniformBlock and DrawUniformBlock for the layouts.
+		*/
+		enum class UniformBlock {
+			View, ///<VIEW, PROJECTION, VIEWPROJ, VIEW_DIRECTION, TARGET_DIMENSION, TIME
+			Draw, ///<WORLD, WORLDVIEW, WORLDVIEWPROJ, OBJECT_COLOR
+			_Count
 		};
 
 		///A VertexAttribute represents a "attribute" binding in a vertex shader
@@ -94,6 +122,29 @@ namespace Dojo {
 			return mAttributes;
 		}
 
+		///returns the location of the given per-instance attribute, or -1 if the shader doesn't use it
+		int getInstanceAttributeLocation(InstanceAttribute attribute) const {
+			return mInstanceAttributeLocations[enum_cast(attribute)];
+		}
+
+		///returns a key shared by the Shaders that read the same vertex fields at the same locations, or 0 if the locations are too high to make one
+		/**
+		Meshes keep a VAO for each layout they are drawn with, see Mesh::bindVertexArray
+		*/
+		uint64_t getVertexLayout() const {
+			return mVertexLayout;
+		}
+
+		///tells if this Shader reads the given block from a uniform buffer, bound at the binding point enum_cast(block)
+		bool usesUniformBlock(UniformBlock block) const {
+			return mUniformBlocks[enum_cast(block)];
+		}
+
+		///tells if this Shader draws its Renderables with instancing, see InstanceAttribute
+		bool isInstanced() const {
+			return getInstanceAttributeLocation(InstanceAttribute::World) >= 0;
+		}
+
 		///binds the shader to the OpenGL state with the object that is using it
 		void bind() const;
 		void loadUniforms(const GlobalUniformData& currentState, const RenderState& user);
@@ -151,11 +202,15 @@ namespace Dojo {
 
 		static BuiltInUniform _getUniformForName(const std::string& name);
 		static VertexField _getAttributeForName(const std::string& name);
+		static InstanceAttribute _getInstanceAttributeForName(const std::string& name);
 
 		std::string mPreprocessorHeader;
 
 		std::vector<Uniform> mUniforms;
 		std::vector<VertexAttribute> mAttributes;
+		uint64_t mVertexLayout = 0;
+		std::array<int, enum_cast(InstanceAttribute::_Count)> mInstanceAttributeLocations;
+		std::array<bool, enum_cast(UniformBlock::_Count)> mUniformBlocks;
 
 		uint32_t mGLProgram;
 
@@ -36,6 +36,9 @@ namespace Dojo {
 		///creates a new ShaderProgram using the source of this one, concatenated with the given preprocessor header
 		Unique<ShaderProgram> cloneWithHeader(const std::string& preprocessorHeader);
 
+		///reads the source file, the compilation happens in onLoad
+		virtual void onPrepare();
+
 		virtual bool onLoad();
 		virtual void onUnload(bool soft = false);
 
@@ -47,5 +50,6 @@ namespace Dojo {
 		uint32_t mGLShader;
 
 		bool _load();
+		bool _readFile();
 	};
 }
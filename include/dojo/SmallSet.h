@@ -78,10 +78,20 @@ namespace Dojo {
 			}
 		}
 
+		///erases all the elements matching pred, keeping the others in order
+		template <class Pred>
+		void eraseIf(Pred pred) {
+			c.erase(std::remove_if(c.begin(), c.end(), pred), c.end());
+		}
+
 		T& operator[](int idx) {
 			return c[idx];
 		}
 
+		const T& operator[](int idx) const {
+			return c[idx];
+		}
+
 		iterator begin() {
 			return c.begin();
 		}
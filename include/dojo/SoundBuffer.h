@@ -71,6 +71,9 @@ namespace Dojo {
 
 		~SoundBuffer();
 
+		///reads the headers of the file, the first chunk is decoded by onLoad
+		virtual void onPrepare() override;
+
 		virtual bool onLoad() override;
 		virtual void onUnload(bool soft = false) override;
 
@@ -117,7 +120,8 @@ namespace Dojo {
 		optional_ref<Stream> mSource;
 		Unique<FileStream> mFile; //this unique ptr keeps ownership of the file accessor when the src is a file
 
-		bool _loadOgg(Stream& source);
-		bool _loadOggFromFile();
+		///splits the stream in chunks, without decoding them
+		bool _readOggHeaders(Stream& source);
+		bool _openOggFile();
 	};
 }
@@ -21,6 +21,7 @@ namespace Dojo {
 		///Creates a new set named setName
 		SoundSet(optional_ref<ResourceGroup> creator, utf::string_view setName);
 
+		virtual void onPrepare() override;
 		virtual bool onLoad() override;
 		virtual void onUnload(bool soft = true) override;
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "AABB.h"
+
+namespace Dojo {
+	class Renderable;
+
+	///A SpatialIndex finds the Renderables of a RenderLayer that might overlap a region without going through all of them
+	/**
+	Each Renderable is tracked by a Proxy, returned on insertion and stable until it's removed.
+	The index is only modified on the main thread, while queries are read-only and can run on many threads at once.
+	*/
+	class SpatialIndex {
+	public:
+		typedef uint32_t Proxy;
+		static const Proxy InvalidProxy;
+
+		///tells if a box might be visible; it's also called on the bounds of whole groups of elements, so it must be conservative
+		typedef std::function<bool(const AABB&)> BoundsTest;
+		typedef std::function<void(Renderable&, Proxy)> Visitor;
+
+		virtual ~SpatialIndex() {}
+
+		///starts tracking the Renderable with the given world bounds
+		virtual Proxy insert(Renderable& r, const AABB& bounds) = 0;
+
+		///updates the world bounds of a Renderable, cheap when it moved only a bit
+		virtual void move(Proxy proxy, const AABB& bounds) = 0;
+
+		///stops tracking a Renderable
+		virtual void remove(Proxy proxy) = 0;
+
+		///calls visit on every element that might pass the test, more elements than the ones that pass can be visited
+		virtual void query(const BoundsTest& test, const Visitor& visit) const = 0;
+
+		///returns how many Renderables are tracked
+		virtual size_t size() const = 0;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "RenderState.h"
+
+namespace Dojo {
+	class Renderable;
+	class Mesh;
+
+	///The SpriteBatcher merges runs of sprites drawn from the same atlas into a single streaming Mesh
+	/**
+	A Renderable is a sprite when its Mesh is the optimal billboard of its only Texture, as for AnimatedQuad and Sprite.
+	Sprites sharing the GL texture (ie. tiles of the same atlas), Shader, color, blending and depth are
+	pre-transformed on the CPU and appended to one vertex buffer, so that the whole run costs a single draw call.
+	*/
+	class SpriteBatcher {
+	public:
+		SpriteBatcher();
+
+		~SpriteBatcher();
+
+		///tells if this Renderable can be drawn as part of a sprite batch
+		static bool isSprite(const Renderable& r);
+
+		///tells if the two sprites can be drawn in the same batch
+		static bool canBatchTogether(const Renderable& a, const Renderable& b);
+
+		///starts a new batch of spriteCount sprites, taking the state from the first sprite
+		/**
+		the vertices are written straight in the Renderer's vertex ring when it has one, so the batch size has to be known up front
+		*/
+		void begin(const Renderable& first, uint32_t spriteCount);
+
+		///appends the quad of the given sprite to the current batch
+		void append(const Renderable& sprite);
+
+		///uploads the current batch and returns the RenderState that draws all of its sprites
+		const RenderState& end();
+
+		///returns the RenderState used to draw the batches
+		const RenderState& getRenderState() const {
+			return mState;
+		}
+
+	private:
+		class BatchState : public RenderState {
+		public:
+			void setup(const Renderable& first, Mesh& batchMesh);
+		};
+
+		struct Vertex {
+			float x, y;
+			uint32_t uv;
+		};
+
+		BatchState mState;
+		Unique<Mesh> mMesh;
+
+		//used when the batch can't be written in the vertex ring
+		std::vector<Vertex> mVertices;
+
+		Vertex* mNextVertex = nullptr;
+		Vertex* mEndVertex = nullptr;
+		bool mStreamed = false;
+	};
+}
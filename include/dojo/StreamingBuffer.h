@@ -0,0 +1,92 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+
+	///A StreamingBuffer is a GL buffer used as a ring, for data that is written by the CPU every frame and read once by the GPU
+	/**
+	Every frame appends its data after the previous one's, and a fence marks where each frame ends:
+	writing never waits for the GPU unless the ring wraps around onto data it hasn't read yet.
+	When the context supports it the buffer stays persistently mapped, otherwise each allocation maps its own range unsynchronized.
+	*/
+	class StreamingBuffer {
+	public:
+		struct Allocation {
+			void* data; ///<where to write the data, valid until unmap()
+			uint32_t offset; ///<the offset of the data in the GL buffer
+		};
+
+		///creates a ring of the given size for the given GL target, whose allocations are aligned to alignment bytes
+		StreamingBuffer(uint32_t target, uint32_t size, uint32_t alignment);
+
+		~StreamingBuffer();
+
+		///reserves size bytes in the ring and maps them, the buffer is left bound to its target
+		Allocation map(uint32_t size);
+
+		///ends the writes to the last allocation, it has to be called before drawing with it
+		void unmap();
+
+		///marks the end of the frame, the data written until now is recycled once the GPU is done with it
+		void fence();
+
+		///returns the GL handle of the buffer
+		uint32_t getGLHandle() const {
+			return mGLHandle;
+		}
+
+		uint32_t getSize() const {
+			return mSize;
+		}
+
+		bool isPersistentlyMapped() const {
+			return mPersistentData != nullptr;
+		}
+
+		///returns how many times the ring was fenced, an allocation is only valid until the next fence
+		/**
+		This is usually the frame count, but a frame that fills up the whole ring fences itself to recycle its own data
+		*/
+		uint64_t getFrame() const {
+			return mFrame;
+		}
+
+		///returns how many times the allocations went back to the start of the ring since the last resetStats()
+		uint32_t getWrapCount() const {
+			return mWrapCount;
+		}
+
+		///returns how many times an allocation had to wait for the GPU to release its range since the last resetStats()
+		uint32_t getFenceWaitCount() const {
+			return mFenceWaitCount;
+		}
+
+		void resetStats() {
+			mWrapCount = mFenceWaitCount = 0;
+		}
+
+	protected:
+		struct Fence {
+			void* sync;
+			uint32_t bytes;
+		};
+
+		uint32_t mTarget, mSize, mAlignment;
+		uint32_t mGLHandle = 0;
+		uint8_t* mPersistentData = nullptr;
+
+		uint32_t mHead = 0; ///<where the next allocation starts
+		uint32_t mUsed = 0; ///<the bytes that the GPU might still be reading, including the padding
+		uint32_t mUnfenced = 0; ///<the bytes written since the last fence
+
+		std::deque<Fence> mFences;
+		bool mMapped = false;
+
+		uint64_t mFrame = 0;
+		uint32_t mWrapCount = 0, mFenceWaitCount = 0;
+
+		void _retireSignaledFences();
+		void _waitOldestFence();
+	};
+}
@@ -147,6 +147,9 @@ namespace Dojo {
 
 		~Table();
 
+		///parses the file, Tables don't need the main thread at all
+		virtual void onPrepare() override;
+
 		virtual bool onLoad() override;
 
 		virtual void onUnload(bool soft = false) override;
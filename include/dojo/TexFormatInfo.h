@@ -14,10 +14,29 @@ namespace Dojo {
 
 		bool hasAlpha;
 
+		///compressed formats store blocks of blockWidth x blockHeight pixels in blockSize bytes, the sizes are 0 otherwise
+		uint32_t blockWidth, blockHeight;
+		size_t blockSize;
+
 		static const TexFormatInfo& getFor(PixelFormat format);
 
+		///tells if the current GL context can sample the format, compressed ones depend on its extensions
+		static bool isSupported(PixelFormat format);
+
 		bool isGPUFormat() const {
-			return glm::isPowerOfTwo(internalPixelSize);
+			return isCompressed() or glm::isPowerOfTwo(internalPixelSize);
+		}
+
+		bool isCompressed() const {
+			return blockSize > 0;
+		}
+
+		///returns the bytes taken by an image of this format
+		size_t getImageSize(uint32_t width, uint32_t height) const {
+			if (isCompressed()) {
+				return (size_t)((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * blockSize;
+			}
+			return (size_t)width * height * internalPixelSize;
 		}
 	};
 
@@ -19,12 +19,20 @@
 namespace Dojo {
 	class Mesh;
 	class FrameSet;
+	class TextureStreamer;
+	class TextureContainer;
 
 	///A Texture is the image container in Dojo; all the images to be displayed need to be loaded in GPU memory using one
 	class Texture : 
 		public RenderSurface,
 		public Resource {
 	public:
+		///returned by _takeRequestedLevel when nothing drew the texture since the last call
+		static const uint8_t NotRequested = UINT8_MAX;
+
+		///set when a GL texture is created or replaced, so that RenderState::apply binds its textures again even if they didn't change
+		static bool gBindingsDirty;
+
 		///Create a empty new texture
 		Texture(optional_ref<ResourceGroup> creator = {});
 
@@ -37,16 +45,41 @@ namespace Dojo {
 		bool loadEmpty(uint32_t width, uint32_t height, PixelFormat destFormat);
 
 		///loads the texture from a memory area with RGBA8 format
-		bool loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat sourceFormat);
+		/**
+		with mipmaps, the full chain is generated on the background workers; if the Renderer streams textures,
+		only its low mips are uploaded and the TextureStreamer takes care of the others
+		*/
+		bool loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat sourceFormat, bool mipmaps = false);
 
-		///loads the texture from the image pointed by the filename
+		///loads the texture from the image pointed by the filename, with mipmaps unless the creator disables them
+		/**
+		if the image has a compressed variant that the GPU supports, that one is loaded instead; see TextureContainer
+		*/
 		bool loadFromFile(utf::string_view path);
 
+		///uploads the compressed levels of a container as they are
+		bool loadFromContainer(const TextureContainer& container);
+
+		///starts loading the texture from its file path on the background workers
+		/**
+		The image is decoded and mipped on a worker, then copied into a pixel unpack buffer by another one; the main thread only
+		creates the buffer and uploads from it, in the callbacks of the background pool.
+		Until then the texture is pending and binds the Renderer's placeholder texture.
+		\returns false, as the texture is loaded later
+		*/
+		bool loadAsync();
+
 		///loads the texture from the given area in a Texture Atlas, without duplicating data
 		/**
 		a texture of this kind is loaded via an .atlasinfo and doesn't use VRAM in itself */
 		bool loadFromAtlas(Texture& tex, int x, int y, int sx, int sy);
 
+		///decodes and mips the image file, that onLoad then uploads
+		/**
+		Does nothing for tiles, and for the textures of groups that load them with loadAsync()
+		*/
+		virtual void onPrepare();
+
 		///loads the texture with the given parameters
 		virtual bool onLoad();
 
@@ -56,6 +89,11 @@ namespace Dojo {
 			return loaded;
 		}
 
+		///tells if the texture is being loaded in the background; it can be bound, but it shows a placeholder
+		bool isPending() const {
+			return mPending;
+		}
+
 		///internal - binds this texture as the current GL active one
 		virtual void bind(uint32_t index);
 
@@ -87,6 +125,24 @@ namespace Dojo {
 		uint32_t getInternalHeight()  const {
 			return internalHeight;
 		}
+
+		///returns how many mip levels the full chain of this texture has
+		uint8_t getLevelCount() const {
+			return mLevelCount;
+		}
+
+		///returns the most detailed mip level that is currently in VRAM
+		uint8_t getResidentLevel() const {
+			return mResidentLevel;
+		}
+
+		///returns the VRAM used by the mip chain when the given level is the most detailed one resident
+		size_t getVRAMSize(uint8_t firstLevel = 0) const;
+
+		///tells if the resident mips of this texture are managed by a TextureStreamer
+		bool isStreamed() const {
+			return mStreamer.is_some();
+		}
 		
 		///Returns a parent atlas Texture if this texture is a "fake" tile atlas
 		optional_ref<Texture> getParentAtlas() {
@@ -106,6 +162,11 @@ namespace Dojo {
 		///obtain the optimal billboard to use this texture as a sprite, when the device does not support Power of 2 Textures
 		Mesh& getOptimalBillboard();
 
+		///tells if the given mesh is the optimal billboard of this texture, without building it
+		bool isOptimalBillboard(const Mesh& m) const {
+			return OBB.get() == &m;
+		}
+
 		bool hasTransparency() const {
 			return mTransparency;
 		}
@@ -121,6 +182,26 @@ namespace Dojo {
 
 		void _addAsAttachment(uint32_t index, uint32_t width, uint32_t height, uint8_t miplevel);
 
+		///records that the texture is drawn this big on screen, in pixels; can be called from any thread
+		void _requestScreenSize(float pixels);
+
+		///returns the mip level needed by the biggest size requested since the last call, and resets it
+		uint8_t _takeRequestedLevel();
+
+		///reallocates the texture so that the given mip level is the most detailed one in VRAM
+		void _setResidentLevel(uint8_t level);
+
+		void _attachStreamer(TextureStreamer& streamer);
+
+		///stops streaming, keeping the mips that are resident
+		void _detachStreamer();
+
+		///sets the filtering and tiling asked by the creator ResourceGroup
+		void _applyCreatorSampling();
+
+		///turns an unloaded tile back into a texture that loads from its own file, before its atlas is destroyed
+		void _detachFromAtlas();
+
 	private:
 
 		bool mTransparency = false;
@@ -135,12 +216,55 @@ namespace Dojo {
 
 		uint32_t glhandle;
 
+		uint8_t mLevelCount = 1, mResidentLevel = 0;
+
+		//the sampling state is kept here, as streaming replaces the GL texture object
+		bool mBilinear = true, mTiling = true;
+		float mAnisotropy = 0;
+
+		optional_ref<TextureStreamer> mStreamer;
+
+		//the full mip chain, kept in memory while the texture is streamed
+		std::vector<std::vector<uint8_t>> mMipData;
+
+		//the biggest on-screen size requested since the streamer last looked, in pixels
+		std::atomic<float> mRequestedSize = { 0.f };
+
 		Vector screenSize;
 
+		//the state shared with the background tasks of loadAsync, that can outlive the texture
+		struct AsyncLoad;
+		std::shared_ptr<AsyncLoad> mAsyncLoad;
+		bool mPending = false;
+
+		//the image decoded by onPrepare
+		std::shared_ptr<AsyncLoad> mPreparedLoad;
+
+		//the tiles that are waiting for this atlas to finish loading
+		std::vector<Texture*> mWaitingTiles;
+
 		///builds the optimal billboard for this texture, used in AnimatedQuads
 		void _rebuildOptimalBillboard();
 
+		///rebuilds the OBB if it was already used, as the one built while the texture was pending has the placeholder UVs
+		void _updateOptimalBillboard();
+
 		bool _setupAtlas();
-		bool _createStorage(uint32_t w, uint32_t h, PixelFormat formatID);
+		bool _createStorage(uint32_t w, uint32_t h, PixelFormat formatID, uint8_t levelCount = 1);
+
+		///replaces the GL texture with an immutable one holding the levels from firstLevel to the end of the chain
+		void _allocateLevels(uint8_t firstLevel);
+		void _uploadLevel(uint8_t level, const uint8_t* data);
+		void _applyParameters();
+
+		///decodes, converts and mips the image of an AsyncLoad, on a worker
+		static void _decode(AsyncLoad& load);
+		///uploads a decoded image right away, or hands its chain to the TextureStreamer
+		bool _loadDecoded(AsyncLoad& load);
+		void _onDecoded(const std::shared_ptr<AsyncLoad>& load);
+		void _finishAsyncLoad(AsyncLoad& load);
+		///stops a pending load, its tasks will just release their data
+		void _cancelAsyncLoad();
+		void _releaseWaitingTiles();
 	};
 }
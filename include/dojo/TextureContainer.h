@@ -0,0 +1,74 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "PixelFormat.h"
+
+namespace Dojo {
+	///A TextureContainer reads the block compressed images stored in KTX2 and DDS files, with their mip chain
+	/**
+	The levels are kept as they are in the file, so that they can be uploaded to GL without any conversion.
+	Only 2D images without supercompression are supported; cubemaps, arrays and volumes are refused.
+
+	An image can ship compressed variants next to itself, named like "image.astc.ktx2", "image.bc.ktx2", "image.etc2.ktx2" or "image.dds":
+	loadVariantOf() picks the first one whose format the GPU supports.
+	*/
+	class TextureContainer {
+	public:
+		struct Level {
+			const uint8_t* data;
+			size_t size;
+		};
+
+		///loads a .ktx2 or .dds file
+		/**
+		\returns false if the file is missing, invalid or in a format that isn't supported
+		*/
+		bool load(utf::string_view path);
+
+		///loads the contents of a .ktx2 or .dds file
+		bool loadFromMemory(std::vector<uint8_t> fileData);
+
+		///loads the best compressed variant of an image file that the current GL context supports
+		/**
+		\returns false if the image has no variant that can be used
+		*/
+		bool loadVariantOf(utf::string_view imagePath);
+
+		///tells if an image file has a compressed variant next to it, even one that the GPU can't use
+		static bool hasVariant(utf::string_view imagePath);
+
+		PixelFormat getFormat() const {
+			return mFormat;
+		}
+
+		uint32_t getWidth() const {
+			return mWidth;
+		}
+
+		uint32_t getHeight() const {
+			return mHeight;
+		}
+
+		uint8_t getLevelCount() const {
+			return (uint8_t)mLevels.size();
+		}
+
+		const Level& getLevel(uint8_t level) const {
+			return mLevels[level];
+		}
+
+	protected:
+		std::vector<uint8_t> mData;
+		std::vector<Level> mLevels;
+
+		PixelFormat mFormat = PixelFormat::Unknown;
+		uint32_t mWidth = 0, mHeight = 0;
+
+		bool _parseKTX2();
+		bool _parseDDS();
+
+		///adds the levels stored one after the other from offset, as DDS does
+		bool _addPackedLevels(size_t offset, uint32_t levelCount);
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+namespace Dojo {
+	class Texture;
+
+	///A TextureStreamer decides which mips of the streamed Textures are in VRAM
+	/**
+	Streamed textures keep their full mip chain in memory and start with only their low mips resident.
+	Each frame the Renderer requests the size the textures are drawn at, and update() streams in the more detailed
+	mips that are needed, a level at a time, on the GL thread.
+
+	When the resident textures would go over the VRAM budget, the top mips of the textures that weren't drawn for the
+	longest time are evicted first, then the ones of the biggest textures drawn in this frame; the low mips always stay.
+	*/
+	class TextureStreamer {
+	public:
+		///mips up to this size are uploaded as soon as a texture is loaded, and never evicted
+		static const uint32_t InitialResidentSize = 64;
+
+		///how many textures can stream in a level in a single frame
+		static const uint32_t DefaultUploadsPerFrame = 4;
+
+		explicit TextureStreamer(size_t VRAMBudget);
+
+		~TextureStreamer();
+
+		void setVRAMBudget(size_t bytes) {
+			mBudget = bytes;
+		}
+
+		size_t getVRAMBudget() const {
+			return mBudget;
+		}
+
+		///sets how many textures can stream in a level in a single frame
+		void setUploadsPerFrame(uint32_t count) {
+			mUploadsPerFrame = count;
+		}
+
+		///starts managing a Texture with its whole mip chain in memory, uploading its low mips
+		void add(Texture& texture);
+
+		///stops managing a Texture
+		void remove(Texture& texture);
+
+		///streams in and evicts mips following the sizes requested by the last frame, on the GL thread
+		void update();
+
+		///returns the VRAM used by the streamed textures after the last update
+		size_t getResidentSize() const {
+			return mResidentSize;
+		}
+
+		///returns how many textures streamed in a level during the last update
+		uint32_t getLastFrameUploadCount() const {
+			return mUploadCount;
+		}
+
+		///returns how many textures lost some of their top mips during the last update
+		uint32_t getLastFrameEvictionCount() const {
+			return mEvictionCount;
+		}
+
+		///returns the most detailed level of a texture that is smaller than InitialResidentSize
+		static uint8_t getInitialLevel(const Texture& texture);
+
+	protected:
+		struct Entry {
+			Texture* texture;
+			uint32_t lastRequestFrame;
+			uint8_t target;
+		};
+
+		std::vector<Entry> mEntries;
+
+		size_t mBudget;
+		uint32_t mUploadsPerFrame = DefaultUploadsPerFrame;
+		uint32_t mFrame = 0;
+
+		size_t mResidentSize = 0;
+		uint32_t mUploadCount = 0, mEvictionCount = 0;
+
+		//entry indices, reused between frames
+		std::vector<uint32_t> mOrder;
+	};
+}
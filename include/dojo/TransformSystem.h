@@ -0,0 +1,94 @@
+#pragma once
+
+#include "dojo_common_header.h"
+
+#include "Vector.h"
+
+namespace Dojo {
+	class Object;
+	class WorkerPool;
+
+	///A TransformSystem stores the transforms of a tree of Objects in flat arrays, one level per depth in the hierarchy
+	/**
+	Each level keeps its local positions, rotations, parent indices and world matrices in separate contiguous arrays,
+	so the world transforms are computed level by level, reading the parents from the previous level,
+	and each level is split over the WorkerPool.
+
+	The Objects keep their public position and rotation: they push them to the system when they act, and it recomputes
+	the dirty entries and their descendants in update(). Object::getWorldTransform() reads the result from here.
+	The system is only modified on the main thread.
+	*/
+	class TransformSystem {
+	public:
+		struct Handle {
+			uint32_t depth = 0, index = 0;
+		};
+
+		///how many entries of a level are updated by a single task
+		static const uint32_t ChunkSize = 1024;
+
+		///starts tracking an Object with no parent in the system
+		Handle addRoot(Object& object);
+
+		///starts tracking an Object whose parent is already tracked
+		Handle add(Object& object, const Handle& parent);
+
+		///stops tracking an entry; the last entry of its level takes its place and its Object is notified
+		void remove(const Handle& handle);
+
+		///sets the local transform of an entry, that is recomputed in the next update() if it changed
+		void setLocal(const Handle& handle, const Vector& position, const Quaternion& rotation);
+
+		///sets the local transform and recomputes the world transform of an entry right away, its descendants follow in the next update()
+		void updateNow(const Handle& handle, const Vector& position, const Quaternion& rotation);
+
+		const Matrix& getWorldTransform(const Handle& handle) const {
+			return mLevels[handle.depth].world[handle.index];
+		}
+
+		///returns a number that changes every time the world transform of the entry is recomputed
+		uint32_t getVersion(const Handle& handle) const {
+			return mLevels[handle.depth].versions[handle.index];
+		}
+
+		///recomputes the world transforms of the dirty entries and of their descendants, one level at a time
+		/**
+		\returns how many world transforms were recomputed
+		*/
+		uint32_t update(WorkerPool& pool);
+
+		///returns how many Objects are tracked
+		size_t size() const;
+
+		size_t getDepth() const {
+			return mLevels.size();
+		}
+
+		void _setParent(const Handle& handle, uint32_t parentIndex) {
+			mLevels[handle.depth].parents[handle.index] = parentIndex;
+		}
+
+	protected:
+		struct Level {
+			std::vector<Vector> positions;
+			std::vector<Quaternion> rotations;
+			std::vector<uint32_t> parents;
+			std::vector<Matrix> world;
+			std::vector<uint32_t> versions;
+			std::vector<uint8_t> dirty;
+			std::vector<Object*> owners;
+
+			size_t size() const {
+				return owners.size();
+			}
+		};
+
+		std::vector<Level> mLevels;
+
+		//incremented by each update, it's the version of the entries recomputed by it
+		uint32_t mPass = 1;
+
+		Handle _add(Object& object, uint32_t depth, uint32_t parentIndex);
+		void _computeWorld(uint32_t depth, uint32_t index);
+	};
+}
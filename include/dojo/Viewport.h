@@ -19,6 +19,7 @@
 #include "Platform.h"
 #include "Radians.h"
 #include "Framebuffer.h"
+#include "BoundsMath.h"
 
 namespace Dojo {
 	class Renderer;
@@ -164,6 +165,12 @@ namespace Dojo {
 		}
 
 		bool isContainedInFrustum(const Renderable& r) const;
+		bool isContainedInFrustum(const AABB& bb) const;
+
+		///returns the side planes of the frustum in the layout used to cull in bulk
+		const FrustumPlanes& getFrustumPlanes() const {
+			return mFrustumPlanes;
+		}
 
 		bool isVisible(Renderable& s);
 
@@ -209,6 +216,7 @@ namespace Dojo {
 		Vector mWorldFrustumVertices[4];
 
 		Plane mWorldFrustumPlanes[5];
+		FrustumPlanes mFrustumPlanes;
 
 		Degrees mVFOV;
 		float mZNear, mZFar;
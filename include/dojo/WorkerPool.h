@@ -13,14 +13,29 @@ namespace Dojo {
 		explicit WorkerPool(uint32_t workerCount, bool async = true, bool allowMultipleProducers = false);
 		~WorkerPool();
 
+		typedef std::function<void(uint32_t)> ParallelTask;
+
 		AsyncJob::StatusPtr queue(AsyncTask task, AsyncCallback callback = {});
 
+		///runs task(i) for each i in [0, count), spreading the indices over the workers and the calling thread
+		/**
+		returns when all the indices have been processed. The calling thread takes part in the work, so a worker
+		that is busy with a long job only means less parallelism, never a stall.
+		\remark must be called by the producer thread, and the task must be safe to run concurrently
+		*/
+		void parallelFor(uint32_t count, const ParallelTask& task);
+
 		void sync();
 
 		bool runOneCallback();
 	private:
+		struct ParallelFor;
+
 		uint32_t mNextWorker = 0;
 		std::vector<Unique<BackgroundWorker>> mWorkers;
+
+		//reused between calls, a state can be picked again only when no late helper job still references it
+		std::vector<Unique<ParallelFor>> mParallelForStates;
 	private:
 	};
 }
@@ -37,6 +37,16 @@
 	#define NDEBUG  //to be sure!
 #endif
 
+//SIMD instruction sets available to the math, which always has a scalar fallback
+//AVX needs the compiler to target it, see the DOJO_AVX option of CMakeLists.txt or /arch:AVX
+#if defined( __AVX__ )
+	#define DOJO_SIMD_AVX
+#endif
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define DOJO_SIMD_SSE
+#endif
+
 ///the cap for the textures bound to a single object
 #define DOJO_MAX_TEXTURES 4
 
@@ -0,0 +1,284 @@
+#include "AABBTree.h"
+
+using namespace Dojo;
+
+const float AABBTree::FatMargin = 0.1f;
+
+//the cost of a box in the tree, ie. its half surface area; flat 2D boxes still get their area
+float _treeCost(const AABB& bb) {
+	auto size = bb.getSize();
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+AABB _fattenBounds(const AABB& bb) {
+	auto margin = bb.getSize() * AABBTree::FatMargin;
+	return{ bb.min - margin, bb.max + margin };
+}
+
+bool _containsBounds(const AABB& outer, const AABB& inner) {
+	return
+		outer.min.x <= inner.min.x and outer.min.y <= inner.min.y and outer.min.z <= inner.min.z and
+		outer.max.x >= inner.max.x and outer.max.y >= inner.max.y and outer.max.z >= inner.max.z;
+}
+
+AABBTree::AABBTree() {
+
+}
+
+int AABBTree::_allocateNode() {
+	if (mFreeList == Null) {
+		mNodes.emplace_back();
+		return (int)mNodes.size() - 1;
+	}
+
+	int node = mFreeList;
+	mFreeList = mNodes[node].parent;
+	mNodes[node] = {};
+	return node;
+}
+
+void AABBTree::_freeNode(int node) {
+	mNodes[node].parent = mFreeList;
+	mNodes[node].height = -1;
+	mNodes[node].renderable = nullptr;
+	mFreeList = node;
+}
+
+SpatialIndex::Proxy AABBTree::insert(Renderable& r, const AABB& bounds) {
+	int leaf = _allocateNode();
+	mNodes[leaf].bounds = _fattenBounds(bounds);
+	mNodes[leaf].renderable = &r;
+
+	_insertLeaf(leaf);
+	++mLeafCount;
+
+	return (Proxy)leaf;
+}
+
+void AABBTree::move(Proxy proxy, const AABB& bounds) {
+	int leaf = (int)proxy;
+	DEBUG_ASSERT(leaf < (int)mNodes.size() and mNodes[leaf].isLeaf() and mNodes[leaf].height == 0, "Invalid proxy");
+
+	//still inside the fat box, nothing to do
+	if (_containsBounds(mNodes[leaf].bounds, bounds)) {
+		return;
+	}
+
+	_removeLeaf(leaf);
+	mNodes[leaf].bounds = _fattenBounds(bounds);
+	_insertLeaf(leaf);
+}
+
+void AABBTree::remove(Proxy proxy) {
+	int leaf = (int)proxy;
+	DEBUG_ASSERT(leaf < (int)mNodes.size() and mNodes[leaf].isLeaf() and mNodes[leaf].height == 0, "Invalid proxy");
+
+	_removeLeaf(leaf);
+	_freeNode(leaf);
+	--mLeafCount;
+}
+
+void AABBTree::_insertLeaf(int leaf) {
+	if (mRoot == Null) {
+		mRoot = leaf;
+		mNodes[leaf].parent = Null;
+		return;
+	}
+
+	//walk down to the sibling that makes the tree grow the least
+	auto leafBounds = mNodes[leaf].bounds;
+	int sibling = mRoot;
+	while (not mNodes[sibling].isLeaf()) {
+		auto& node = mNodes[sibling];
+		int child1 = node.child1;
+		int child2 = node.child2;
+
+		float area = _treeCost(node.bounds);
+		float combinedArea = _treeCost(node.bounds.expandToFit(leafBounds));
+
+		//cost of creating a new parent for this node and the new leaf
+		float cost = 2.f * combinedArea;
+
+		//minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.f * (combinedArea - area);
+
+		auto descendCost = [&](int child) {
+			auto& c = mNodes[child];
+			float newArea = _treeCost(c.bounds.expandToFit(leafBounds));
+			return c.isLeaf() ? newArea + inheritanceCost : (newArea - _treeCost(c.bounds)) + inheritanceCost;
+		};
+
+		float cost1 = descendCost(child1);
+		float cost2 = descendCost(child2);
+
+		if (cost < cost1 and cost < cost2) {
+			break;
+		}
+
+		sibling = cost1 < cost2 ? child1 : child2;
+	}
+
+	//create a new parent for the sibling and the leaf
+	int oldParent = mNodes[sibling].parent;
+	int newParent = _allocateNode();
+	{
+		auto& parent = mNodes[newParent];
+		parent.parent = oldParent;
+		parent.bounds = leafBounds.expandToFit(mNodes[sibling].bounds);
+		parent.height = mNodes[sibling].height + 1;
+		parent.child1 = sibling;
+		parent.child2 = leaf;
+	}
+
+	if (oldParent != Null) {
+		if (mNodes[oldParent].child1 == sibling) {
+			mNodes[oldParent].child1 = newParent;
+		}
+		else {
+			mNodes[oldParent].child2 = newParent;
+		}
+	}
+	else {
+		mRoot = newParent;
+	}
+
+	mNodes[sibling].parent = newParent;
+	mNodes[leaf].parent = newParent;
+
+	//walk back up fixing the heights and the bounds
+	for (int node = mNodes[leaf].parent; node != Null; node = mNodes[node].parent) {
+		node = _balance(node);
+
+		auto& n = mNodes[node];
+		n.height = 1 + std::max(mNodes[n.child1].height, mNodes[n.child2].height);
+		n.bounds = mNodes[n.child1].bounds.expandToFit(mNodes[n.child2].bounds);
+	}
+}
+
+void AABBTree::_removeLeaf(int leaf) {
+	if (leaf == mRoot) {
+		mRoot = Null;
+		return;
+	}
+
+	int parent = mNodes[leaf].parent;
+	int grandParent = mNodes[parent].parent;
+	int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+	//the sibling takes the place of the parent
+	if (grandParent != Null) {
+		if (mNodes[grandParent].child1 == parent) {
+			mNodes[grandParent].child1 = sibling;
+		}
+		else {
+			mNodes[grandParent].child2 = sibling;
+		}
+		mNodes[sibling].parent = grandParent;
+		_freeNode(parent);
+
+		for (int node = grandParent; node != Null; node = mNodes[node].parent) {
+			node = _balance(node);
+
+			auto& n = mNodes[node];
+			n.bounds = mNodes[n.child1].bounds.expandToFit(mNodes[n.child2].bounds);
+			n.height = 1 + std::max(mNodes[n.child1].height, mNodes[n.child2].height);
+		}
+	}
+	else {
+		mRoot = sibling;
+		mNodes[sibling].parent = Null;
+		_freeNode(parent);
+	}
+}
+
+int AABBTree::_balance(int iA) {
+	//performs a left or right rotation if the subtrees of A are unbalanced, returns the new root of the subtree
+	auto& A = mNodes[iA];
+	if (A.isLeaf() or A.height < 2) {
+		return iA;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	int balance = mNodes[iC].height - mNodes[iB].height;
+
+	auto rotateUp = [&](int iStay, int iUp, bool upWasChild2) {
+		//promotes Up above A, Stay remains a child of A
+		auto& A = mNodes[iA];
+		auto& up = mNodes[iUp];
+		int iF = up.child1;
+		int iG = up.child2;
+
+		up.child1 = iA;
+		up.parent = A.parent;
+		A.parent = iUp;
+
+		if (up.parent != Null) {
+			auto& P = mNodes[up.parent];
+			if (P.child1 == iA) {
+				P.child1 = iUp;
+			}
+			else {
+				P.child2 = iUp;
+			}
+		}
+		else {
+			mRoot = iUp;
+		}
+
+		//the taller child of Up stays there, the other one takes its place below A
+		int iKeep = mNodes[iF].height > mNodes[iG].height ? iF : iG;
+		int iMove = iKeep == iF ? iG : iF;
+
+		up.child2 = iKeep;
+		if (upWasChild2) {
+			A.child2 = iMove;
+		}
+		else {
+			A.child1 = iMove;
+		}
+		mNodes[iMove].parent = iA;
+
+		A.bounds = mNodes[iStay].bounds.expandToFit(mNodes[iMove].bounds);
+		up.bounds = A.bounds.expandToFit(mNodes[iKeep].bounds);
+
+		A.height = 1 + std::max(mNodes[iStay].height, mNodes[iMove].height);
+		up.height = 1 + std::max(A.height, mNodes[iKeep].height);
+
+		return iUp;
+	};
+
+	if (balance > 1) {
+		return rotateUp(iB, iC, true);
+	}
+	else if (balance < -1) {
+		return rotateUp(iC, iB, false);
+	}
+
+	return iA;
+}
+
+int AABBTree::getHeight() const {
+	return mRoot == Null ? 0 : mNodes[mRoot].height;
+}
+
+void AABBTree::_query(int node, const BoundsTest& test, const Visitor& visit) const {
+	auto& n = mNodes[node];
+	if (not test(n.bounds)) {
+		return;
+	}
+
+	if (n.isLeaf()) {
+		visit(*n.renderable, (Proxy)node);
+	}
+	else {
+		_query(n.child1, test, visit);
+		_query(n.child2, test, visit);
+	}
+}
+
+void AABBTree::query(const BoundsTest& test, const Visitor& visit) const {
+	if (mRoot != Null) {
+		_query(mRoot, test, visit);
+	}
+}
@@ -0,0 +1,96 @@
+#include "AtlasPacker.h"
+
+using namespace Dojo;
+
+AtlasPacker::AtlasPacker(uint32_t width, uint32_t height) :
+	mWidth(width),
+	mHeight(height) {
+	DEBUG_ASSERT(width > 0 and height > 0, "Invalid page size");
+
+	mSkyline.push_back({ 0, 0, width });
+}
+
+bool AtlasPacker::_fits(size_t segment, uint32_t width, uint32_t height, uint32_t& y) const {
+	auto x = mSkyline[segment].x;
+	if (x + width > mWidth) {
+		return false;
+	}
+
+	//the rectangle lies on the highest of the segments under it
+	y = 0;
+	for (uint32_t covered = 0; covered < width; ++segment) {
+		y = std::max(y, mSkyline[segment].y);
+		if (y + height > mHeight) {
+			return false;
+		}
+
+		covered += mSkyline[segment].width;
+	}
+
+	return true;
+}
+
+bool AtlasPacker::insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y) {
+	DEBUG_ASSERT(width > 0 and height > 0, "Invalid rectangle size");
+
+	size_t best = SIZE_MAX;
+	uint32_t bestTop = UINT32_MAX, bestWidth = UINT32_MAX;
+
+	for (size_t i = 0; i < mSkyline.size(); ++i) {
+		uint32_t top;
+		if (_fits(i, width, height, top)) {
+			//the lowest top edge wins, then the narrowest segment to leave the wide ones free
+			top += height;
+			if (top < bestTop or (top == bestTop and mSkyline[i].width < bestWidth)) {
+				best = i;
+				bestTop = top;
+				bestWidth = mSkyline[i].width;
+			}
+		}
+	}
+
+	if (best == SIZE_MAX) {
+		return false;
+	}
+
+	x = mSkyline[best].x;
+	y = bestTop - height;
+
+	mSkyline.insert(mSkyline.begin() + best, { x, bestTop, width });
+
+	//the segments now under the rectangle are cut or removed
+	for (auto i = best + 1; i < mSkyline.size();) {
+		auto& previous = mSkyline[i - 1];
+		auto& current = mSkyline[i];
+		auto previousEnd = previous.x + previous.width;
+
+		if (current.x >= previousEnd) {
+			break;
+		}
+
+		auto overlap = previousEnd - current.x;
+		if (current.width <= overlap) {
+			mSkyline.erase(mSkyline.begin() + i);
+			continue;
+		}
+
+		current.x += overlap;
+		current.width -= overlap;
+		break;
+	}
+
+	//join the neighbors at the same height
+	for (size_t i = 0; i + 1 < mSkyline.size();) {
+		if (mSkyline[i].y == mSkyline[i + 1].y) {
+			mSkyline[i].width += mSkyline[i + 1].width;
+			mSkyline.erase(mSkyline.begin() + i + 1);
+		}
+		else {
+			++i;
+		}
+	}
+
+	mUsedWidth = std::max(mUsedWidth, x + width);
+	mUsedHeight = std::max(mUsedHeight, bestTop);
+	return true;
+}
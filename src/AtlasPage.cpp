@@ -0,0 +1,101 @@
+#include "AtlasPage.h"
+
+#include "Platform.h"
+#include "ResourceGroup.h"
+#include "range.h"
+
+using namespace Dojo;
+
+void _blitWithGutter(uint8_t* page, uint32_t pageWidth, uint32_t pageHeight, const uint8_t* image, int pixelSize, const AtlasPage::Tile& tile) {
+	//the gutter repeats the border pixels of the image
+	int half = AtlasPage::Gutter / 2;
+	int x0 = std::max((int)tile.x - half, 0), x1 = std::min((int)(tile.x + tile.width) + half, (int)pageWidth);
+	int y0 = std::max((int)tile.y - half, 0), y1 = std::min((int)(tile.y + tile.height) + half, (int)pageHeight);
+
+	for (int y = y0; y < y1; ++y) {
+		auto sy = glm::clamp(y - (int)tile.y, 0, (int)tile.height - 1);
+		auto row = image + sy * tile.width * pixelSize;
+		auto out = page + (y * pageWidth + x0) * 4;
+
+		for (int x = x0; x < x1; ++x, out += 4) {
+			auto sx = glm::clamp(x - (int)tile.x, 0, (int)tile.width - 1);
+			auto in = row + sx * pixelSize;
+
+			out[0] = in[0];
+			out[1] = in[1];
+			out[2] = in[2];
+			out[3] = pixelSize == 4 ? in[3] : 255;
+		}
+	}
+}
+
+AtlasPage::AtlasPage(optional_ref<ResourceGroup> creator, uint32_t width, uint32_t height) :
+	Texture(creator),
+	mPageWidth(width),
+	mPageHeight(height) {
+	DEBUG_ASSERT(width > 0 and height > 0 and width <= MaxSide and height <= MaxSide, "Invalid page size");
+}
+
+void AtlasPage::addTile(utf::string_view path, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+	DEBUG_ASSERT(not isLoaded(), "Can't add tiles to a loaded page");
+	DEBUG_ASSERT(x + width <= mPageWidth and y + height <= mPageHeight, "The tile is out of the page");
+
+	mTiles.push_back({ path.copy(), x, y, width, height });
+}
+
+void AtlasPage::onPrepare() {
+	DEBUG_ASSERT(not isLoaded(), "The page is already loaded");
+
+	mPixels.assign(mPageWidth * mPageHeight * 4, 0);
+
+	for (auto i : range(mTiles.size())) {
+		auto& tile = mTiles[i];
+
+		std::vector<uint8_t> image;
+		uint32_t width, height;
+		int pixelSize;
+		auto format = Platform::singleton().loadImageFile(image, tile.path, width, height, pixelSize);
+
+		if (format == PixelFormat::Unknown) {
+			DEBUG_MESSAGE("Cannot load an image file: " + tile.path);
+			continue;
+		}
+
+		DEBUG_ASSERT_INFO(width == tile.width and height == tile.height, "The image changed size since it was packed", "path = " + tile.path);
+
+		if (width != tile.width or height != tile.height) {
+			continue;
+		}
+
+		//the page takes the color space of its first image
+		if (i == 0 and (format == PixelFormat::RGBA_8_8_8_8_SRGB or format == PixelFormat::RGB_8_8_8_SRGB)) {
+			mFormat = PixelFormat::RGBA_8_8_8_8_SRGB;
+		}
+
+		_blitWithGutter(mPixels.data(), mPageWidth, mPageHeight, image.data(), pixelSize, tile);
+	}
+
+	prepared = true;
+}
+
+bool AtlasPage::onLoad() {
+	DEBUG_ASSERT(not isLoaded(), "The page is already loaded");
+
+	if (not prepared) {
+		onPrepare();
+	}
+
+	_applyCreatorSampling();
+
+	bool mipmaps = creator.is_none() or not creator.unwrap().disableMipmaps;
+	loadFromMemory(mPixels.data(), mPageWidth, mPageHeight, mFormat, mipmaps);
+
+	mPixels = {};
+	prepared = false;
+
+	return loaded;
+}
+
+void AtlasPage::onUnload(bool soft) {
+	Texture::onUnload(false);
+}
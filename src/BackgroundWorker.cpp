@@ -56,12 +56,17 @@ AsyncJob BackgroundWorker::_waitForNextTask() {
 
 bool BackgroundWorker::runNextTask() {
 	if (auto job = _waitForNextTask()) {
-		auto& status = *job.mStatus;
-		status = AsyncJob::Status::Running;
+		//jobs queued internally may have no status to report
+		if (job.mStatus) {
+			*job.mStatus = AsyncJob::Status::Running;
+		}
+
 		job.task();
 
 		if (job.callback) {
-			status = AsyncJob::Status::Callback;
+			if (job.mStatus) {
+				*job.mStatus = AsyncJob::Status::Callback;
+			}
 			mCompletedQueue->enqueue(std::move(job));
 		}
 		return true;
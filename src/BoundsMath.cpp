@@ -0,0 +1,231 @@
+#include "BoundsMath.h"
+
+#include "Plane.h"
+#include "range.h"
+
+#ifdef DOJO_SIMD_SSE
+	#include <emmintrin.h>
+#endif
+
+#ifdef DOJO_SIMD_AVX
+	#include <immintrin.h>
+#endif
+
+using namespace Dojo;
+
+void FrustumPlanes::setup(const Plane* planes) {
+	for (auto i : range(Count)) {
+		auto& plane = planes[i];
+		nx[i] = plane.n.x;
+		ny[i] = plane.n.y;
+		nz[i] = plane.n.z;
+		d[i] = plane.d;
+
+		absNx[i] = std::abs(plane.n.x);
+		absNy[i] = std::abs(plane.n.y);
+		absNz[i] = std::abs(plane.n.z);
+	}
+}
+
+void AABBArray::resize(size_t size) {
+	for (auto array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+		array->resize(size);
+	}
+}
+
+void AABBArray::set(size_t i, const AABB& bb) {
+	auto center = bb.getCenter();
+	auto extent = bb.getSize() * 0.5f;
+
+	centerX[i] = center.x;
+	centerY[i] = center.y;
+	centerZ[i] = center.z;
+	extentX[i] = extent.x;
+	extentY[i] = extent.y;
+	extentZ[i] = extent.z;
+}
+
+//transforms a box given as center and extents: the center goes through the matrix,
+//the extents through its absolute value (Arvo), which gives the same box as transforming the 8 corners
+//the outputs need room for 4 floats
+void _transformCenterExtent(const Matrix& m, const Vector& center, const Vector& extent, float* outCenter, float* outExtent) {
+#ifdef DOJO_SIMD_SSE
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	auto c0 = _mm_loadu_ps(&m[0][0]);
+	auto c1 = _mm_loadu_ps(&m[1][0]);
+	auto c2 = _mm_loadu_ps(&m[2][0]);
+	auto c3 = _mm_loadu_ps(&m[3][0]);
+
+	auto c = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(center.x)), _mm_mul_ps(c1, _mm_set1_ps(center.y))),
+		_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(center.z)), c3));
+
+	auto e = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_and_ps(c0, absMask), _mm_set1_ps(extent.x)),
+			_mm_mul_ps(_mm_and_ps(c1, absMask), _mm_set1_ps(extent.y))),
+		_mm_mul_ps(_mm_and_ps(c2, absMask), _mm_set1_ps(extent.z)));
+
+	_mm_storeu_ps(outCenter, c);
+	_mm_storeu_ps(outExtent, e);
+#else
+	for (auto i : range(3)) {
+		outCenter[i] = m[0][i] * center.x + m[1][i] * center.y + m[2][i] * center.z + m[3][i];
+		outExtent[i] = std::abs(m[0][i]) * extent.x + std::abs(m[1][i]) * extent.y + std::abs(m[2][i]) * extent.z;
+	}
+#endif
+}
+
+void AABBArray::set(size_t i, const Matrix& transform, const AABB& local) {
+	float center[4], extent[4];
+	_transformCenterExtent(transform, local.getCenter(), local.getSize() * 0.5f, center, extent);
+
+	centerX[i] = center[0];
+	centerY[i] = center[1];
+	centerZ[i] = center[2];
+	extentX[i] = extent[0];
+	extentY[i] = extent[1];
+	extentZ[i] = extent[2];
+}
+
+AABB AABBArray::get(size_t i) const {
+	Vector center(centerX[i], centerY[i], centerZ[i]);
+	Vector extent(extentX[i], extentY[i], extentZ[i]);
+	return{ center - extent, center + extent };
+}
+
+AABB BoundsMath::transform(const Matrix& transform, const AABB& local) {
+	float center[4], extent[4];
+	_transformCenterExtent(transform, local.getCenter(), local.getSize() * 0.5f, center, extent);
+
+	return{
+		{ center[0] - extent[0], center[1] - extent[1], center[2] - extent[2] },
+		{ center[0] + extent[0], center[1] + extent[1], center[2] + extent[2] }
+	};
+}
+
+bool BoundsMath::isInFrustum(const FrustumPlanes& frustum, const AABB& bb) {
+	auto center = bb.getCenter();
+	auto extent = bb.getSize() * 0.5f;
+
+	//a box is behind a plane when its center is further than its projected radius
+#ifdef DOJO_SIMD_SSE
+	static_assert(FrustumPlanes::Count == 4, "The SSE path tests exactly 4 planes");
+
+	auto dist = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(frustum.nx), _mm_set1_ps(center.x)),
+			_mm_mul_ps(_mm_load_ps(frustum.ny), _mm_set1_ps(center.y))),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(frustum.nz), _mm_set1_ps(center.z)),
+			_mm_load_ps(frustum.d)));
+
+	auto radius = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_load_ps(frustum.absNx), _mm_set1_ps(extent.x)),
+			_mm_mul_ps(_mm_load_ps(frustum.absNy), _mm_set1_ps(extent.y))),
+		_mm_mul_ps(_mm_load_ps(frustum.absNz), _mm_set1_ps(extent.z)));
+
+	return _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(dist, radius), _mm_setzero_ps())) == 0xf;
+#else
+	for (auto p : range(FrustumPlanes::Count)) {
+		float dist = frustum.nx[p] * center.x + frustum.ny[p] * center.y + frustum.nz[p] * center.z + frustum.d[p];
+		float radius = frustum.absNx[p] * extent.x + frustum.absNy[p] * extent.y + frustum.absNz[p] * extent.z;
+
+		if (not (dist + radius >= 0)) {
+			return false;
+		}
+	}
+	return true;
+#endif
+}
+
+uint32_t BoundsMath::cullFrustum(const FrustumPlanes& frustum, const AABBArray& boxes, uint32_t begin, uint32_t end, uint32_t* outIndices) {
+	DEBUG_ASSERT(begin <= end and end <= boxes.size(), "Invalid range");
+
+	auto cx = boxes.centerX.data(), cy = boxes.centerY.data(), cz = boxes.centerZ.data();
+	auto ex = boxes.extentX.data(), ey = boxes.extentY.data(), ez = boxes.extentZ.data();
+
+	uint32_t count = 0;
+	uint32_t i = begin;
+
+	//each plane is tested against a whole register of boxes
+#ifdef DOJO_SIMD_AVX
+	for (; i + 8 <= end; i += 8) {
+		auto visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (auto p : range(FrustumPlanes::Count)) {
+			auto dist = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_mul_ps(_mm256_loadu_ps(cx + i), _mm256_set1_ps(frustum.nx[p])),
+					_mm256_mul_ps(_mm256_loadu_ps(cy + i), _mm256_set1_ps(frustum.ny[p]))),
+				_mm256_add_ps(
+					_mm256_mul_ps(_mm256_loadu_ps(cz + i), _mm256_set1_ps(frustum.nz[p])),
+					_mm256_set1_ps(frustum.d[p])));
+
+			auto radius = _mm256_add_ps(
+				_mm256_add_ps(
+					_mm256_mul_ps(_mm256_loadu_ps(ex + i), _mm256_set1_ps(frustum.absNx[p])),
+					_mm256_mul_ps(_mm256_loadu_ps(ey + i), _mm256_set1_ps(frustum.absNy[p]))),
+				_mm256_mul_ps(_mm256_loadu_ps(ez + i), _mm256_set1_ps(frustum.absNz[p])));
+
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		auto mask = _mm256_movemask_ps(visible);
+		for (auto b : range(8)) {
+			if (mask & (1 << b)) {
+				outIndices[count++] = i + b;
+			}
+		}
+	}
+#endif
+
+#ifdef DOJO_SIMD_SSE
+	for (; i + 4 <= end; i += 4) {
+		auto visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (auto p : range(FrustumPlanes::Count)) {
+			auto dist = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(_mm_loadu_ps(cx + i), _mm_set1_ps(frustum.nx[p])),
+					_mm_mul_ps(_mm_loadu_ps(cy + i), _mm_set1_ps(frustum.ny[p]))),
+				_mm_add_ps(
+					_mm_mul_ps(_mm_loadu_ps(cz + i), _mm_set1_ps(frustum.nz[p])),
+					_mm_set1_ps(frustum.d[p])));
+
+			auto radius = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(_mm_loadu_ps(ex + i), _mm_set1_ps(frustum.absNx[p])),
+					_mm_mul_ps(_mm_loadu_ps(ey + i), _mm_set1_ps(frustum.absNy[p]))),
+				_mm_mul_ps(_mm_loadu_ps(ez + i), _mm_set1_ps(frustum.absNz[p])));
+
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+		}
+
+		auto mask = _mm_movemask_ps(visible);
+		for (auto b : range(4)) {
+			if (mask & (1 << b)) {
+				outIndices[count++] = i + b;
+			}
+		}
+	}
+#endif
+
+	//scalar tail, or the whole range without SIMD
+	for (; i < end; ++i) {
+		bool visible = true;
+		for (auto p : range(FrustumPlanes::Count)) {
+			float dist = frustum.nx[p] * cx[i] + frustum.ny[p] * cy[i] + frustum.nz[p] * cz[i] + frustum.d[p];
+			float radius = frustum.absNx[p] * ex[i] + frustum.absNy[p] * ey[i] + frustum.absNz[p] * ez[i];
+			visible &= dist + radius >= 0;
+		}
+
+		if (visible) {
+			outIndices[count++] = i;
+		}
+	}
+
+	return count;
+}
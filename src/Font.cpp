@@ -323,10 +323,19 @@ Font::~Font() {
 
 }
 
+void Font::onPrepare() {
+	DEBUG_ASSERT(not isLoaded(), "onLoad: this font is already loaded" );
+
+	mDescriptor = make_unique<Table>(Platform::singleton().load(filePath));
+	mFaceFile = Platform::singleton().loadFileContent(Path::getParentDirectory(filePath) + mDescriptor->getString("truetype"));
+
+	prepared = true;
+}
+
 bool Font::onLoad() {
 	DEBUG_ASSERT(not isLoaded(), "onLoad: this font is already loaded" );
 
-	Table t = Platform::singleton().load(filePath);
+	Table t = prepared ? std::move(*mDescriptor) : Platform::singleton().load(filePath);
 
 	fontFile = Path::getParentDirectory(filePath) + t.getString("truetype");
 	fontWidth = fontHeight = t.getInt("size");
@@ -345,7 +354,11 @@ bool Font::onLoad() {
 	mCellWidth = fontWidth + glowRadius * 2;
 	mCellHeight = fontHeight + glowRadius * 2;
 
-	face = Platform::singleton().getFontSystem().getFace(fontFile);
+	face = Platform::singleton().getFontSystem().getFace(fontFile, std::move(mFaceFile));
+
+	mDescriptor = {};
+	mFaceFile = {};
+	prepared = false;
 
 	auto& preload = t.getTable("preloadedPages");
 
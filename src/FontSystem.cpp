@@ -13,9 +13,9 @@ FontSystem::~FontSystem() {
 	FT_Done_FreeType(freeType);
 }
 
-FT_Face FontSystem::getFace(utf::string_view fileName) {
+FT_Face FontSystem::getFace(utf::string_view fileName, std::vector<uint8_t> fileContent) {
 	auto where = faceMap.find(fileName);
-	return where != faceMap.end() ? where->second : _createFaceForFile(fileName);
+	return where != faceMap.end() ? where->second : _createFaceForFile(fileName, std::move(fileContent));
 }
 
 FT_Stroker FontSystem::getStroker(float width) {
@@ -31,8 +31,10 @@ FT_Stroker FontSystem::getStroker(float width) {
 	return s;
 }
 
-FT_Face FontSystem::_createFaceForFile(utf::string_view fileName) {
-	auto buf = Platform::singleton().loadFileContent(fileName);
+FT_Face FontSystem::_createFaceForFile(utf::string_view fileName, std::vector<uint8_t> buf) {
+	if (buf.empty()) {
+		buf = Platform::singleton().loadFileContent(fileName);
+	}
 
 	//create new face from memory - loading from memory is needed for zip loading
 	FT_Face face;
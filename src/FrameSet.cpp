@@ -57,17 +57,19 @@ bool FrameSet::onLoad() {
 	DEBUG_ASSERT(not isLoaded(), "onLoad: this FrameSet is already loaded" );
 
 	loaded = true;
+	size = 0;
 
 	for (auto&& t : ownedFrames) {
-		if (not t->isLoaded()) {
+		if (not t->isLoaded() and not t->isPending()) {
 			t->onLoad();
+		}
 
-			loaded &= t->isLoaded();
+		//textures loading in the background count as loaded, they can already be used
+		loaded &= t->isLoaded() or t->isPending();
 
-			// count bytesize
-			if (t->isLoaded()) {
-				size += t->getByteSize();
-			}
+		//count bytesize, a ResourceLoader might have loaded the textures already
+		if (t->isLoaded()) {
+			size += t->getByteSize();
 		}
 	}
 
@@ -0,0 +1,141 @@
+#include "GPUTimer.h"
+
+#include "range.h"
+
+#include <glad/glad.h>
+
+using namespace Dojo;
+
+bool GPUTimer::isSupported() {
+#ifdef GL_EXT_disjoint_timer_query
+	return GLAD_GL_EXT_disjoint_timer_query != 0;
+#else
+	return false;
+#endif
+}
+
+GPUTimer::GPUTimer() {
+	DEBUG_ASSERT(isSupported(), "GPU timer queries are not supported by this context");
+}
+
+GPUTimer::~GPUTimer() {
+#ifdef GL_EXT_disjoint_timer_query
+	for (auto&& pool : mPools) {
+		if (pool.queries.size()) {
+			glDeleteQueriesEXT((GLsizei)pool.queries.size(), pool.queries.data());
+		}
+	}
+#endif
+}
+
+bool GPUTimer::_isAvailable(const Pool& pool) const {
+#ifdef GL_EXT_disjoint_timer_query
+	//the queries complete in order, so the last one tells about all of them
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuivEXT(pool.queries[pool.sections.size() - 1], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+	return available == GL_TRUE;
+#else
+	return false;
+#endif
+}
+
+void GPUTimer::_collect(Pool& pool) {
+#ifdef GL_EXT_disjoint_timer_query
+	mLastTimings.frame = 0;
+	mLastTimings.viewports.clear();
+	std::fill(mLastTimings.layers.begin(), mLastTimings.layers.end(), 0.f);
+
+	for (auto i : range(pool.sections.size())) {
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64vEXT(pool.queries[i], GL_QUERY_RESULT_EXT, &elapsed);
+
+		auto& section = pool.sections[i];
+		float ms = elapsed * 1e-6f;
+
+		mLastTimings.frame += ms;
+
+		auto viewport = std::find_if(mLastTimings.viewports.begin(), mLastTimings.viewports.end(), [&](const std::pair<const Viewport*, float>& entry) {
+			return entry.first == section.viewport;
+		});
+
+		if (viewport == mLastTimings.viewports.end()) {
+			mLastTimings.viewports.emplace_back(section.viewport, ms);
+		}
+		else {
+			viewport->second += ms;
+		}
+
+		if (section.layer != RenderLayer::InvalidID) {
+			if (section.layer >= mLastTimings.layers.size()) {
+				mLastTimings.layers.resize(section.layer + 1, 0.f);
+			}
+			mLastTimings.layers[section.layer] += ms;
+		}
+	}
+#endif
+
+	pool.pending = false;
+}
+
+void GPUTimer::beginFrame() {
+	DEBUG_ASSERT(mRecording.is_none(), "The last frame was not ended");
+
+#ifdef GL_EXT_disjoint_timer_query
+	//a disjoint event (eg. a power state change) makes all the results in flight meaningless, drop them
+	GLint disjoint = GL_FALSE;
+	glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+	//read back from the oldest pool on, so that the newest finished frame is the one that stays
+	for (auto i : range(1, PoolCount + 1)) {
+		auto& pool = mPools[(mCurrentPool + i) % PoolCount];
+		if (pool.pending) {
+			if (disjoint) {
+				pool.pending = false;
+			}
+			else if (_isAvailable(pool)) {
+				_collect(pool);
+			}
+		}
+	}
+
+	mCurrentPool = (mCurrentPool + 1) % PoolCount;
+	auto& pool = mPools[mCurrentPool];
+
+	//the GPU didn't catch up with this pool yet, skip measuring this frame rather than waiting
+	if (not pool.pending) {
+		pool.sections.clear();
+		mRecording = pool;
+	}
+#endif
+}
+
+void GPUTimer::begin(const Section& section) {
+#ifdef GL_EXT_disjoint_timer_query
+	if (auto pool = mRecording.to_raw_ptr()) {
+		if (pool->sections.size() == pool->queries.size()) {
+			GLuint query = 0;
+			glGenQueriesEXT(1, &query);
+			pool->queries.push_back(query);
+		}
+
+		glBeginQueryEXT(GL_TIME_ELAPSED_EXT, pool->queries[pool->sections.size()]);
+		pool->sections.push_back(section);
+	}
+#endif
+}
+
+void GPUTimer::end() {
+#ifdef GL_EXT_disjoint_timer_query
+	if (mRecording.is_some()) {
+		glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+	}
+#endif
+}
+
+void GPUTimer::endFrame() {
+	if (auto pool = mRecording.to_raw_ptr()) {
+		pool->pending = pool->sections.size() > 0;
+	}
+
+	mRecording = {};
+}
@@ -8,6 +8,7 @@
 #include "Platform.h"
 #include "TouchArea.h"
 #include "InputSystem.h"
+#include "TransformSystem.h"
 
 using namespace Dojo;
 
@@ -20,6 +21,7 @@ GameState::GameState(Game& parentGame) :
 
 GameState::~GameState() {
 	clear();
+	disableTransformSystem();
 }
 
 void GameState::clear() {
@@ -29,6 +31,20 @@ void GameState::clear() {
 	unloadResources(false);
 }
 
+void GameState::enableTransformSystem() {
+	if (not mTransforms) {
+		mTransforms = make_unique<TransformSystem>();
+		_joinTransformSystem(*mTransforms);
+	}
+}
+
+void GameState::disableTransformSystem() {
+	if (mTransforms) {
+		_leaveTransformSystem();
+		mTransforms = {};
+	}
+}
+
 void GameState::setViewport(Viewport& v) {
 	camera = v;
 }
@@ -93,6 +109,16 @@ void GameState::onLoop(float dt) {
 	updateClickableState();
 
 	updateChilds(dt);
+
+	if (mTransforms) {
+		auto& pool = Platform::singleton().getBackgroundPool();
+
+#ifndef PUBLISH
+		gTransformUpdateCount += mTransforms->update(pool);
+#else
+		mTransforms->update(pool);
+#endif
+	}
 }
 
 void GameState::begin() {
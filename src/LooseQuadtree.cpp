@@ -0,0 +1,223 @@
+#include "LooseQuadtree.h"
+
+#include "range.h"
+
+using namespace Dojo;
+
+float _quadtreeRadius(const AABB& bounds) {
+	auto size = bounds.getSize();
+	return std::max(size.x, size.y) * 0.5f;
+}
+
+LooseQuadtree::LooseQuadtree() {
+
+}
+
+int LooseQuadtree::_findCell(const AABB& bounds, bool create) {
+	auto center = bounds.getCenter();
+	auto radius = _quadtreeRadius(bounds);
+
+	//go down while the element still fits in the cells below, the loose bounds take care of the overflow
+	int cell = 0;
+	while (mCells[cell].depth < MaxDepth) {
+		float childHalfSize = mCells[cell].halfSize * 0.5f;
+		if (radius > childHalfSize) {
+			break;
+		}
+
+		auto& parentCenter = mCells[cell].center;
+		int quadrant = (center.x >= parentCenter.x ? 1 : 0) | (center.y >= parentCenter.y ? 2 : 0);
+
+		int child = mCells[cell].children[quadrant];
+		if (child == Null) {
+			if (not create) {
+				return Null;
+			}
+
+			Cell c;
+			c.center = {
+				parentCenter.x + (quadrant & 1 ? childHalfSize : -childHalfSize),
+				parentCenter.y + (quadrant & 2 ? childHalfSize : -childHalfSize)
+			};
+			c.halfSize = childHalfSize;
+			c.depth = mCells[cell].depth + 1;
+
+			child = (int)mCells.size();
+			mCells[cell].children[quadrant] = child;
+			mCells.push_back(c);
+		}
+
+		cell = child;
+	}
+
+	return cell;
+}
+
+void LooseQuadtree::_link(int element, int cell) {
+	auto& e = mElements[element];
+	e.cell = cell;
+	e.prev = Null;
+	e.next = mCells[cell].firstElement;
+
+	if (e.next != Null) {
+		mElements[e.next].prev = element;
+	}
+	mCells[cell].firstElement = element;
+}
+
+void LooseQuadtree::_unlink(int element) {
+	auto& e = mElements[element];
+
+	if (e.prev != Null) {
+		mElements[e.prev].next = e.next;
+	}
+	else {
+		mCells[e.cell].firstElement = e.next;
+	}
+
+	if (e.next != Null) {
+		mElements[e.next].prev = e.prev;
+	}
+
+	e.cell = e.prev = e.next = Null;
+}
+
+void LooseQuadtree::_growToFit(const AABB& bounds) {
+	auto center = bounds.getCenter();
+	auto radius = _quadtreeRadius(bounds);
+
+	auto fits = [&]() {
+		auto& root = mCells[0];
+		return
+			radius <= root.halfSize and
+			std::abs(center.x - root.center.x) <= root.halfSize and
+			std::abs(center.y - root.center.y) <= root.halfSize;
+	};
+
+	if (mCells.empty()) {
+		Cell root;
+		root.center = { center.x, center.y };
+		root.halfSize = std::max(radius * 16.f, 1.f);
+		root.depth = 0;
+		mCells.push_back(root);
+		return;
+	}
+
+	if (fits()) {
+		return;
+	}
+
+	//double the root around the same center until the element fits, then relink everything in the new cells
+	Cell root = mCells[0];
+	do {
+		root.halfSize *= 2.f;
+		mCells[0].halfSize = root.halfSize;
+	} while (not fits());
+
+	root.children = { { Null, Null, Null, Null } };
+	root.firstElement = Null;
+
+	mCells.clear();
+	mCells.push_back(root);
+
+	for (auto i : range(mElements.size())) {
+		auto& e = mElements[i];
+		if (e.renderable) {
+			e.cell = Null;
+			_link((int)i, _findCell(e.bounds, true));
+		}
+	}
+}
+
+SpatialIndex::Proxy LooseQuadtree::insert(Renderable& r, const AABB& bounds) {
+	int element;
+	if (mFreeElements != Null) {
+		element = mFreeElements;
+		mFreeElements = mElements[element].next;
+	}
+	else {
+		element = (int)mElements.size();
+		mElements.emplace_back();
+	}
+
+	//grow before filling in the element, or it would be linked twice
+	_growToFit(bounds);
+
+	mElements[element].renderable = &r;
+	mElements[element].bounds = bounds;
+
+	mMinZ = std::min(mMinZ, bounds.min.z);
+	mMaxZ = std::max(mMaxZ, bounds.max.z);
+
+	_link(element, _findCell(bounds, true));
+
+	++mElementCount;
+	return (Proxy)element;
+}
+
+void LooseQuadtree::move(Proxy proxy, const AABB& bounds) {
+	int element = (int)proxy;
+	DEBUG_ASSERT(element < (int)mElements.size() and mElements[element].renderable, "Invalid proxy");
+
+	mElements[element].bounds = bounds;
+
+	mMinZ = std::min(mMinZ, bounds.min.z);
+	mMaxZ = std::max(mMaxZ, bounds.max.z);
+
+	_growToFit(bounds);
+
+	//relink only if it now belongs to another cell
+	int cell = _findCell(bounds, false);
+	if (cell != mElements[element].cell) {
+		_unlink(element);
+		_link(element, cell == Null ? _findCell(bounds, true) : cell);
+	}
+}
+
+void LooseQuadtree::remove(Proxy proxy) {
+	int element = (int)proxy;
+	DEBUG_ASSERT(element < (int)mElements.size() and mElements[element].renderable, "Invalid proxy");
+
+	_unlink(element);
+
+	auto& e = mElements[element];
+	e.renderable = nullptr;
+	e.next = mFreeElements;
+	mFreeElements = element;
+
+	--mElementCount;
+}
+
+void LooseQuadtree::_query(int cell, const BoundsTest& test, const Visitor& visit) const {
+	auto& c = mCells[cell];
+
+	//the loose bounds of a cell contain everything linked to it and to its children
+	float looseHalfSize = c.halfSize * 2.f;
+	AABB looseBounds = {
+		{ c.center.x - looseHalfSize, c.center.y - looseHalfSize, mMinZ },
+		{ c.center.x + looseHalfSize, c.center.y + looseHalfSize, mMaxZ }
+	};
+
+	if (not test(looseBounds)) {
+		return;
+	}
+
+	for (int element = c.firstElement; element != Null; element = mElements[element].next) {
+		auto& e = mElements[element];
+		if (test(e.bounds)) {
+			visit(*e.renderable, (Proxy)element);
+		}
+	}
+
+	for (auto&& child : c.children) {
+		if (child != Null) {
+			_query(child, test, visit);
+		}
+	}
+}
+
+void LooseQuadtree::query(const BoundsTest& test, const Visitor& visit) const {
+	if (mElementCount > 0) {
+		_query(0, test, visit);
+	}
+}
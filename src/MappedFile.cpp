@@ -0,0 +1,95 @@
+#ifdef PLATFORM_WIN32
+#include "dojo_win_header.h"
+#endif
+
+#include "MappedFile.h"
+
+#include "Platform.h"
+
+#ifndef PLATFORM_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Dojo;
+
+//smaller than or equal to the page size of every platform
+static const size_t PREFETCH_STRIDE = 4096;
+
+MappedFile::MappedFile(utf::string_view path) {
+#ifdef PLATFORM_WIN32
+	auto file = CreateFileW(String::toUTF16(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file != INVALID_HANDLE_VALUE) {
+		mFileHandle = file;
+
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) and size.QuadPart > 0) {
+			mMappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+			if (mMappingHandle) {
+				mData = (const uint8_t*)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+				mSize = mData ? (size_t)size.QuadPart : 0;
+			}
+		}
+	}
+#else
+	auto file = open(path.copy().bytes().c_str(), O_RDONLY);
+
+	if (file >= 0) {
+		struct stat info;
+		if (fstat(file, &info) == 0 and info.st_size > 0) {
+			auto data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+			if (data != MAP_FAILED) {
+				mData = (const uint8_t*)data;
+				mSize = (size_t)info.st_size;
+			}
+		}
+
+		//the mapping stays valid without the descriptor
+		close(file);
+	}
+#endif
+
+	mMapped = mData != nullptr;
+
+	//eg. files in archives
+	if (not mMapped) {
+		mBuffer = Platform::singleton().loadFileContent(path);
+		mData = mBuffer.data();
+		mSize = mBuffer.size();
+	}
+}
+
+MappedFile::~MappedFile() {
+#ifdef PLATFORM_WIN32
+	if (mMapped) {
+		UnmapViewOfFile(mData);
+	}
+
+	if (mMappingHandle) {
+		CloseHandle(mMappingHandle);
+	}
+
+	if (mFileHandle) {
+		CloseHandle(mFileHandle);
+	}
+#else
+	if (mMapped) {
+		munmap((void*)mData, mSize);
+	}
+#endif
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const {
+	DEBUG_ASSERT(offset + size <= mSize, "The range is out of the file");
+
+	//reading a byte of each page makes the OS load it now
+	volatile uint8_t sink = 0;
+	for (auto i = offset; i < offset + size; i += PREFETCH_STRIDE) {
+		sink ^= mData[i];
+	}
+}
@@ -1,10 +1,16 @@
 #include "Mesh.h"
 
 #include "Platform.h"
+#include "Renderer.h"
+#include "StreamingBuffer.h"
 #include "Shader.h"
+#include "ResourceGroup.h"
+#include "MeshPack.h"
+#include "MappedFile.h"
 #include "dojomath.h"
 #include "PrimitiveMode.h"
 #include "enum_cast.h"
+#include "range.h"
 
 #include <glad/glad.h>
 
@@ -27,7 +33,11 @@ static const VERTEX_FIELD_INFO[enum_cast(VertexField::_Count)] = {
 	{ GL_HALF_FLOAT, 2, false, 2 * sizeof(GLshort) },	// 	UV
 };
 
+//w is always 1, and the 4th short keeps the following fields aligned
+static const VertexFieldInfo QUANTIZED_POSITION_INFO = { GL_UNSIGNED_SHORT, 4, true, 4 * sizeof(GLushort) };
+
 bool Mesh::gBufferBindingsDirty = true;
+uint32_t Mesh::gVertexArrayHits = 0, Mesh::gVertexArrayMisses = 0;
 
 Mesh::Mesh(optional_ref<ResourceGroup> creator /*= nullptr */) :
 	Resource(creator) {
@@ -51,10 +61,28 @@ Mesh::Mesh(optional_ref<ResourceGroup> creator, utf::string_view filePath) :
 	setIndexByteSize(sizeof(GLushort));
 }
 
+Mesh::Mesh(optional_ref<ResourceGroup> creator, std::shared_ptr<MeshPack> pack, uint32_t entry) :
+	Resource(creator, pack->getPath()),
+	mPack(std::move(pack)),
+	mPackEntry(entry) {
+	//set all fields to max
+	for (auto&& offset : vertexFieldOffset) {
+		offset = 0xff;
+	}
+
+	//default index size is 16
+	setIndexByteSize(sizeof(GLushort));
+}
+
 Mesh::~Mesh() {
 	if (loaded) {
 		onUnload();
 	}
+
+	//prepared but never loaded
+	if (prepared and mPack) {
+		mPack->release();
+	}
 }
 
 void Mesh::destroyBuffers() {
@@ -81,6 +109,21 @@ void Mesh::begin(IndexType extimatedVerts /*= 1 */) {
 	editing = true;
 }
 
+void Mesh::_abandonEdit() {
+	DEBUG_ASSERT(isEditing(), "_abandonEdit: this Mesh is not in Edit mode");
+
+	vertices.clear();
+	indices.clear();
+
+	vertexCount = indexCount = 0;
+	currentVertex = nullptr;
+
+	bounds = AABB::Invalid;
+	vertexTransparency = false;
+
+	editing = false;
+}
+
 void Mesh::beginAppend() {
 	DEBUG_ASSERT(not isEditing(), "begin: this Mesh is already in Edit mode");
 	DEBUG_ASSERT(dynamic, "can't call append() on a static mesh");
@@ -116,7 +159,13 @@ void Mesh::setVertexFieldEnabled(VertexField f) {
 	DEBUG_ASSERT(not editing, "setVertexFieldEnabled must be called BEFORE begin!");
 
 	vertexFieldOffset[enum_cast(f)] = vertexSize;
-	vertexSize += VERTEX_FIELD_INFO[enum_cast(f)].bytes;
+	vertexSize += getVertexFieldSize(f, positionQuantized);
+}
+
+uint8_t Mesh::getVertexFieldSize(VertexField f, bool positionQuantized /*= false*/) {
+	return (positionQuantized and f == VertexField::Position3D) ?
+		QUANTIZED_POSITION_INFO.bytes :
+		VERTEX_FIELD_INFO[enum_cast(f)].bytes;
 }
 
 void Mesh::setVertexFields(const std::initializer_list<VertexField>& fs) {
@@ -130,6 +179,15 @@ void Mesh::setDynamic(bool d) {
 	dynamic = d;
 }
 
+void Mesh::setStreaming(bool s) {
+	DEBUG_ASSERT(not editing, "setStreaming must be called BEFORE begin!");
+
+	streaming = s;
+	if (streaming) {
+		dynamic = true;
+	}
+}
+
 void Mesh::index(IndexType idx) {
 	DEBUG_ASSERT(isEditing(), "index: this Mesh is not in Edit mode");
 	DEBUG_ASSERT(idx <= indexMaxValue, "index: the index passed is too big to be contained in this mesh's index format, see setIndexByteSize");
@@ -170,6 +228,8 @@ void Mesh::_prepareVertex(const Vector& v) {
 }
 
 Mesh::IndexType Mesh::vertex(const Vector& v) {
+	DEBUG_ASSERT(not positionQuantized, "vertex: a quantized mesh can't be edited");
+
 	_prepareVertex(v);
 
 	if (isVertexFieldEnabled(VertexField::Position3D)) {
@@ -252,8 +312,11 @@ void Mesh::bindVertexFormat(const Shader& shader) {
 	for (auto&& attribute : shader.getAttributes()) {
 		DEBUG_ASSERT(isVertexFieldEnabled(attribute.builtInAttribute), "This mesh doesn't provide a required attribute");
 
-		auto offset = (void*)vertexFieldOffset[enum_cast(attribute.builtInAttribute)];
-		auto& field = VERTEX_FIELD_INFO[enum_cast(attribute.builtInAttribute)];
+		//streamed vertices start somewhere in the middle of the ring
+		auto offset = (void*)(vertexFieldOffset[enum_cast(attribute.builtInAttribute)] + (streamed ? streamVertexOffset : 0));
+		auto& field = (positionQuantized and attribute.builtInAttribute == VertexField::Position3D) ?
+			QUANTIZED_POSITION_INFO :
+			VERTEX_FIELD_INFO[enum_cast(attribute.builtInAttribute)];
 
 		glEnableVertexAttribArray(attribute.location);
 		glVertexAttribPointer(
@@ -266,6 +329,59 @@ void Mesh::bindVertexFormat(const Shader& shader) {
 	}
 }
 
+void Mesh::bindVertexArray(const Shader& shader) {
+	auto layout = shader.getVertexLayout();
+
+	if (streamed or layout == 0) {
+		Platform::singleton().getRenderer().bindDefaultVertexArray();
+		bind();
+		bindVertexFormat(shader);
+		return;
+	}
+
+	auto elem = std::find_if(mVertexArrays.begin(), mVertexArrays.end(), [layout](const VertexArray& vertexArray) {
+		return vertexArray.layout == layout;
+	});
+
+	if (elem != mVertexArrays.end()) {
+		std::rotate(mVertexArrays.begin(), elem, elem + 1);
+		glBindVertexArray(mVertexArrays.front().handle);
+		gBufferBindingsDirty = false;
+
+#ifndef PUBLISH
+		++gVertexArrayHits;
+#endif
+		return;
+	}
+
+	//replace the least recently used
+	if (mVertexArrays.size() == MAX_VERTEX_ARRAYS) {
+		glDeleteVertexArrays(1, &mVertexArrays.back().handle);
+		mVertexArrays.pop_back();
+	}
+
+	VertexArray vertexArray = { layout, 0 };
+	glGenVertexArrays(1, &vertexArray.handle);
+	mVertexArrays.insert(mVertexArrays.begin(), vertexArray);
+
+	//the VAO records the index buffer and the attribute pointers
+	glBindVertexArray(vertexArray.handle);
+	bind();
+	bindVertexFormat(shader);
+
+#ifndef PUBLISH
+	++gVertexArrayMisses;
+#endif
+}
+
+void Mesh::_destroyVertexArrays() {
+	for (auto&& vertexArray : mVertexArrays) {
+		glDeleteVertexArrays(1, &vertexArray.handle);
+	}
+
+	mVertexArrays.clear();
+}
+
 bool Mesh::end() {
 	DEBUG_ASSERT(editing, "Can't call end() before begin()!");
 	editing = false;
@@ -277,69 +393,192 @@ bool Mesh::end() {
 		return false;
 	}
 
+	streamed = streaming and Platform::singleton().getRenderer().getVertexStream().is_some();
+
+	if (streamed) {
+		_stream();
+	}
+	else {
+		_uploadBuffers(vertices.data(), vertices.size(), indices.data(), indices.size());
+	}
+
+	loaded = true;
+
+	currentVertex = nullptr;
+
+	//geometric hints
+	center = bounds.getCenter();
+	dimensions = bounds.getSize();
+
+	if (not dynamic) { //won't be updated ever again
+		destroyBuffers();
+	}
+
+	gBufferBindingsDirty = true;
+	return loaded;
+}
+
+void* Mesh::beginStream(IndexType count) {
+	DEBUG_ASSERT(streaming, "beginStream: this Mesh is not a streaming mesh");
+	DEBUG_ASSERT(not isEditing(), "beginStream: this Mesh is already in Edit mode");
+	DEBUG_ASSERT(count > 0, "beginStream: a stream must contain at least one vertex");
+
+	auto ring = Platform::singleton().getRenderer().getVertexStream().to_raw_ptr();
+	auto bytes = (uint64_t)count * vertexSize;
+	if (not ring or bytes > ring->getSize()) {
+		return nullptr;
+	}
+
+	//the data only lives in the ring, there's nothing to stream again
+	vertices.clear();
+	indices.clear();
+	vertexCount = count;
+	indexCount = 0;
+
+	auto allocation = ring->map((uint32_t)bytes);
+	streamVertexOffset = allocation.offset;
+	streamVertexFrame = ring->getFrame();
+
+	editing = true;
+	return allocation.data;
+}
+
+bool Mesh::endStream() {
+	DEBUG_ASSERT(editing, "Can't call endStream() before beginStream()!");
+	editing = false;
+
+	Platform::singleton().getRenderer().getVertexStream().unwrap().unmap();
+
+	streamed = loaded = true;
+
+	//the vertices were never seen by the CPU
+	bounds = AABB::Invalid;
+	center = bounds.getCenter();
+	dimensions = bounds.getSize();
+	vertexTransparency = false;
+
+	//the ring was left bound in place of the current mesh
+	gBufferBindingsDirty = true;
+	return loaded;
+}
+
+void Mesh::_uploadBuffers(const uint8_t* vertexData, size_t vertexBytes, const uint8_t* indexData, size_t indexBytes) {
+	//the index buffer binding belongs to the bound VAO, which can be another mesh's
+	Platform::singleton().getRenderer().bindDefaultVertexArray();
+
 	//create the VBO
 	if (not vertexHandle) {
 		glGenBuffers(1, &vertexHandle);
 	}
 
+	//dynamic meshes respecify the whole buffer, letting the driver orphan the storage the GPU might still be reading
 	uint32_t usage = (dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
 	glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), usage);
-
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, usage);
 
 	//create the IBO
-	if (isIndexed()) { //we support unindexed meshes
+	if (indexBytes > 0 or indexHandle) { //we support unindexed meshes
 		if (not indexHandle) {
 			glGenBuffers(1, &indexHandle);
+
+			//the VAOs were recorded without an index buffer
+			_destroyVertexArrays();
 		}
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexHandle);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size(), indices.data(), usage);
-
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, usage);
 	}
+}
 
-	loaded = true;
+void Mesh::_stream() {
+	auto& renderer = Platform::singleton().getRenderer();
 
-	currentVertex = nullptr;
+	//mapping the index ring binds it to the bound VAO
+	renderer.bindDefaultVertexArray();
 
-	//geometric hints
-	center = bounds.getCenter();
-	dimensions = bounds.getSize();
+	auto& vertexRing = renderer.getVertexStream().unwrap();
+	auto vertexAllocation = vertexRing.map((uint32_t)vertices.size());
+	memcpy(vertexAllocation.data, vertices.data(), vertices.size());
+	vertexRing.unmap();
 
-	if (not dynamic) { //won't be updated ever again
-		destroyBuffers();
+	streamVertexOffset = vertexAllocation.offset;
+	streamVertexFrame = vertexRing.getFrame();
+
+	if (isIndexed()) {
+		auto& indexRing = renderer.getIndexStream().unwrap();
+		auto indexAllocation = indexRing.map((uint32_t)indices.size());
+		memcpy(indexAllocation.data, indices.data(), indices.size());
+		indexRing.unmap();
+
+		streamIndexOffset = indexAllocation.offset;
+		streamIndexFrame = indexRing.getFrame();
 	}
 
+	//the rings were left bound in place of the current mesh
 	gBufferBindingsDirty = true;
-	return loaded;
+}
+
+bool Mesh::_isStreamValid() const {
+	auto& renderer = Platform::singleton().getRenderer();
+
+	return
+		streamVertexFrame == renderer.getVertexStream().unwrap().getFrame() and
+		(not isIndexed() or streamIndexFrame == renderer.getIndexStream().unwrap().getFrame());
 }
 
 void Mesh::bind() {
-	glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, isIndexed() ? indexHandle : 0); //only bind the index buffer if existing (duh)
+	if (streamed) {
+		//the data written in a previous frame might have been overwritten already
+		if (not _isStreamValid()) {
+			DEBUG_ASSERT(vertices.size() > 0, "The vertices written by beginStream() were recycled, they have to be written again each frame");
+			_stream();
+		}
+
+		auto& renderer = Platform::singleton().getRenderer();
+		glBindBuffer(GL_ARRAY_BUFFER, renderer.getVertexStream().unwrap().getGLHandle());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, isIndexed() ? renderer.getIndexStream().unwrap().getGLHandle() : 0);
+	}
+	else {
+		glBindBuffer(GL_ARRAY_BUFFER, vertexHandle);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, isIndexed() ? indexHandle : 0); //only bind the index buffer if existing (duh)
+	}
 
 	gBufferBindingsDirty = false;
 }
 
-bool Mesh::onLoad() {
-	DEBUG_ASSERT(not isLoaded(), "onLoad: Mesh is already loaded");
-
-	if (not isReloadable()) {
-		return false;
+void Mesh::_resetFormat() {
+	vertexSize = 0;
+	for (auto&& offset : vertexFieldOffset) {
+		offset = 0xff;
 	}
 
-	//load binary mesh
-	auto buf = Platform::singleton().loadFileContent(filePath);
+	positionQuantized = false;
+	positionScale = Vector::One;
+	positionOffset = Vector::Zero;
+}
 
-	DEBUG_ASSERT_INFO(buf.size() > 0, "onLoad: cannot find or read file", "path = " + filePath);
+bool _canRead(const uint8_t* ptr, const uint8_t* end, uint64_t bytes) {
+	return ptr <= end and (uint64_t)(end - ptr) >= bytes;
+}
 
-	uint8_t* ptr = buf.data();
+bool Mesh::_readBinary(const uint8_t*& ptr, const uint8_t* bufferEnd) {
+	//the format is read again when reloading, and optimize() might have changed it
+	_resetFormat();
 
-	//index size
-	setIndexByteSize(*ptr++);
+	//index size, triangle mode and fields
+	if (not _canRead(ptr, bufferEnd, 2 + enum_cast(VertexField::_Count))) {
+		return false;
+	}
 
-	//triangle mode
-	setTriangleMode((PrimitiveMode)*ptr++);
+	uint8_t loadedIndexSize = *ptr++;
+	uint8_t loadedTriangleMode = *ptr++;
+
+	if ((loadedIndexSize != 1 and loadedIndexSize != 2 and loadedIndexSize != 4) or loadedTriangleMode > enum_cast(PrimitiveMode::PointList)) {
+		return false;
+	}
+
+	setIndexByteSize(loadedIndexSize);
+	setTriangleMode((PrimitiveMode)loadedTriangleMode);
 
 	//fields
 	for (int i = 0; i < (int)VertexField::_Count; ++i) {
@@ -348,7 +587,11 @@ bool Mesh::onLoad() {
 		}
 	}
 
-	//max and min
+	//max, min, vertex count and index count
+	if (not _canRead(ptr, bufferEnd, 2 * sizeof(Vector) + sizeof(IndexType) + sizeof(uint32_t))) {
+		return false;
+	}
+
 	Vector loadedMax;
 	memcpy(&loadedMax, ptr, sizeof(Vector));
 	ptr += sizeof(Vector);
@@ -358,26 +601,34 @@ bool Mesh::onLoad() {
 	ptr += sizeof(Vector);
 
 	//vertex count
-	IndexType vc = *((IndexType*)ptr);
+	IndexType vc;
+	memcpy(&vc, ptr, sizeof(IndexType));
 	ptr += sizeof(IndexType);
 
 	//index count
-	uint32_t ic = *((uint32_t*)ptr);
+	uint32_t ic;
+	memcpy(&ic, ptr, sizeof(uint32_t));
 	ptr += sizeof(uint32_t);
 
+	uint64_t vertexBytes = (uint64_t)vc * vertexSize, indexBytes = (uint64_t)ic * indexSize;
+	if (vc == 0 or vc >= indexMaxValue or not _canRead(ptr, bufferEnd, vertexBytes) or not _canRead(ptr + vertexBytes, bufferEnd, indexBytes)) {
+		return false;
+	}
+
 	setDynamic(false);
 
 	begin(vc);
 
 	//grab vertex data
-	vertices.resize(vc * vertexSize);
-	memcpy((char*)vertices.data(), ptr, vc * vertexSize);
-	ptr += vc * vertexSize;
+	vertices.resize((size_t)vertexBytes);
+	memcpy((char*)vertices.data(), ptr, (size_t)vertexBytes);
+	ptr += vertexBytes;
 
 	//grab index data
 	if (ic) {
-		indices.resize(ic * indexSize);
-		memcpy((char*)indices.data(), ptr, ic * indexSize);
+		indices.resize((size_t)indexBytes);
+		memcpy((char*)indices.data(), ptr, (size_t)indexBytes);
+		ptr += indexBytes;
 	}
 
 	bounds.max = loadedMax;
@@ -385,11 +636,217 @@ bool Mesh::onLoad() {
 
 	vertexCount = vc;
 	indexCount = ic;
+	return true;
+}
+
+void _logOptimization(const utf::string& path, uint32_t lod, const MeshOptimizer::Report& report) {
+	DEBUG_MESSAGE(path + " LOD " + utf::to_string(lod) + ": ACMR " + utf::to_string(report.ACMRBefore) + " -> " + utf::to_string(report.ACMRAfter));
+}
+
+bool Mesh::_readFile() {
+	//load binary mesh, _readBinary copies it straight from the mapping
+	MappedFile file(filePath);
+
+	DEBUG_ASSERT_INFO(file.isValid(), "onLoad: cannot find or read file", "path = " + filePath);
+
+	if (not file.isValid()) {
+		return false;
+	}
+
+	const uint8_t* ptr = file.getData();
+	const uint8_t* bufferEnd = file.getData() + file.getSize();
+
+	//_readBinary only begins the mesh when all of its data is there
+	if (not _readBinary(ptr, bufferEnd)) {
+		DEBUG_MESSAGE("onLoad: the mesh data is truncated or invalid, path = " + filePath);
+		return false;
+	}
+
+	//the lower LODs can follow: their count, then the screen size and the data of each of them, in the same format
+	if (ptr < bufferEnd) {
+		uint8_t lodCount = *ptr++;
+
+		for (auto i : range(lodCount)) {
+			auto lod = make_unique<Mesh>();
+			float screenSize = 0;
+
+			bool valid = _canRead(ptr, bufferEnd, sizeof(float));
+			if (valid) {
+				memcpy(&screenSize, ptr, sizeof(float));
+				ptr += sizeof(float);
+
+				valid = lod->_readBinary(ptr, bufferEnd);
+			}
+
+			if (not valid) {
+				DEBUG_MESSAGE("onLoad: the LOD data is truncated or invalid, path = " + filePath + ", LOD = " + utf::to_string(i + 1));
+				_abandonEdit();
+				mReadLODs.clear();
+				return false;
+			}
+
+			mReadLODs.push_back({ std::move(lod), screenSize });
+		}
+	}
+
+	//the optimization runs here, on the loading threads
+	if (creator.is_some() and creator.unwrap().optimizeMeshes) {
+		auto& group = creator.unwrap();
+
+		auto report = optimize(group.quantizeMeshPositions);
+		if (group.logchanges) {
+			_logOptimization(filePath, 0, report);
+		}
+
+		for (auto i : range(mReadLODs.size())) {
+			report = mReadLODs[i].mesh->optimize(group.quantizeMeshPositions);
+			if (group.logchanges) {
+				_logOptimization(filePath, (uint32_t)i + 1, report);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Mesh::_loadFromPack() {
+	if (not prepared and not mPack->acquire()) {
+		return false;
+	}
+
+	prepared = false;
+
+	_loadPackEntry(*mPack, mPackEntry);
+
+	//the LODs are stored after the mesh, from the most detailed
+	for (auto i : range(mPack->getEntryCount())) {
+		auto& entry = mPack->getEntry(i);
+		if (entry.lodOf == mPackEntry) {
+			auto lod = make_unique<Mesh>();
+			lod->_loadPackEntry(*mPack, i);
+			addLOD(std::move(lod), entry.lodScreenSize);
+		}
+	}
+
+	//the GL buffers have their copy now
+	mPack->release();
+	return loaded;
+}
+
+void Mesh::_loadPackEntry(const MeshPack& pack, uint32_t entryIndex) {
+	auto& entry = pack.getEntry(entryIndex);
+
+	//the quantization changes the size of the position field
+	_resetFormat();
+	positionQuantized = entry.positionQuantized != 0;
+	if (positionQuantized) {
+		positionScale = { entry.positionScale[0], entry.positionScale[1], entry.positionScale[2] };
+		positionOffset = { entry.positionOffset[0], entry.positionOffset[1], entry.positionOffset[2] };
+	}
+
+	setIndexByteSize(entry.indexSize);
+	setTriangleMode((PrimitiveMode)entry.triangleMode);
+
+	for (auto field : range(enum_cast(VertexField::_Count))) {
+		if (entry.fields & (1 << field)) {
+			setVertexFieldEnabled((VertexField)field);
+		}
+	}
+
+	//MeshPack validated the format against the stride when it was opened
+	DEBUG_ASSERT_INFO(vertexSize == entry.vertexSize, "The vertex format of the pack entry is invalid", "path = " + pack.getPath() + ", entry = " + pack.getEntryName(entryIndex));
+
+	bounds.min = { entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2] };
+	bounds.max = { entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2] };
+
+	vertexCount = entry.vertexCount;
+	indexCount = entry.indexCount;
+
+	setDynamic(false);
+	streamed = false;
+
+	//no CPU copy is kept, GL reads straight from the mapping
+	_uploadBuffers(
+		pack.getData() + entry.vertexOffset,
+		entry.vertexCount * entry.vertexSize,
+		pack.getData() + entry.indexOffset,
+		entry.indexCount * entry.indexSize);
+
+	loaded = true;
+
+	//geometric hints
+	center = bounds.getCenter();
+	dimensions = bounds.getSize();
+
+	gBufferBindingsDirty = true;
+}
+
+void Mesh::onPrepare() {
+	DEBUG_ASSERT(not isLoaded(), "onLoad: Mesh is already loaded");
+
+	if (mPack) {
+		//map the pack and read the pages of this mesh on the worker, so that the upload doesn't wait for the disk
+		prepared = mPack->acquire();
+		if (prepared) {
+			mPack->prefetch(mPackEntry);
+		}
+	}
+	else if (isReloadable()) {
+		prepared = _readFile();
+	}
+}
+
+bool Mesh::onLoad() {
+	DEBUG_ASSERT(not isLoaded(), "onLoad: Mesh is already loaded");
+
+	if (not isReloadable()) {
+		return false;
+	}
+
+	if (mPack) {
+		return _loadFromPack();
+	}
+
+	if (not prepared and not _readFile()) {
+		return false;
+	}
+
+	prepared = false;
 
 	//push over to GPU
+	for (auto&& lod : mReadLODs) {
+		if (lod.mesh->end()) {
+			addLOD(std::move(lod.mesh), lod.screenSize);
+		}
+	}
+	mReadLODs.clear();
+
 	return end();
 }
 
+void Mesh::addLOD(Unique<Mesh> lod, float screenSize) {
+	DEBUG_ASSERT(lod and lod->isLoaded(), "The LOD must be a loaded Mesh");
+	DEBUG_ASSERT(screenSize > 0 and screenSize < getLODScreenSize(getLODCount() - 1), "The LODs must be added by decreasing screen size");
+
+	mLODs.push_back({ std::move(lod), screenSize });
+}
+
+uint32_t Mesh::selectLOD(float screenSize, uint32_t currentLOD, float hysteresis) const {
+	uint32_t lod = 0;
+
+	for (auto&& next : mLODs) {
+		//move the thresholds away from the current LOD, so that sizes around a threshold don't switch back and forth
+		float threshold = next.screenSize * (lod < currentLOD ? 1.f + hysteresis : 1.f - hysteresis);
+
+		if (screenSize >= threshold) {
+			break;
+		}
+		++lod;
+	}
+
+	return lod;
+}
+
 void Mesh::onUnload(bool soft /*= false */) {
 	DEBUG_ASSERT(isLoaded(), "onUnload: Mesh is not loaded");
 
@@ -402,14 +859,102 @@ void Mesh::onUnload(bool soft /*= false */) {
 
 		vertexHandle = indexHandle = 0;
 
+		_destroyVertexArrays();
+
 		destroyBuffers(); //free CPU side memory
 
+		mLODs.clear();
+
 		gBufferBindingsDirty = true;
 		loaded = false;
 	}
 }
 
+MeshOptimizer::Report Mesh::optimize(bool quantizePositions /*= false*/) {
+	DEBUG_ASSERT(isEditing(), "optimize: this Mesh is not in Edit mode");
+	DEBUG_ASSERT(not positionQuantized, "optimize: this Mesh was already quantized");
+
+	MeshOptimizer::Report report;
+
+	if (triangleMode == PrimitiveMode::TriangleList and isIndexed() and getVertexCount() > 0) {
+		std::vector<uint32_t> triangles(getIndexCount());
+		for (auto i : range(triangles.size())) {
+			triangles[i] = getIndex((int)i);
+		}
+
+		report.ACMRBefore = MeshOptimizer::computeACMR(triangles, getVertexCount());
+
+		MeshOptimizer::optimizeVertexCache(triangles, getVertexCount());
+
+		if (isVertexFieldEnabled(VertexField::Position3D)) {
+			std::vector<Vector> positions(getVertexCount());
+			for (auto i : range(positions.size())) {
+				positions[i] = getVertex((int)i);
+			}
+
+			MeshOptimizer::optimizeOverdraw(triangles, positions);
+		}
+
+		vertexCount = MeshOptimizer::optimizeVertexFetch(triangles, vertices, vertexSize);
+
+		for (auto i : range(triangles.size())) {
+			setIndex((int)i, triangles[i]);
+		}
+
+		report.ACMRAfter = MeshOptimizer::computeACMR(triangles, getVertexCount());
+	}
+
+	if (quantizePositions and isVertexFieldEnabled(VertexField::Position3D) and getVertexCount() > 0) {
+		_quantizePositions();
+	}
+
+	return report;
+}
+
+void Mesh::_quantizePositions() {
+	auto positionField = vertexFieldOffset[enum_cast(VertexField::Position3D)];
+	auto positionBytes = VERTEX_FIELD_INFO[enum_cast(VertexField::Position3D)].bytes;
+	auto quantizedSize = (uint8_t)(vertexSize - positionBytes + QUANTIZED_POSITION_INFO.bytes);
+
+	positionOffset = bounds.min;
+	positionScale = bounds.max - bounds.min;
+
+	std::vector<uint8_t> quantized(getVertexCount() * quantizedSize);
+	for (auto i : range(getVertexCount())) {
+		auto src = vertices.data() + i * vertexSize;
+		auto dest = quantized.data() + i * quantizedSize;
+
+		Vector position;
+		memcpy(&position, src + positionField, sizeof(Vector));
+
+		uint16_t packed[4] = { 0, 0, 0, 0xffff };
+		for (auto axis : range(3)) {
+			if (positionScale[axis] > 0) {
+				auto normalized = glm::clamp((position[axis] - positionOffset[axis]) / positionScale[axis], 0.f, 1.f);
+				packed[axis] = (uint16_t)(normalized * 65535.f + 0.5f);
+			}
+		}
+
+		//the fields after the position move back
+		memcpy(dest, src, positionField);
+		memcpy(dest + positionField, packed, sizeof(packed));
+		memcpy(dest + positionField + sizeof(packed), src + positionField + positionBytes, vertexSize - positionField - positionBytes);
+	}
+
+	for (auto&& offset : vertexFieldOffset) {
+		if (offset != 0xff and offset > positionField) {
+			offset = offset - positionBytes + QUANTIZED_POSITION_INFO.bytes;
+		}
+	}
+
+	vertices = std::move(quantized);
+	vertexSize = quantizedSize;
+	positionQuantized = true;
+}
+
 Vector& Mesh::getVertex(int idx) {
+	DEBUG_ASSERT(not positionQuantized, "getVertex: the positions of this mesh are quantized");
+
 	auto field = isVertexFieldEnabled(VertexField::Position3D) ? VertexField::Position3D : VertexField::Position3D;
 	auto offset = vertexFieldOffset[enum_cast(field)];
 	uint8_t* ptr = (uint8_t*)vertices.data() + (idx * vertexSize) + offset;
@@ -490,6 +1035,8 @@ void Mesh::cutSection(IndexType i1, IndexType i2) {
 }
 
 Unique<Mesh> Mesh::cloneWithSameFormat() const {
+	DEBUG_ASSERT(not positionQuantized, "Can't clone the format of a quantized mesh");
+
 	auto c = make_unique<Mesh>();
 
 	c->setIndexByteSize(indexSize);
@@ -0,0 +1,293 @@
+#include "MeshOptimizer.h"
+
+#include "range.h"
+
+using namespace Dojo;
+
+static const uint32_t NO_VERTEX = UINT32_MAX;
+
+bool _isCached(const std::vector<uint32_t>& stamps, uint32_t vertex, uint32_t time, uint32_t cacheSize) {
+	//a FIFO cache keeps a vertex until cacheSize other vertices have been transformed after it
+	return time - stamps[vertex] <= cacheSize;
+}
+
+///picks the next vertex to fan around, as in Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+uint32_t _nextFanningVertex(
+	const std::vector<uint32_t>& candidates,
+	std::vector<uint32_t>& deadEnds,
+	const std::vector<uint32_t>& liveTriangles,
+	const std::vector<uint32_t>& stamps,
+	uint32_t time,
+	uint32_t cacheSize,
+	uint32_t& cursor) {
+
+	//prefer the oldest vertex in the cache that will still be there after its remaining triangles are emitted
+	uint32_t best = NO_VERTEX;
+	int bestPriority = -1;
+	for (auto vertex : candidates) {
+		if (liveTriangles[vertex] == 0) {
+			continue;
+		}
+
+		int priority = 0;
+		if (time - stamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+			priority = (int)(time - stamps[vertex]);
+		}
+
+		if (priority > bestPriority) {
+			best = vertex;
+			bestPriority = priority;
+		}
+	}
+
+	if (best != NO_VERTEX) {
+		return best;
+	}
+
+	//dead end: go back to a recently used vertex, or to the first one still having triangles
+	while (deadEnds.size() > 0) {
+		auto vertex = deadEnds.back();
+		deadEnds.pop_back();
+
+		if (liveTriangles[vertex] > 0) {
+			return vertex;
+		}
+	}
+
+	for (; cursor < liveTriangles.size(); ++cursor) {
+		if (liveTriangles[cursor] > 0) {
+			return cursor;
+		}
+	}
+
+	return NO_VERTEX;
+}
+
+float MeshOptimizer::computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize /*= DefaultCacheSize*/) {
+	auto triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return 0;
+	}
+
+	std::vector<uint32_t> stamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1, misses = 0;
+
+	for (auto vertex : indices) {
+		if (not _isCached(stamps, vertex, time, cacheSize)) {
+			stamps[vertex] = time++;
+			++misses;
+		}
+	}
+
+	return (float)misses / (float)triangleCount;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize /*= DefaultCacheSize*/) {
+	DEBUG_ASSERT(indices.size() % 3 == 0, "The indices are not a triangle list");
+
+	auto triangleCount = (uint32_t)indices.size() / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	//the triangles using each vertex
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (auto vertex : indices) {
+		DEBUG_ASSERT(vertex < vertexCount, "Index out of bounds");
+		++offsets[vertex + 1];
+	}
+
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (auto i : range(vertexCount)) {
+		liveTriangles[i] = offsets[i + 1];
+		offsets[i + 1] += offsets[i];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		auto next = offsets;
+		for (auto i : range(indices.size())) {
+			adjacency[next[indices[i]]++] = (uint32_t)i / 3;
+		}
+	}
+
+	std::vector<uint32_t> stamps(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds, candidates, result;
+	result.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1, cursor = 0;
+	auto fanning = _nextFanningVertex(candidates, deadEnds, liveTriangles, stamps, time, cacheSize, cursor);
+
+	while (fanning != NO_VERTEX) {
+		candidates.clear();
+
+		//emit all the triangles around the fanning vertex
+		for (auto i = offsets[fanning]; i < offsets[fanning + 1]; ++i) {
+			auto triangle = adjacency[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (auto k : range(3)) {
+				auto vertex = indices[triangle * 3 + k];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+
+				if (not _isCached(stamps, vertex, time, cacheSize)) {
+					stamps[vertex] = time++;
+				}
+			}
+
+			emitted[triangle] = true;
+		}
+
+		fanning = _nextFanningVertex(candidates, deadEnds, liveTriangles, stamps, time, cacheSize, cursor);
+	}
+
+	DEBUG_ASSERT(result.size() == indices.size(), "Some triangles were not emitted");
+	indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vector>& positions, float threshold /*= 1.05f*/, uint32_t cacheSize /*= DefaultCacheSize*/) {
+	DEBUG_ASSERT(indices.size() % 3 == 0, "The indices are not a triangle list");
+
+	auto triangleCount = (uint32_t)indices.size() / 3;
+	auto vertexCount = (uint32_t)positions.size();
+	if (triangleCount < 2) {
+		return;
+	}
+
+	auto meshACMR = computeACMR(indices, vertexCount, cacheSize);
+
+	//split the order in clusters that can be moved around without losing too much of the cache:
+	//the order is split where the cache is cold anyway, and where the cluster so far, started with a cold cache, is efficient enough
+	std::vector<uint32_t> clusterStarts;
+	std::vector<uint32_t> stamps(vertexCount, 0), clusterStamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1, clusterTime = cacheSize + 1;
+	uint32_t clusterMisses = 0, clusterTriangles = 0;
+
+	for (auto triangle : range(triangleCount)) {
+		bool cold = true;
+		for (auto k : range(3)) {
+			auto vertex = indices[triangle * 3 + k];
+			if (_isCached(stamps, vertex, time, cacheSize)) {
+				cold = false;
+			}
+			else {
+				stamps[vertex] = time++;
+			}
+		}
+
+		if (clusterTriangles == 0 or cold or clusterMisses <= threshold * meshACMR * clusterTriangles) {
+			clusterStarts.push_back(triangle);
+			clusterMisses = clusterTriangles = 0;
+
+			//empty the cluster's cache
+			clusterTime += cacheSize + 1;
+		}
+
+		for (auto k : range(3)) {
+			auto vertex = indices[triangle * 3 + k];
+			if (not _isCached(clusterStamps, vertex, clusterTime, cacheSize)) {
+				clusterStamps[vertex] = clusterTime++;
+				++clusterMisses;
+			}
+		}
+
+		++clusterTriangles;
+	}
+
+	if (clusterStarts.size() < 2) {
+		return;
+	}
+
+	clusterStarts.push_back(triangleCount);
+	auto clusterCount = clusterStarts.size() - 1;
+
+	//area weighted centroids and normals
+	std::vector<Vector> centroids(clusterCount, Vector::Zero), normals(clusterCount, Vector::Zero);
+	std::vector<float> areas(clusterCount, 0.f);
+	Vector meshCentroid = Vector::Zero;
+	float meshArea = 0;
+
+	for (auto cluster : range(clusterCount)) {
+		for (auto triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle) {
+			auto& a = positions[indices[triangle * 3]];
+			auto& b = positions[indices[triangle * 3 + 1]];
+			auto& c = positions[indices[triangle * 3 + 2]];
+
+			auto normal = glm::cross(b - a, c - a);
+			auto area = glm::length(normal);
+
+			normals[cluster] += normal;
+			centroids[cluster] += (a + b + c) * (area / 3.f);
+			areas[cluster] += area;
+		}
+
+		meshCentroid += centroids[cluster];
+		meshArea += areas[cluster];
+	}
+
+	if (meshArea <= 0) {
+		return;
+	}
+
+	meshCentroid /= meshArea;
+
+	//the clusters that face away from the center are on the outside and hide the others, draw them first
+	std::vector<float> keys(clusterCount, 0.f);
+	for (auto cluster : range(clusterCount)) {
+		auto length = glm::length(normals[cluster]);
+		if (areas[cluster] > 0 and length > 0) {
+			auto centroid = centroids[cluster] / areas[cluster];
+			keys[cluster] = glm::dot(centroid - meshCentroid, normals[cluster] / length);
+		}
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for (auto i : range(clusterCount)) {
+		order[i] = (uint32_t)i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return keys[a] > keys[b];
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (auto cluster : order) {
+		result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+
+	indices = std::move(result);
+}
+
+uint32_t MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<uint8_t>& vertices, uint32_t vertexSize) {
+	DEBUG_ASSERT(vertexSize > 0 and vertices.size() % vertexSize == 0, "Invalid vertex size");
+
+	auto vertexCount = vertices.size() / vertexSize;
+
+	std::vector<uint32_t> remap(vertexCount, NO_VERTEX);
+	std::vector<uint8_t> reordered;
+	reordered.reserve(vertices.size());
+
+	uint32_t nextVertex = 0;
+	for (auto&& index : indices) {
+		DEBUG_ASSERT(index < vertexCount, "Index out of bounds");
+
+		if (remap[index] == NO_VERTEX) {
+			remap[index] = nextVertex++;
+
+			auto vertex = vertices.begin() + index * vertexSize;
+			reordered.insert(reordered.end(), vertex, vertex + vertexSize);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(reordered);
+	return nextVertex;
+}
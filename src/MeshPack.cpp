@@ -0,0 +1,245 @@
+#include "MeshPack.h"
+
+#include "Mesh.h"
+#include "MappedFile.h"
+#include "Platform.h"
+#include "FileStream.h"
+#include "enum_cast.h"
+#include "range.h"
+
+using namespace Dojo;
+
+static const char MAGIC[4] = { 'D', 'M', 'P', 'K' };
+
+static_assert(sizeof(MeshPack::Header) == 16, "The header must have no padding");
+static_assert(sizeof(MeshPack::Entry) == 96, "The entries must have no padding");
+
+uint64_t _align(uint64_t offset) {
+	return (offset + MeshPack::DataAlignment - 1) / MeshPack::DataAlignment * MeshPack::DataAlignment;
+}
+
+bool _isInFile(uint64_t offset, uint64_t size, size_t fileSize) {
+	return offset <= fileSize and size <= fileSize - offset;
+}
+
+//checks that the format of an entry is one a Mesh can have, and that its stride is the one GL will use
+bool _isFormatValid(const MeshPack::Entry& entry) {
+	if ((entry.fields >> enum_cast(VertexField::_Count)) != 0 or entry.triangleMode > enum_cast(PrimitiveMode::PointList)) {
+		return false;
+	}
+
+	//Mesh counts vertices and indices with ints
+	if (entry.vertexCount > INT_MAX or entry.indexCount > INT_MAX) {
+		return false;
+	}
+
+	if (entry.indexSize != 1 and entry.indexSize != 2 and entry.indexSize != 4) {
+		return false;
+	}
+
+	bool position2D = (entry.fields & (1 << enum_cast(VertexField::Position2D))) != 0;
+	bool position3D = (entry.fields & (1 << enum_cast(VertexField::Position3D))) != 0;
+	if (position2D == position3D or (entry.positionQuantized and not position3D)) {
+		return false;
+	}
+
+	uint32_t vertexSize = 0;
+	for (auto field : range(enum_cast(VertexField::_Count))) {
+		if (entry.fields & (1 << field)) {
+			vertexSize += Mesh::getVertexFieldSize((VertexField)field, entry.positionQuantized != 0);
+		}
+	}
+
+	return vertexSize == entry.vertexSize;
+}
+
+bool MeshPack::save(utf::string_view path, const std::vector<Source>& meshes) {
+	DEBUG_ASSERT(meshes.size() > 0 and meshes[0].lodScreenSize == 0, "The first mesh can't be a LOD");
+
+	std::vector<Entry> entries(meshes.size());
+	std::string names;
+
+	uint64_t tableSize = sizeof(Header) + sizeof(Entry) * meshes.size();
+	for (auto&& source : meshes) {
+		names += source.name.bytes();
+	}
+
+	//the data of each mesh follows the names
+	auto offset = _align(tableSize + names.size());
+	uint32_t nameOffset = (uint32_t)tableSize, parent = NotALOD;
+
+	for (auto i : range(meshes.size())) {
+		auto& source = meshes[i];
+		auto& mesh = *source.mesh;
+		auto& entry = entries[i];
+
+		DEBUG_ASSERT(mesh.vertices.size() == mesh.getVertexCount() * mesh.vertexSize, "The mesh data was already discarded");
+		DEBUG_ASSERT(mesh.indices.size() == mesh.getIndexCount() * mesh.indexSize, "The mesh data was already discarded");
+
+		entry.nameOffset = nameOffset;
+		entry.nameLength = (uint32_t)source.name.bytes().size();
+		nameOffset += entry.nameLength;
+
+		if (source.lodScreenSize > 0) {
+			DEBUG_ASSERT(parent != NotALOD, "A LOD must follow its mesh");
+			entry.lodOf = parent;
+		}
+		else {
+			entry.lodOf = NotALOD;
+			parent = (uint32_t)i;
+		}
+		entry.lodScreenSize = source.lodScreenSize;
+
+		entry.fields = 0;
+		for (auto field : range(enum_cast(VertexField::_Count))) {
+			if (mesh.isVertexFieldEnabled((VertexField)field)) {
+				entry.fields |= 1 << field;
+			}
+		}
+
+		entry.indexSize = mesh.indexSize;
+		entry.triangleMode = (uint8_t)mesh.getTriangleMode();
+		entry.vertexSize = mesh.vertexSize;
+		entry.positionQuantized = mesh.isPositionQuantized();
+		entry.vertexCount = mesh.getVertexCount();
+		entry.indexCount = mesh.getIndexCount();
+
+		for (auto axis : range(3)) {
+			entry.boundsMin[axis] = mesh.getBounds().min[axis];
+			entry.boundsMax[axis] = mesh.getBounds().max[axis];
+			entry.positionScale[axis] = mesh.getPositionScale()[axis];
+			entry.positionOffset[axis] = mesh.getPositionOffset()[axis];
+		}
+
+		entry.vertexOffset = offset;
+		offset = _align(offset + mesh.vertices.size());
+
+		entry.indexOffset = offset;
+		offset = _align(offset + mesh.indices.size());
+	}
+
+	std::vector<uint8_t> file((size_t)offset, 0);
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = Version;
+	header.entryCount = (uint32_t)entries.size();
+	header.entryOffset = sizeof(Header);
+
+	memcpy(file.data(), &header, sizeof(Header));
+	memcpy(file.data() + sizeof(Header), entries.data(), sizeof(Entry) * entries.size());
+	memcpy(file.data() + tableSize, names.data(), names.size());
+
+	for (auto i : range(meshes.size())) {
+		auto& mesh = *meshes[i].mesh;
+		memcpy(file.data() + entries[i].vertexOffset, mesh.vertices.data(), mesh.vertices.size());
+		memcpy(file.data() + entries[i].indexOffset, mesh.indices.data(), mesh.indices.size());
+	}
+
+	auto stream = Platform::singleton().getFile(path);
+	if (not stream or not stream->open(Stream::Access::WriteOnly)) {
+		return false;
+	}
+
+	stream->write(file.data(), (int)file.size());
+	stream->close();
+	return true;
+}
+
+MeshPack::MeshPack(utf::string_view path) :
+	mPath(path.copy()) {
+	MappedFile file(path);
+
+	mValid = file.isValid() and _readContents(file.getData(), file.getSize());
+	mFileSize = file.getSize();
+
+	DEBUG_ASSERT_INFO(mValid, "Invalid mesh pack", "path = " + mPath);
+}
+
+MeshPack::~MeshPack() {
+	DEBUG_ASSERT(mUsers == 0, "The pack is still in use");
+}
+
+bool MeshPack::_readContents(const uint8_t* data, size_t size) {
+	Header header;
+	if (size < sizeof(Header)) {
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(Header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 or header.version != Version) {
+		return false;
+	}
+
+	if (header.entryOffset + (uint64_t)header.entryCount * sizeof(Entry) > size) {
+		return false;
+	}
+
+	mEntries.resize(header.entryCount);
+	memcpy(mEntries.data(), data + header.entryOffset, header.entryCount * sizeof(Entry));
+
+	for (auto&& entry : mEntries) {
+		bool inside =
+			_isInFile(entry.nameOffset, entry.nameLength, size) and
+			_isInFile(entry.vertexOffset, (uint64_t)entry.vertexCount * entry.vertexSize, size) and
+			_isInFile(entry.indexOffset, (uint64_t)entry.indexCount * entry.indexSize, size);
+
+		if (not inside or not _isFormatValid(entry) or (entry.lodOf != NotALOD and entry.lodOf >= mEntries.size())) {
+			return false;
+		}
+
+		mNames.emplace_back(std::string((const char*)data + entry.nameOffset, entry.nameLength));
+	}
+
+	return true;
+}
+
+bool MeshPack::acquire() {
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (not mValid) {
+		return false;
+	}
+
+	if (mUsers == 0) {
+		auto file = make_unique<MappedFile>(mPath);
+
+		//the offsets in the table of contents must still be inside the file
+		if (file->getSize() != mFileSize) {
+			return false;
+		}
+
+		mFile = std::move(file);
+	}
+
+	++mUsers;
+	return true;
+}
+
+void MeshPack::release() {
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	DEBUG_ASSERT(mUsers > 0, "The pack wasn't acquired");
+
+	if (--mUsers == 0) {
+		mFile = {};
+	}
+}
+
+const uint8_t* MeshPack::getData() const {
+	DEBUG_ASSERT(mFile, "The pack wasn't acquired");
+
+	return mFile->getData();
+}
+
+void MeshPack::prefetch(uint32_t entry) const {
+	DEBUG_ASSERT(mFile, "The pack wasn't acquired");
+
+	for (auto i : range(getEntryCount())) {
+		auto& e = mEntries[i];
+		if (i == entry or e.lodOf == entry) {
+			mFile->prefetch((size_t)e.vertexOffset, e.vertexCount * e.vertexSize);
+			mFile->prefetch((size_t)e.indexOffset, e.indexCount * e.indexSize);
+		}
+	}
+}
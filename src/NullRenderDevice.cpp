@@ -0,0 +1,600 @@
+#include "NullRenderDevice.h"
+
+#include <glad/glad.h>
+
+using namespace Dojo;
+
+//all the state of the device, GL is only ever used from the main thread
+struct NullDeviceState {
+	NullRenderDevice::Stats stats;
+
+	GLuint nextName = 1;
+	uintptr_t nextSync = 1;
+
+	std::unordered_map<GLuint, std::vector<uint8_t>> buffers;
+	std::unordered_map<GLenum, GLuint> bufferBindings;
+
+	bool loaded = false;
+};
+
+static NullDeviceState gNullDevice;
+
+static const char* NULL_DEVICE_EXTENSIONS[] = {
+	"GL_EXT_buffer_storage",
+	"GL_EXT_disjoint_timer_query"
+};
+
+static const GLuint NULL_DEVICE_EXTENSION_COUNT = sizeof(NULL_DEVICE_EXTENSIONS) / sizeof(NULL_DEVICE_EXTENSIONS[0]);
+
+static const char* NULL_DEVICE_EXTENSION_STRING = "GL_EXT_buffer_storage GL_EXT_disjoint_timer_query";
+
+void _nullCall() {
+	++gNullDevice.stats.calls;
+}
+
+void _nullStateChange() {
+	++gNullDevice.stats.calls;
+	++gNullDevice.stats.stateChanges;
+}
+
+void _nullDraw() {
+	++gNullDevice.stats.calls;
+	++gNullDevice.stats.drawCalls;
+}
+
+void _nullGenNames(GLsizei n, GLuint* names) {
+	_nullCall();
+	for (GLsizei i = 0; i < n; ++i) {
+		names[i] = gNullDevice.nextName++;
+	}
+}
+
+std::vector<uint8_t>& _nullBoundBuffer(GLenum target) {
+	auto binding = gNullDevice.bufferBindings.find(target);
+	DEBUG_ASSERT(binding != gNullDevice.bufferBindings.end() and binding->second, "No buffer is bound to this target");
+	return gNullDevice.buffers[binding->second];
+}
+
+//strings and queries
+
+const GLubyte* APIENTRY _null_glGetString(GLenum name) {
+	_nullCall();
+	switch (name) {
+	case GL_VENDOR:
+		return (const GLubyte*)"Dojo";
+	case GL_RENDERER:
+		return (const GLubyte*)"Dojo null device";
+	case GL_VERSION:
+		return (const GLubyte*)"OpenGL ES 3.0 Dojo null device";
+	case GL_SHADING_LANGUAGE_VERSION:
+		return (const GLubyte*)"OpenGL ES GLSL ES 3.00";
+	case GL_EXTENSIONS:
+		return (const GLubyte*)NULL_DEVICE_EXTENSION_STRING;
+	default:
+		return nullptr;
+	}
+}
+
+const GLubyte* APIENTRY _null_glGetStringi(GLenum name, GLuint index) {
+	_nullCall();
+	if (name == GL_EXTENSIONS and index < NULL_DEVICE_EXTENSION_COUNT) {
+		return (const GLubyte*)NULL_DEVICE_EXTENSIONS[index];
+	}
+	return nullptr;
+}
+
+void APIENTRY _null_glGetIntegerv(GLenum pname, GLint* data) {
+	_nullCall();
+	switch (pname) {
+	case GL_NUM_EXTENSIONS:
+		*data = (GLint)NULL_DEVICE_EXTENSION_COUNT;
+		break;
+	case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+		*data = 256;
+		break;
+	case GL_MAX_TEXTURE_SIZE:
+		*data = 16384;
+		break;
+	default:
+		*data = 0;
+		break;
+	}
+}
+
+//objects
+
+void APIENTRY _null_glGenBuffers(GLsizei n, GLuint* buffers) {
+	_nullGenNames(n, buffers);
+}
+
+void APIENTRY _null_glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+	_nullCall();
+	for (GLsizei i = 0; i < n; ++i) {
+		gNullDevice.buffers.erase(buffers[i]);
+	}
+}
+
+void APIENTRY _null_glGenTextures(GLsizei n, GLuint* textures) {
+	_nullGenNames(n, textures);
+}
+
+void APIENTRY _null_glDeleteTextures(GLsizei, const GLuint*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+	_nullGenNames(n, framebuffers);
+}
+
+void APIENTRY _null_glDeleteFramebuffers(GLsizei, const GLuint*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+	_nullGenNames(n, renderbuffers);
+}
+
+void APIENTRY _null_glDeleteRenderbuffers(GLsizei, const GLuint*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGenVertexArrays(GLsizei n, GLuint* arrays) {
+	_nullGenNames(n, arrays);
+}
+
+void APIENTRY _null_glDeleteVertexArrays(GLsizei, const GLuint*) {
+	_nullCall();
+}
+
+#ifdef GL_EXT_disjoint_timer_query
+void APIENTRY _null_glGenQueriesEXT(GLsizei n, GLuint* ids) {
+	_nullGenNames(n, ids);
+}
+
+void APIENTRY _null_glDeleteQueriesEXT(GLsizei, const GLuint*) {
+	_nullCall();
+}
+#endif
+
+//buffers
+
+void APIENTRY _null_glBindBuffer(GLenum target, GLuint buffer) {
+	_nullStateChange();
+	gNullDevice.bufferBindings[target] = buffer;
+}
+
+void APIENTRY _null_glBindBufferRange(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum) {
+	_nullCall();
+	auto& storage = _nullBoundBuffer(target);
+	storage.resize((size_t)size);
+
+	if (data) {
+		memcpy(storage.data(), data, (size_t)size);
+		gNullDevice.stats.uploadedBytes += size;
+	}
+}
+
+#ifdef GL_EXT_buffer_storage
+void APIENTRY _null_glBufferStorageEXT(GLenum target, GLsizeiptr size, const void* data, GLbitfield) {
+	_null_glBufferData(target, size, data, 0);
+}
+#endif
+
+void* APIENTRY _null_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+	_nullCall();
+	auto& storage = _nullBoundBuffer(target);
+	DEBUG_ASSERT((size_t)(offset + length) <= storage.size(), "Mapping outside of the buffer");
+
+	if (access & GL_MAP_WRITE_BIT) {
+		gNullDevice.stats.uploadedBytes += length;
+	}
+
+	return storage.data() + offset;
+}
+
+GLboolean APIENTRY _null_glUnmapBuffer(GLenum) {
+	_nullCall();
+	return GL_TRUE;
+}
+
+//sync objects, the null GPU is always done
+
+GLsync APIENTRY _null_glFenceSync(GLenum, GLbitfield) {
+	_nullCall();
+	return (GLsync)gNullDevice.nextSync++;
+}
+
+GLenum APIENTRY _null_glClientWaitSync(GLsync, GLbitfield, GLuint64) {
+	_nullCall();
+	return GL_ALREADY_SIGNALED;
+}
+
+void APIENTRY _null_glDeleteSync(GLsync) {
+	_nullCall();
+}
+
+//timer queries
+#ifdef GL_EXT_disjoint_timer_query
+
+void APIENTRY _null_glBeginQueryEXT(GLenum, GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glEndQueryEXT(GLenum) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGetQueryObjectuivEXT(GLuint, GLenum pname, GLuint* params) {
+	_nullCall();
+	*params = pname == GL_QUERY_RESULT_AVAILABLE_EXT ? GL_TRUE : 0;
+}
+
+void APIENTRY _null_glGetQueryObjectui64vEXT(GLuint, GLenum, GLuint64* params) {
+	_nullCall();
+	*params = 0;
+}
+
+#endif
+
+//textures and framebuffers
+
+void APIENTRY _null_glActiveTexture(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glBindTexture(GLenum, GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glTexParameteri(GLenum, GLenum, GLint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glTexParameterf(GLenum, GLenum, GLfloat) {
+	_nullCall();
+}
+
+void APIENTRY _null_glTexStorage2D(GLenum, GLsizei, GLenum, GLsizei, GLsizei) {
+	_nullCall();
+}
+
+void APIENTRY _null_glTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, const void* pixels) {
+	_nullCall();
+	if (pixels) {
+		//the exact size depends on the format, 4 bytes per pixel is close enough to compare runs
+		gNullDevice.stats.uploadedBytes += (uint64_t)width * height * 4;
+	}
+}
+
+void APIENTRY _null_glCompressedTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei imageSize, const void* data) {
+	_nullCall();
+	if (data) {
+		gNullDevice.stats.uploadedBytes += (uint64_t)imageSize;
+	}
+}
+
+void APIENTRY _null_glBindFramebuffer(GLenum, GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glBindRenderbuffer(GLenum, GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) {
+	_nullCall();
+}
+
+void APIENTRY _null_glFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) {
+	_nullCall();
+}
+
+GLenum APIENTRY _null_glCheckFramebufferStatus(GLenum) {
+	_nullCall();
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY _null_glDrawBuffers(GLsizei, const GLenum*) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glReadBuffer(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glInvalidateFramebuffer(GLenum, GLsizei, const GLenum*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glReadPixels(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void*) {
+	_nullCall();
+}
+
+//shaders
+
+GLuint APIENTRY _null_glCreateShader(GLenum) {
+	_nullCall();
+	return gNullDevice.nextName++;
+}
+
+void APIENTRY _null_glDeleteShader(GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glCompileShader(GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGetShaderiv(GLuint, GLenum pname, GLint* params) {
+	_nullCall();
+	*params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY _null_glGetShaderInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+	_nullCall();
+	if (length) {
+		*length = 0;
+	}
+	if (bufSize > 0) {
+		infoLog[0] = 0;
+	}
+}
+
+GLuint APIENTRY _null_glCreateProgram() {
+	_nullCall();
+	return gNullDevice.nextName++;
+}
+
+void APIENTRY _null_glAttachShader(GLuint, GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glLinkProgram(GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glProgramBinary(GLuint, GLenum, const void*, GLsizei) {
+	_nullCall();
+}
+
+void APIENTRY _null_glGetProgramiv(GLuint, GLenum pname, GLint* params) {
+	_nullCall();
+	*params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY _null_glGetProgramBinary(GLuint, GLsizei, GLsizei* length, GLenum* binaryFormat, void*) {
+	_nullCall();
+	if (length) {
+		*length = 0;
+	}
+	*binaryFormat = 0;
+}
+
+void APIENTRY _null_glGetActiveUniform(GLuint, GLuint, GLsizei, GLsizei*, GLint*, GLenum*, GLchar*) {
+	FAIL("The null device has no active uniforms");
+}
+
+void APIENTRY _null_glGetActiveAttrib(GLuint, GLuint, GLsizei, GLsizei*, GLint*, GLenum*, GLchar*) {
+	FAIL("The null device has no active attributes");
+}
+
+GLint APIENTRY _null_glGetUniformLocation(GLuint, const GLchar*) {
+	_nullCall();
+	return -1;
+}
+
+GLint APIENTRY _null_glGetAttribLocation(GLuint, const GLchar*) {
+	_nullCall();
+	return -1;
+}
+
+GLuint APIENTRY _null_glGetUniformBlockIndex(GLuint, const GLchar*) {
+	_nullCall();
+	return GL_INVALID_INDEX;
+}
+
+void APIENTRY _null_glUniformBlockBinding(GLuint, GLuint, GLuint) {
+	_nullCall();
+}
+
+void APIENTRY _null_glUseProgram(GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glUniformfv(GLint, GLsizei, const GLfloat*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glUniformiv(GLint, GLsizei, const GLint*) {
+	_nullCall();
+}
+
+void APIENTRY _null_glUniformMatrixfv(GLint, GLsizei, GLboolean, const GLfloat*) {
+	_nullCall();
+}
+
+//vertex input and draws
+
+void APIENTRY _null_glBindVertexArray(GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glEnableVertexAttribArray(GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glDisableVertexAttribArray(GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glVertexAttribDivisor(GLuint, GLuint) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glDrawArrays(GLenum, GLint, GLsizei) {
+	_nullDraw();
+}
+
+void APIENTRY _null_glDrawElements(GLenum, GLsizei, GLenum, const void*) {
+	_nullDraw();
+}
+
+void APIENTRY _null_glDrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei) {
+	_nullDraw();
+}
+
+void APIENTRY _null_glDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) {
+	_nullDraw();
+}
+
+//fixed function state
+
+void APIENTRY _null_glEnable(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glDisable(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glBlendFunc(GLenum, GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glBlendEquation(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glCullFace(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glFrontFace(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glDepthMask(GLboolean) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glDepthFunc(GLenum) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glViewport(GLint, GLint, GLsizei, GLsizei) {
+	_nullStateChange();
+}
+
+void APIENTRY _null_glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) {
+	_nullCall();
+}
+
+void APIENTRY _null_glClearDepthf(GLfloat) {
+	_nullCall();
+}
+
+void APIENTRY _null_glClear(GLbitfield) {
+	_nullCall();
+}
+
+struct NullFunction {
+	const char* name;
+	void* function;
+};
+
+#define NULL_GL(name) { #name, (void*)&_null_##name }
+
+//the uniform setters only differ in their signature, which is the same for all the sizes
+static const NullFunction NULL_DEVICE_FUNCTIONS[] = {
+	NULL_GL(glGetString), NULL_GL(glGetStringi), NULL_GL(glGetIntegerv),
+
+	NULL_GL(glGenBuffers), NULL_GL(glDeleteBuffers), NULL_GL(glGenTextures), NULL_GL(glDeleteTextures),
+	NULL_GL(glGenFramebuffers), NULL_GL(glDeleteFramebuffers), NULL_GL(glGenRenderbuffers), NULL_GL(glDeleteRenderbuffers),
+	NULL_GL(glGenVertexArrays), NULL_GL(glDeleteVertexArrays),
+
+	NULL_GL(glBindBuffer), NULL_GL(glBindBufferRange), NULL_GL(glBufferData),
+	NULL_GL(glMapBufferRange), NULL_GL(glUnmapBuffer),
+	NULL_GL(glFenceSync), NULL_GL(glClientWaitSync), NULL_GL(glDeleteSync),
+
+#ifdef GL_EXT_buffer_storage
+	NULL_GL(glBufferStorageEXT),
+#endif
+
+#ifdef GL_EXT_disjoint_timer_query
+	NULL_GL(glGenQueriesEXT), NULL_GL(glDeleteQueriesEXT),
+	NULL_GL(glBeginQueryEXT), NULL_GL(glEndQueryEXT), NULL_GL(glGetQueryObjectuivEXT), NULL_GL(glGetQueryObjectui64vEXT),
+#endif
+
+	NULL_GL(glActiveTexture), NULL_GL(glBindTexture), NULL_GL(glTexParameteri), NULL_GL(glTexParameterf),
+	NULL_GL(glTexStorage2D), NULL_GL(glTexSubImage2D), NULL_GL(glCompressedTexSubImage2D),
+	NULL_GL(glBindFramebuffer), NULL_GL(glBindRenderbuffer), NULL_GL(glRenderbufferStorage),
+	NULL_GL(glFramebufferTexture2D), NULL_GL(glFramebufferRenderbuffer), NULL_GL(glCheckFramebufferStatus),
+	NULL_GL(glDrawBuffers), NULL_GL(glReadBuffer), NULL_GL(glInvalidateFramebuffer), NULL_GL(glReadPixels),
+
+	NULL_GL(glCreateShader), NULL_GL(glDeleteShader), NULL_GL(glShaderSource), NULL_GL(glCompileShader),
+	NULL_GL(glGetShaderiv), NULL_GL(glGetShaderInfoLog),
+	NULL_GL(glCreateProgram), NULL_GL(glAttachShader), NULL_GL(glLinkProgram), NULL_GL(glProgramBinary),
+	NULL_GL(glGetProgramiv), NULL_GL(glGetProgramBinary), NULL_GL(glGetActiveUniform), NULL_GL(glGetActiveAttrib),
+	NULL_GL(glGetUniformLocation), NULL_GL(glGetAttribLocation), NULL_GL(glGetUniformBlockIndex), NULL_GL(glUniformBlockBinding),
+	NULL_GL(glUseProgram),
+
+	{ "glUniform1fv", (void*)&_null_glUniformfv }, { "glUniform2fv", (void*)&_null_glUniformfv },
+	{ "glUniform3fv", (void*)&_null_glUniformfv }, { "glUniform4fv", (void*)&_null_glUniformfv },
+	{ "glUniform1iv", (void*)&_null_glUniformiv }, { "glUniform2iv", (void*)&_null_glUniformiv },
+	{ "glUniform3iv", (void*)&_null_glUniformiv }, { "glUniform4iv", (void*)&_null_glUniformiv },
+	{ "glUniformMatrix2fv", (void*)&_null_glUniformMatrixfv }, { "glUniformMatrix3fv", (void*)&_null_glUniformMatrixfv },
+	{ "glUniformMatrix4fv", (void*)&_null_glUniformMatrixfv },
+
+	NULL_GL(glBindVertexArray), NULL_GL(glEnableVertexAttribArray), NULL_GL(glDisableVertexAttribArray),
+	NULL_GL(glVertexAttribPointer), NULL_GL(glVertexAttribDivisor),
+	NULL_GL(glDrawArrays), NULL_GL(glDrawElements), NULL_GL(glDrawArraysInstanced), NULL_GL(glDrawElementsInstanced),
+
+	NULL_GL(glEnable), NULL_GL(glDisable), NULL_GL(glBlendFunc), NULL_GL(glBlendEquation), NULL_GL(glCullFace),
+	NULL_GL(glFrontFace), NULL_GL(glDepthMask), NULL_GL(glDepthFunc), NULL_GL(glViewport),
+	NULL_GL(glClearColor), NULL_GL(glClearDepthf), NULL_GL(glClear),
+};
+
+#undef NULL_GL
+
+//the functions the engine never calls stay null, so that starting to use one without adding it here fails loudly
+void* _nullGetProcAddress(const char* name) {
+	for (auto&& function : NULL_DEVICE_FUNCTIONS) {
+		if (strcmp(function.name, name) == 0) {
+			return function.function;
+		}
+	}
+	return nullptr;
+}
+
+bool NullRenderDevice::load() {
+	gNullDevice.loaded = gladLoadGLES2Loader(&_nullGetProcAddress) != 0;
+	return gNullDevice.loaded;
+}
+
+bool NullRenderDevice::isLoaded() {
+	return gNullDevice.loaded;
+}
+
+const NullRenderDevice::Stats& NullRenderDevice::getStats() {
+	return gNullDevice.stats;
+}
+
+void NullRenderDevice::resetStats() {
+	gNullDevice.stats = {};
+}
@@ -5,11 +5,14 @@
 #include "GameState.h"
 #include "Renderer.h"
 #include "Platform.h"
+#include "BoundsMath.h"
 #include "range.h"
 
 using namespace Dojo;
 using namespace glm;
 
+uint32_t Object::gTransformUpdateCount = 0;
+
 Object::Object(Object& parentObject, const Vector& pos, const Vector& bbSize):
 	position(pos),
 	active(true),
@@ -18,6 +21,8 @@ Object::Object(Object& parentObject, const Vector& pos, const Vector& bbSize):
 		gameState = gs.get();
 	}
 	setSize(bbSize);
+
+	updateWorldTransform();
 }
 
 Object::~Object() {
@@ -33,6 +38,11 @@ Object::~Object() {
 }
 
 void Object::_addChildEvent(Object& child) {
+	if (mTransformSystem) {
+		child.mTransformHandle = mTransformSystem->add(child, mTransformHandle);
+		child.mTransformSystem = mTransformSystem;
+	}
+
 	child.updateWorldTransform();
 
 	//call onAttach on all of the children components
@@ -80,6 +90,8 @@ Object& Object::_addChild(Unique<Object> o) {
 }
 
 void Object::_unregisterChild(Object& child) {
+	child._leaveTransformSystem();
+
 	//call onAttach on all of the children components
 	for (auto&& c : child.components) {
 		if (c) {
@@ -135,27 +147,7 @@ Object::ChildList Object::removeAllChildren() {
 }
 
 AABB Object::transformAABB(const AABB& local) const {
-	AABB bb;
-
-	//get the eight world-position corners and transform them
-	//TODO this is massively slow, pls optimize
-	bb.max = Vector::Min;
-	bb.min = Vector::Max;
-
-	Vector vertex;
-
-	for (uint8_t i = 0; i < 8; ++i) {
-		for (uint8_t j = 0; j < 3; ++j) {
-			vertex[j] = Math::getBit(i, j) ? local.max[j] : local.min[j];
-		}
-
-		vertex = getWorldPosition(vertex);
-
-		bb.max = Vector::max(bb.max, vertex);
-		bb.min = Vector::min(bb.min, vertex);
-	}
-
-	return bb;
+	return BoundsMath::transform(getWorldTransform(), local);
 }
 
 Vector Object::getWorldPosition(const Vector& localPos) const {
@@ -175,9 +167,15 @@ void Object::reset() {
 }
 
 Vector Object::getLocalPosition(const Vector& worldPos) const {
-	//TODO make faster for gods' sake
+	auto version = mTransformSystem ? mTransformSystem->getVersion(mTransformHandle) : mTransformVersion;
+	if (mInverseWorldTransformDirty or version != mInverseWorldTransformVersion) {
+		mInverseWorldTransform = glm::inverse(getWorldTransform());
+		mInverseWorldTransformVersion = version;
+		mInverseWorldTransformDirty = false;
+	}
+
 	glm::vec4 p(worldPos, 1);
-	p = glm::inverse(getWorldTransform()) * p;
+	p = mInverseWorldTransform * p;
 
 	return (Vector&)p;
 }
@@ -212,7 +210,90 @@ Matrix Object::getParentWorldTransform() const {
 }
 
 void Object::updateWorldTransform() {
-	mWorldTransform = getFullTransformRelativeTo(getParentWorldTransform());
+	if (mTransformSystem) {
+		mTransformSystem->updateNow(mTransformHandle, position, rotation);
+	}
+	else {
+		mWorldTransform = getFullTransformRelativeTo(getParentWorldTransform());
+	}
+	mInverseWorldTransformDirty = true;
+
+	mTransformPosition = position;
+	mTransformRotation = rotation;
+	mParentTransformVersion = parent.is_some() ? parent.unwrap().mTransformVersion : 0;
+
+	//the children compare this to know that they have to update too
+	++mTransformVersion;
+
+#ifndef PUBLISH
+	++gTransformUpdateCount;
+#endif
+}
+
+bool Object::_isWorldTransformDirty() const {
+	if (position != mTransformPosition or rotation != mTransformRotation) {
+		return true;
+	}
+
+	if (auto p = parent.to_ref()) {
+		return p.get().mTransformVersion != mParentTransformVersion;
+	}
+
+	return false;
+}
+
+void Object::refreshWorldTransform() {
+	if (mTransformSystem) {
+		mTransformSystem->setLocal(mTransformHandle, position, rotation);
+	}
+	else if (_isWorldTransformDirty()) {
+		updateWorldTransform();
+	}
+}
+
+void Object::_joinTransformSystem(TransformSystem& system) {
+	DEBUG_ASSERT(not mTransformSystem, "This Object is already in a TransformSystem");
+
+	auto p = parent.to_ref();
+	if (p and p.get().mTransformSystem == &system) {
+		mTransformHandle = system.add(self, p.get().mTransformHandle);
+	}
+	else {
+		mTransformHandle = system.addRoot(self);
+	}
+
+	mTransformSystem = &system;
+	mInverseWorldTransformDirty = true;
+
+	for (auto&& c : children) {
+		c->_joinTransformSystem(system);
+	}
+}
+
+void Object::_leaveTransformSystem() {
+	if (not mTransformSystem) {
+		return;
+	}
+
+	//keep the last world transform
+	mWorldTransform = mTransformSystem->getWorldTransform(mTransformHandle);
+	mTransformSystem->remove(mTransformHandle);
+	mTransformSystem = nullptr;
+	mInverseWorldTransformDirty = true;
+
+	for (auto&& c : children) {
+		c->_leaveTransformSystem();
+	}
+}
+
+void Object::_setTransformIndex(uint32_t index) {
+	mTransformHandle.index = index;
+
+	for (auto&& c : children) {
+		if (c->mTransformSystem) {
+			c->mTransformSystem->_setParent(c->mTransformHandle, index);
+		}
+	}
 }
 
 void Object::updateChilds(float dt) {
@@ -234,7 +315,7 @@ void Object::updateChilds(float dt) {
 void Object::onAction(float dt) {
 	position += speed * dt;
 
-	updateWorldTransform();
+	refreshWorldTransform();
 
 	updateChilds(dt);
 }
@@ -0,0 +1,258 @@
+#include "OcclusionBuffer.h"
+
+#include "Mesh.h"
+#include "range.h"
+
+#include <cfloat>
+
+#ifdef DOJO_SIMD_SSE
+	#include <emmintrin.h>
+#endif
+
+using namespace Dojo;
+
+//vertices closer than this to the eye plane can't be projected
+static const float OCCLUSION_MIN_W = 1e-5f;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) {
+	DEBUG_ASSERT(width > 0 and height > 0, "Invalid size");
+
+	//rows are processed 4 pixels at a time
+	width = (width + 3) & ~3;
+
+	while (true) {
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.depth.resize(width * height, 1.f);
+		mLevels.emplace_back(std::move(level));
+
+		if (width == 1 and height == 1) {
+			break;
+		}
+
+		width = std::max(1u, (width + 1) / 2);
+		height = std::max(1u, (height + 1) / 2);
+	}
+}
+
+void OcclusionBuffer::clear() {
+	std::fill(mLevels[0].depth.begin(), mLevels[0].depth.end(), 1.f);
+}
+
+void OcclusionBuffer::drawMesh(const Mesh& mesh, const Matrix& worldViewProjection) {
+	DEBUG_ASSERT(mesh.isDynamic(), "Static meshes drop their vertices after end()");
+
+	auto vertexCount = mesh.getVertexCount();
+
+	mClipVertices.resize(vertexCount);
+	for (auto i : range(vertexCount)) {
+		mClipVertices[i] = worldViewProjection * glm::vec4(mesh.getVertex(i), 1);
+	}
+
+	auto indexed = mesh.isIndexed();
+	auto count = indexed ? (uint32_t)mesh.getIndexCount() : vertexCount;
+	auto vertex = [&](uint32_t i) -> const glm::vec4& {
+		return mClipVertices[indexed ? mesh.getIndex(i) : i];
+	};
+
+	switch (mesh.getTriangleMode()) {
+	case PrimitiveMode::TriangleList:
+		for (uint32_t i = 0; i + 2 < count; i += 3) {
+			drawTriangle(vertex(i), vertex(i + 1), vertex(i + 2));
+		}
+		break;
+	case PrimitiveMode::TriangleStrip:
+		for (uint32_t i = 0; i + 2 < count; ++i) {
+			drawTriangle(vertex(i), vertex(i + 1), vertex(i + 2));
+		}
+		break;
+	default:
+		//lines and points don't hide anything
+		break;
+	}
+}
+
+void OcclusionBuffer::drawTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+	//skipping a triangle only makes the buffer hide less, so it's always safe
+	if (a.w < OCCLUSION_MIN_W or b.w < OCCLUSION_MIN_W or c.w < OCCLUSION_MIN_W) {
+		return;
+	}
+
+	auto& level = mLevels[0];
+	float w = (float)level.width, h = (float)level.height;
+
+	float x0 = (a.x / a.w * 0.5f + 0.5f) * w, y0 = (a.y / a.w * 0.5f + 0.5f) * h;
+	float x1 = (b.x / b.w * 0.5f + 0.5f) * w, y1 = (b.y / b.w * 0.5f + 0.5f) * h;
+	float x2 = (c.x / c.w * 0.5f + 0.5f) * w, y2 = (c.y / c.w * 0.5f + 0.5f) * h;
+
+	//the whole triangle is as far as its farthest vertex, so it never hides something that is in front of a part of it
+	float depth = std::max({ a.z / a.w, b.z / b.w, c.z / c.w }) * 0.5f + 0.5f;
+	if (depth >= 1.f) {
+		return;
+	}
+
+	float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+	if (std::abs(area) < 1e-6f) {
+		return;
+	}
+
+	//both windings hide what's behind them, make it counter clockwise
+	if (area < 0) {
+		std::swap(x1, x2);
+		std::swap(y1, y2);
+	}
+
+	int minX = std::max(0, (int)std::floor(std::min({ x0, x1, x2 })));
+	int maxX = std::min((int)level.width - 1, (int)std::ceil(std::max({ x0, x1, x2 })));
+	int minY = std::max(0, (int)std::floor(std::min({ y0, y1, y2 })));
+	int maxY = std::min((int)level.height - 1, (int)std::ceil(std::max({ y0, y1, y2 })));
+
+	if (minX > maxX or minY > maxY) {
+		return;
+	}
+
+	//the edge functions are linear, so along a row each of them grows by a constant step
+	float stepX0 = y0 - y1, stepX1 = y1 - y2, stepX2 = y2 - y0;
+
+	auto edge = [](float ax, float ay, float bx, float by, float px, float py) {
+		return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+	};
+
+	//a texel is covered only if all its corners are inside: the edge functions are evaluated at the center,
+	//so they are moved inwards by how much they can decrease within half a texel
+	float bias0 = 0.5f * (std::abs(x1 - x0) + std::abs(y1 - y0));
+	float bias1 = 0.5f * (std::abs(x2 - x1) + std::abs(y2 - y1));
+	float bias2 = 0.5f * (std::abs(x0 - x2) + std::abs(y0 - y2));
+
+	//aligned to 4 pixels, the rows are padded to a multiple of 4
+	minX &= ~3;
+
+	for (int y = minY; y <= maxY; ++y) {
+		float py = y + 0.5f, px = minX + 0.5f;
+		float e0 = edge(x0, y0, x1, y1, px, py) - bias0;
+		float e1 = edge(x1, y1, x2, y2, px, py) - bias1;
+		float e2 = edge(x2, y2, x0, y0, px, py) - bias2;
+
+		float* row = level.depth.data() + y * level.width;
+		int x = minX;
+
+#ifdef DOJO_SIMD_SSE
+		auto steps = _mm_set_ps(3, 2, 1, 0);
+		auto edge0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(steps, _mm_set1_ps(stepX0)));
+		auto edge1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(steps, _mm_set1_ps(stepX1)));
+		auto edge2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(steps, _mm_set1_ps(stepX2)));
+		auto step0 = _mm_set1_ps(stepX0 * 4), step1 = _mm_set1_ps(stepX1 * 4), step2 = _mm_set1_ps(stepX2 * 4);
+		auto triDepth = _mm_set1_ps(depth);
+		auto zero = _mm_setzero_ps();
+
+		for (; x <= maxX; x += 4) {
+			auto inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)),
+				_mm_cmpge_ps(edge2, zero));
+
+			auto current = _mm_loadu_ps(row + x);
+			auto nearest = _mm_min_ps(current, triDepth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+
+			edge0 = _mm_add_ps(edge0, step0);
+			edge1 = _mm_add_ps(edge1, step1);
+			edge2 = _mm_add_ps(edge2, step2);
+		}
+#else
+		for (; x <= maxX; ++x) {
+			if (e0 >= 0 and e1 >= 0 and e2 >= 0) {
+				row[x] = std::min(row[x], depth);
+			}
+
+			e0 += stepX0;
+			e1 += stepX1;
+			e2 += stepX2;
+		}
+#endif
+	}
+}
+
+void OcclusionBuffer::buildHierarchy() {
+	for (size_t l = 1; l < mLevels.size(); ++l) {
+		auto& src = mLevels[l - 1];
+		auto& dst = mLevels[l];
+
+		for (uint32_t y = 0; y < dst.height; ++y) {
+			auto y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+
+			for (uint32_t x = 0; x < dst.width; ++x) {
+				auto x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+
+				dst.depth[y * dst.width + x] = std::max(
+					std::max(src.depth[y0 * src.width + x0], src.depth[y0 * src.width + x1]),
+					std::max(src.depth[y1 * src.width + x0], src.depth[y1 * src.width + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const AABB& bounds, const Matrix& viewProjection) const {
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float minDepth = FLT_MAX;
+
+	for (auto i : range(8)) {
+		glm::vec4 corner(
+			(i & 1) ? bounds.max.x : bounds.min.x,
+			(i & 2) ? bounds.max.y : bounds.min.y,
+			(i & 4) ? bounds.max.z : bounds.min.z,
+			1.f);
+
+		auto clip = viewProjection * corner;
+
+		//the box crosses the near plane, it surely covers a big part of the screen
+		if (clip.w < OCCLUSION_MIN_W) {
+			return true;
+		}
+
+		float x = clip.x / clip.w, y = clip.y / clip.w;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minDepth = std::min(minDepth, clip.z / clip.w * 0.5f + 0.5f);
+	}
+
+	auto& base = mLevels[0];
+	int x0 = (int)std::floor((minX * 0.5f + 0.5f) * base.width);
+	int x1 = (int)std::floor((maxX * 0.5f + 0.5f) * base.width);
+	int y0 = (int)std::floor((minY * 0.5f + 0.5f) * base.height);
+	int y1 = (int)std::floor((maxY * 0.5f + 0.5f) * base.height);
+
+	//off-screen boxes are up to the frustum test
+	if (x1 < 0 or y1 < 0 or x0 >= (int)base.width or y0 >= (int)base.height) {
+		return true;
+	}
+
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, (int)base.width - 1);
+	y1 = std::min(y1, (int)base.height - 1);
+
+	//go up the chain until the box covers at most 2x2 texels
+	uint32_t l = 0;
+	while (l + 1 < mLevels.size() and (x1 - x0 > 1 or y1 - y0 > 1)) {
+		++l;
+		x0 >>= 1;
+		y0 >>= 1;
+		x1 >>= 1;
+		y1 >>= 1;
+	}
+
+	//visible if any occluder in the area is farther than the nearest point of the box
+	auto& level = mLevels[l];
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			if (level.depth[y * level.width + x] >= minDepth) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -1,6 +1,66 @@
 #include "RenderLayer.h"
 
+#include "Renderable.h"
+#include "LooseQuadtree.h"
+#include "AABBTree.h"
+
 using namespace Dojo;
 
 const RenderLayer::ID RenderLayer::InvalidID = 255;
 
+
+void RenderLayer::enableSpatialIndex() {
+	if (orthographic) {
+		spatialIndex = make_unique<LooseQuadtree>();
+	}
+	else {
+		spatialIndex = make_unique<AABBTree>();
+	}
+
+	for (auto&& r : elements) {
+		r->_setSpatialProxy(spatialIndex->insert(*r, r->getGraphicsAABB()));
+	}
+
+	_updateSlots(0);
+}
+
+void RenderLayer::disableSpatialIndex() {
+	for (auto&& r : elements) {
+		r->_setSpatialProxy(SpatialIndex::InvalidProxy);
+	}
+
+	spatialIndex.reset();
+}
+
+void RenderLayer::_onElementAdded(Renderable& r) {
+	if (spatialIndex) {
+		r._setSpatialProxy(spatialIndex->insert(r, r.getGraphicsAABB()));
+	}
+}
+
+void RenderLayer::_onElementRemoved(Renderable& r) {
+	if (spatialIndex and r._getSpatialProxy() != SpatialIndex::InvalidProxy) {
+		spatialIndex->remove(r._getSpatialProxy());
+	}
+
+	r._setSpatialProxy(SpatialIndex::InvalidProxy);
+}
+
+void RenderLayer::_onElementMoved(Renderable& r) {
+	if (spatialIndex and r._getSpatialProxy() != SpatialIndex::InvalidProxy) {
+		spatialIndex->move(r._getSpatialProxy(), r.getGraphicsAABB());
+	}
+}
+
+void RenderLayer::_updateSlots(size_t first) {
+	if (not spatialIndex) {
+		return;
+	}
+
+	for (auto i = first; i < elements.size(); ++i) {
+		//holes left by a removal during the update pass
+		if (auto r = elements[(int)i]) {
+			r->_setLayerSlot((uint32_t)i);
+		}
+	}
+}
@@ -35,22 +35,22 @@ RenderState::~RenderState() {
 
 }
 
-void RenderState::_updateTransparency() {
-	mTransparency = false;
+bool RenderState::_hasTransparency() const {
+	//not cached, as textures loaded in the background only know it when they are done
 	for (auto i : range(maxTextureSlots)) {
 		if (auto t = textures[i].to_ref()) {
-			mTransparency |= t.get().hasTransparency();
+			if (t.get().hasTransparency()) {
+				return true;
+			}
 		}
 	}
 
-	if (mesh.is_some()) {
-		mTransparency |= mesh.unwrap().hasVertexTransparency();
-	}
+	return mesh.is_some() and mesh.unwrap().hasVertexTransparency();
 }
 
 void RenderState::setMesh(Mesh& m) {
 	mesh = m;
-	_updateTransparency();
+	mDrawnMesh = {};
 }
 
 void RenderState::setTexture(optional_ref<Texture> tex, uint8_t ID /*= 0*/) {
@@ -65,12 +65,10 @@ void RenderState::setTexture(optional_ref<Texture> tex, uint8_t ID /*= 0*/) {
 		}
 	}
 	++maxTextureSlots;
-
-	_updateTransparency();
 }
 
 bool RenderState::isBlendingEnabled() const {
-	return blending.isAuto() ? (mTransparency or color.a < 1.f) : (blending.func > 0);
+	return blending.isAuto() ? (color.a < 1.f or _hasTransparency()) : (blending.func > 0);
 }
 
 void RenderState::setBlending(BlendingMode mode) {
@@ -88,14 +86,34 @@ optional_ref<Texture> RenderState::getTexture(int ID /*= 0*/) const {
 	return textures[ID];
 }
 
+bool RenderState::canBeInstancedWith(const RenderState& other) const {
+	if (mesh.to_raw_ptr() != other.mesh.to_raw_ptr() or mShader.to_raw_ptr() != other.mShader.to_raw_ptr()) {
+		return false;
+	}
+
+	for (auto i : range(DOJO_MAX_TEXTURES)) {
+		if (textures[i].to_raw_ptr() != other.textures[i].to_raw_ptr()) {
+			return false;
+		}
+	}
+
+	return
+		isBlendingEnabled() == other.isBlendingEnabled() and
+		blending.src == other.blending.src and
+		blending.dest == other.blending.dest and
+		blending.func == other.blending.func and
+		cullMode == other.cullMode;
+}
+
 void RenderState::apply(const GlobalUniformData& currentState, optional_ref<const RenderState> lastState) const {
 	auto prev = lastState.to_raw_ptr();
 
+	auto& drawnMesh = getDrawnMesh().unwrap();
+
 	bool rebindFormat = false;
-	if (not prev or prev->mesh != mesh or Mesh::gBufferBindingsDirty) {
+	if (not prev or prev->getDrawnMesh().to_raw_ptr() != &drawnMesh or Mesh::gBufferBindingsDirty) {
 		//when the mesh changes, the uniforms have to be rebound too
 		rebindFormat = true;
-		mesh.unwrap().bind();
 	}
 
 	if (not prev or prev->mShader != mShader) {
@@ -104,7 +122,7 @@ void RenderState::apply(const GlobalUniformData& currentState, optional_ref<cons
 	}
 
 	if (rebindFormat) {
-		mesh.unwrap().bindVertexFormat(mShader.unwrap());
+		drawnMesh.bindVertexArray(mShader.unwrap());
 	}
 
 	mShader.unwrap().loadUniforms(currentState, self);
@@ -112,12 +130,15 @@ void RenderState::apply(const GlobalUniformData& currentState, optional_ref<cons
 	for (auto i : range(maxTextureSlots)) {
 		//select current slot and load it, others can remain bound to old stuff with shaders
 		if (auto t = textures[i].to_ref()) {
-			if (not prev or textures[i] != prev->textures[i]) {
+			if (not prev or textures[i] != prev->textures[i] or Texture::gBindingsDirty) {
 				t.get().bind(i);
 			}
 		}
 	}
 
+	//the slots this state doesn't use are bound again by the next state that uses them, as they differ from this one
+	Texture::gBindingsDirty = false;
+
 	bool useBlending = isBlendingEnabled();
 	if (not prev or prev->isBlendingEnabled() != useBlending) {
 		if (useBlending) {
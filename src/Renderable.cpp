@@ -123,6 +123,12 @@ GameState& Renderable::getGameState() const {
 	return getObject().getGameState();
 }
 
+void Renderable::setOccluderMesh(optional_ref<Mesh> mesh) {
+	DEBUG_ASSERT(mesh.is_none() or mesh.unwrap().isDynamic(), "An occluder Mesh must be dynamic to keep its vertices on the CPU");
+
+	mOccluderMesh = mesh;
+}
+
 void Renderable::onAttach() {
 	Platform::singleton().getRenderer().addRenderable(self);
 }
@@ -1,6 +1,7 @@
 #include "Renderer.h"
 
 #include "Renderable.h"
+#include "Object.h"
 #include "TextArea.h"
 #include "Platform.h"
 #include "Viewport.h"
@@ -10,13 +11,18 @@
 
 #include "Game.h"
 #include "Texture.h"
+#include "SpriteBatcher.h"
+#include "WorkerPool.h"
+#include "StreamingBuffer.h"
+#include "GPUTimer.h"
+#include "TextureStreamer.h"
+#include "Timer.h"
+#include "range.h"
 
 #include <glad/glad.h>
 
 using namespace Dojo;
 
-GLuint gDefaultVAO = 0;
-
 
 const char* _errorToString(GLenum errorType) {
 	switch (errorType)
@@ -112,6 +118,13 @@ void APIENTRY GL_DEBUG_CALLBACK(
 	}
 }
 
+//enough for a few thousands of draws per frame with 3 frames in flight
+static const uint32_t UNIFORM_RING_SIZE = 8 * 1024 * 1024;
+
+//streaming Meshes are mostly sprite batches and text, rebuilt every frame
+static const uint32_t VERTEX_RING_SIZE = 16 * 1024 * 1024;
+static const uint32_t INDEX_RING_SIZE = 4 * 1024 * 1024;
+
 Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation) :
 	frameStarted(false),
 	valid(true),
@@ -121,6 +134,8 @@ Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation
 	frameVertexCount(0),
 	frameTriCount(0),
 	frameBatchCount(0),
+	frameStateChangeCount(0),
+	frameStateChangesAvoided(0),
 	submitter(Platform::singleton()) {
 	DEBUG_MESSAGE("Creating OpenGL context...");
 	DEBUG_MESSAGE("querying GL info... ");
@@ -130,9 +145,25 @@ Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation
 
 	setInterfaceOrientation(Platform::singleton().getGame().getNativeOrientation());
 
-	//HACK GL core doesn't work without a VAO bound... but ain't nobody got time fo' dat
-	glGenVertexArrays(1, &gDefaultVAO);
-	glBindVertexArray(gDefaultVAO);
+	//GL core doesn't work without a VAO bound, Meshes bind their own to draw
+	glGenVertexArrays(1, &mDefaultVAO);
+	glBindVertexArray(mDefaultVAO);
+
+	glGenBuffers(1, &mInstanceBuffer);
+
+	mSpriteBatcher = make_unique<SpriteBatcher>();
+
+	//uniform blocks need a GLES3-class context, otherwise all shaders use single uniforms
+	if (GLAD_GL_ES_VERSION_3_0) {
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		mUniformRing = make_unique<StreamingBuffer>(GL_UNIFORM_BUFFER, UNIFORM_RING_SIZE, (uint32_t)alignment);
+
+		//4 bytes keeps every vertex attribute and index type aligned
+		mVertexRing = make_unique<StreamingBuffer>(GL_ARRAY_BUFFER, VERTEX_RING_SIZE, 4);
+		mIndexRing = make_unique<StreamingBuffer>(GL_ELEMENT_ARRAY_BUFFER, INDEX_RING_SIZE, 4);
+		Mesh::gBufferBindingsDirty = true;
+	}
 
 #ifdef PUBLISH
 	bool shouldLog = false;
@@ -155,14 +186,43 @@ Dojo::Renderer::Renderer(RenderSurface backbuffer, Orientation renderOrientation
 
 		glDebugMessageCallback(&GL_DEBUG_CALLBACK, nullptr);
 	}
+
+	//GPU timing is cheap enough to be sampled in the field, but it's opt-in in published builds
+	if (GPUTimer::isSupported() and Platform::singleton().getUserConfiguration().getBool("enable_GPU_timing", shouldLog)) {
+		mGPUTimer = make_unique<GPUTimer>();
+	}
+
+	//a flat grey stands in for the textures that are still loading
+	static const uint8_t PLACEHOLDER_PIXEL[] = { 128, 128, 128, 255 };
+	mPlaceholderTexture = make_unique<Texture>();
+	mPlaceholderTexture->loadFromMemory(PLACEHOLDER_PIXEL, 1, 1, PixelFormat::RGBA_8_8_8_8);
+
+	//with a budget, the textures only keep the mips they are drawn with in VRAM
+	auto textureBudget = Platform::singleton().getUserConfiguration().getInt("texture_VRAM_budget_MB", 0);
+	if (textureBudget > 0) {
+		mTextureStreamer = make_unique<TextureStreamer>((size_t)textureBudget * 1024 * 1024);
+	}
 }
 
 Renderer::~Renderer() {
 	clearLayers();
 
-	if(gDefaultVAO) {
-		glDeleteVertexArrays(1, &gDefaultVAO);
-		gDefaultVAO = 0;
+	mSpriteBatcher.reset();
+	mUniformRing.reset();
+	mVertexRing.reset();
+	mIndexRing.reset();
+	mGPUTimer.reset();
+	mTextureStreamer.reset();
+	mPlaceholderTexture.reset();
+
+	if (mInstanceBuffer) {
+		glDeleteBuffers(1, &mInstanceBuffer);
+		mInstanceBuffer = 0;
+	}
+
+	if (mDefaultVAO) {
+		glDeleteVertexArrays(1, &mDefaultVAO);
+		mDefaultVAO = 0;
 	}
 }
 
@@ -187,9 +247,17 @@ void Renderer::addRenderable(Renderable& s) {
 
 	DEBUG_ASSERT(layer.elements.contains(&s) == false, "This object is already registered!");
 
-	//append at the end
-	layer.elements.emplace(&s);
-	layer.elementsChangedThisFrame |= true;
+	//append at the end, or after the update pass if the elements are being iterated
+	if (mUpdatingRenderables) {
+		DEBUG_ASSERT(std::find(layer.addedElements.begin(), layer.addedElements.end(), &s) == layer.addedElements.end(), "This object is already registered!");
+		layer.addedElements.push_back(&s);
+	}
+	else {
+		layer.elements.emplace(&s);
+		layer._updateSlots(layer.elements.size() - 1);
+	}
+
+	layer._onElementAdded(s);
 }
 
 void Renderer::removeRenderable(Renderable& s) {
@@ -197,8 +265,32 @@ void Renderer::removeRenderable(Renderable& s) {
 
 	if (hasLayer(s.getLayerID())) {
 		auto& layer = getLayer(s.getLayerID());
-		layer.elements.erase(&s);
-		layer.elementsChangedThisFrame |= true;
+
+		if (mUpdatingRenderables) {
+			//leave a hole so that the indices being iterated stay valid
+			auto added = std::find(layer.addedElements.begin(), layer.addedElements.end(), &s);
+			if (added != layer.addedElements.end()) {
+				layer.addedElements.erase(added);
+			}
+			else {
+				auto elem = layer.elements.find(&s);
+				if (elem != layer.elements.end()) {
+					*elem = nullptr;
+					layer.hasRemovedElements = true;
+				}
+			}
+		}
+		else {
+			//the last element takes the slot of the removed one
+			auto elem = layer.elements.find(&s);
+			if (elem != layer.elements.end()) {
+				auto slot = elem - layer.elements.begin();
+				layer.elements.erase(elem);
+				layer._updateSlots(slot);
+			}
+		}
+
+		layer._onElementRemoved(s);
 	}
 
 	if(lastRenderState == s) {
@@ -208,7 +300,16 @@ void Renderer::removeRenderable(Renderable& s) {
 
 void Renderer::removeAllRenderables() {
 	for (auto&& l : layers) {
+		for (auto&& r : l.elements) {
+			if (r) {
+				l._onElementRemoved(*r);
+			}
+		}
+		for (auto&& r : l.addedElements) {
+			l._onElementRemoved(*r);
+		}
 		l.elements.clear();
+		l.addedElements.clear();
 	}
 
 	lastRenderState = {};
@@ -254,8 +355,38 @@ void Renderer::setInterfaceOrientation(Orientation o) {
 	mRenderRotation = glm::mat4_cast(Quaternion(Vector(0, 0, renderRotation)));
 }
 
-void Dojo::Renderer::_renderElement(const RenderLayer& layer, const RenderState& renderState) {
-	auto& m = renderState.getMesh().unwrap();
+static const uint32_t glModeMap[] = {
+	GL_TRIANGLE_STRIP, //TriangleStrip,
+	GL_TRIANGLES, //TriangleList,
+	GL_LINE_STRIP, //LineStrip,
+	GL_LINES, //LineList
+	GL_POINTS
+};
+
+//issues the draw call for the bound mesh, instanceCount > 0 uses an instanced call
+void _drawMesh(Mesh& m, int instanceCount = 0) {
+	uint32_t mode = glModeMap[(uint8_t)m.getTriangleMode()];
+
+	if (instanceCount > 0) {
+		if (m.isIndexed()) {
+			glDrawElementsInstanced(mode, m.getIndexCount(), m.getIndexGLType(), (void*)m.getIndexByteOffset(), instanceCount);
+		}
+		else {
+			glDrawArraysInstanced(mode, 0, m.getVertexCount(), instanceCount);
+		}
+	}
+	else {
+		if (m.isIndexed()) {
+			glDrawElements(mode, m.getIndexCount(), m.getIndexGLType(), (void*)m.getIndexByteOffset());
+		}
+		else {
+			glDrawArrays(mode, 0, m.getVertexCount());
+		}
+	}
+}
+
+void Renderer::_draw(const RenderState& renderState) {
+	auto& m = renderState.getDrawnMesh().unwrap();
 
 	DEBUG_ASSERT( frameStarted, "Tried to render an element but the frame wasn't started" );
 	DEBUG_ASSERT(m.isLoaded(), "Rendering with a mesh with no GPU data!");
@@ -269,67 +400,533 @@ void Dojo::Renderer::_renderElement(const RenderLayer& layer, const RenderState&
 	++frameBatchCount;
 #endif // !PUBLISH
 
+	_uploadDrawUniforms(renderState);
+	renderState.apply(globalUniforms, lastRenderState);
+
+	_drawMesh(m);
+
+	lastRenderState = renderState;
+}
+
+void Dojo::Renderer::_renderElement(const RenderLayer& layer, const RenderState& renderState) {
 	globalUniforms.world = renderState.getTransform();
 	globalUniforms.world[3][2] += layer.zOffset;
 
 	globalUniforms.worldView = globalUniforms.view * globalUniforms.world;
 	globalUniforms.worldViewProjection = globalUniforms.projection * globalUniforms.worldView;
-	
-	renderState.apply(globalUniforms, lastRenderState);
 
-	static const uint32_t glModeMap[] = {
-		GL_TRIANGLE_STRIP, //TriangleStrip,
-		GL_TRIANGLES, //TriangleList,
-		GL_LINE_STRIP, //LineStrip,
-		GL_LINES, //LineList
-		GL_POINTS
-	};
+	_draw(renderState);
+}
 
-	uint32_t mode = glModeMap[(uint8_t)m.getTriangleMode()];
+void Renderer::_useLOD(const DrawPacket& packet) {
+	auto& r = *packet.renderable;
+	if (r.getDrawnMesh().to_raw_ptr() != packet.mesh) {
+		r._setDrawnMesh(*packet.mesh);
 
-	if (m.isIndexed()) {
-		glDrawElements(mode, m.getIndexCount(), m.getIndexGLType(), nullptr);
+		//the Renderable might be the last state, which would skip binding its new mesh
+		Mesh::gBufferBindingsDirty = true;
+	}
+}
+
+void Renderer::_renderPacket(const DrawPacket& packet) {
+	_useLOD(packet);
+
+	globalUniforms.world = packet.world;
+	globalUniforms.worldView = packet.worldView;
+	globalUniforms.worldViewProjection = packet.worldViewProjection;
+
+	_draw(*packet.renderable);
+}
+
+void Renderer::_renderInstanced(const RenderLayer& layer, const DrawPacket* begin, const DrawPacket* end) {
+	auto& first = *begin->renderable;
+	auto& m = *begin->mesh;
+	auto& shader = *begin->shader;
+	int instanceCount = (int)(end - begin);
+
+	DEBUG_ASSERT(frameStarted, "Tried to render an element but the frame wasn't started");
+	DEBUG_ASSERT(m.isLoaded(), "Rendering with a mesh with no GPU data!");
+	DEBUG_ASSERT(instanceCount > 0, "Rendering an empty instance run");
+
+#ifndef PUBLISH
+	frameVertexCount += m.getVertexCount() * instanceCount;
+	frameTriCount += m.getPrimitiveCount() * instanceCount;
+
+	//the whole run is a single batch
+	++frameBatchCount;
+#endif // !PUBLISH
+
+	//the instances are written straight in the vertex ring when there is one, otherwise the instance buffer is orphaned every run
+	auto instanceBytes = (uint32_t)(instanceCount * sizeof(InstanceData));
+	bool streamed = mVertexRing and instanceBytes <= mVertexRing->getSize();
+
+	InstanceData* instances;
+	uintptr_t instanceOffset = 0;
+	if (streamed) {
+		auto allocation = mVertexRing->map(instanceBytes);
+		instances = (InstanceData*)allocation.data;
+		instanceOffset = allocation.offset;
 	}
 	else {
-		glDrawArrays(mode, 0, m.getVertexCount());
+		mInstanceData.resize(instanceCount);
+		instances = mInstanceData.data();
 	}
 
-	lastRenderState = renderState;
+	for (auto packet = begin; packet < end; ++packet) {
+		_useLOD(*packet);
+
+		auto& instance = *instances++;
+		instance.world = packet->world;
+		instance.color = packet->renderable->color;
+	}
+
+	if (streamed) {
+		mVertexRing->unmap();
+	}
+
+	//non-instanced uniforms still see the first element
+	globalUniforms.world = begin->world;
+	globalUniforms.worldView = begin->worldView;
+	globalUniforms.worldViewProjection = begin->worldViewProjection;
+
+	_uploadDrawUniforms(first);
+	first.apply(globalUniforms, lastRenderState);
+
+	if (streamed) {
+		glBindBuffer(GL_ARRAY_BUFFER, mVertexRing->getGLHandle());
+	}
+	else {
+		glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, instanceBytes, mInstanceData.data(), GL_STREAM_DRAW);
+	}
+
+	//a mat4 attribute takes 4 consecutive vec4 locations
+	auto worldLocation = shader.getInstanceAttributeLocation(Shader::InstanceAttribute::World);
+	for (auto i : range(4)) {
+		glEnableVertexAttribArray(worldLocation + i);
+		glVertexAttribPointer(worldLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(instanceOffset + sizeof(glm::vec4) * i));
+		glVertexAttribDivisor(worldLocation + i, 1);
+	}
+
+	auto colorLocation = shader.getInstanceAttributeLocation(Shader::InstanceAttribute::Color);
+	if (colorLocation >= 0) {
+		glEnableVertexAttribArray(colorLocation);
+		glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(instanceOffset + sizeof(Matrix)));
+		glVertexAttribDivisor(colorLocation, 1);
+	}
+
+	//always go through the instanced call, the shader reads the instance attributes even for a single element
+	_drawMesh(m, instanceCount);
+
+	//restore the locations to per-vertex, other shaders might use them for mesh attributes
+	for (auto i : range(4)) {
+		glVertexAttribDivisor(worldLocation + i, 0);
+		glDisableVertexAttribArray(worldLocation + i);
+	}
+
+	if (colorLocation >= 0) {
+		glVertexAttribDivisor(colorLocation, 0);
+		glDisableVertexAttribArray(colorLocation);
+	}
+
+	//the instance buffer replaced the mesh's GL_ARRAY_BUFFER binding
+	Mesh::gBufferBindingsDirty = true;
+
+	lastRenderState = *(end - 1)->renderable;
+}
+
+void Renderer::_renderSpriteBatch(const RenderLayer& layer, const DrawPacket* begin, const DrawPacket* end) {
+	//the batch state is reused by every batch, so it can't be trusted as the previous state
+	if (lastRenderState == mSpriteBatcher->getRenderState()) {
+		lastRenderState = {};
+	}
+
+	mSpriteBatcher->begin(*begin->renderable, (uint32_t)(end - begin));
+	for (auto packet = begin; packet < end; ++packet) {
+		mSpriteBatcher->append(*packet->renderable);
+	}
+
+	_renderElement(layer, mSpriteBatcher->end());
 }
 
+//how many elements a single culling task goes through
+static const uint32_t CULL_CHUNK_SIZE = 256;
+
 bool _cull(const RenderLayer& layer, const Viewport& viewport, const Renderable& r) {
 	return layer.orthographic ? viewport.isInViewRect(r) : viewport.isContainedInFrustum(r);
 }
 
-void Renderer::_renderLayer(Viewport& viewport, const RenderLayer& layer) {
-	if (layer.elements.empty() or not layer.visible) {
-		return;
+//layout of the draw sort key, from the most significant bit:
+//opaque:      [translucent:1][shader:10][textures:12][mesh:12][blending:5][depth:24]
+//translucent: [translucent:1][inverse depth:24][unused:39]
+//opaque draws are grouped by state first and then go front to back, translucent ones need to go back to front
+//and keep the layer order at the same depth, through DrawPacket::index.
+//Without a depth test nothing hides what is drawn later, so every draw is sorted as translucent
+static const int SORT_SHADER_BITS = 10, SORT_TEXTURE_BITS = 12, SORT_MESH_BITS = 12, SORT_BLEND_BITS = 5;
+static const int SORT_STATE_BITS = SORT_SHADER_BITS + SORT_TEXTURE_BITS + SORT_MESH_BITS + SORT_BLEND_BITS;
+static const int SORT_DEPTH_BITS = 24;
+
+static const uint64_t SORT_TRANSLUCENT_BIT = 1ull << 63;
+static const uint64_t SORT_STATE_MASK = (1ull << SORT_STATE_BITS) - 1;
+static const uint64_t SORT_DEPTH_MASK = (1ull << SORT_DEPTH_BITS) - 1;
+
+//fibonacci-hash a pointer-sized value down to the given amount of bits
+uint64_t _foldToBits(uint64_t value, int bits) {
+	return (value * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+}
+
+uint64_t _foldPointer(const void* ptr, int bits) {
+	return ptr ? _foldToBits((uint64_t)(uintptr_t)ptr, bits) : 0;
+}
+
+uint64_t _makeStateKey(const RenderState& rs, const Mesh* mesh) {
+	uint64_t textureSet = 0;
+	for (auto i : range(DOJO_MAX_TEXTURES)) {
+		if (auto t = rs.getTexture(i).to_ref()) {
+			//tiles bind the same GL texture as their atlas, so they should sort together
+			auto& bound = t.get().getParentAtlas().unwrap_or(t.get());
+			textureSet = textureSet * 31 + (uintptr_t)&bound;
+		}
 	}
 
-	//depth TEST actually is required even just to write...
-	if (layer.usesDepth()) {
-		DEBUG_ASSERT(viewport.getFramebuffer().hasDepth(), "Depth won't work without an attachment");
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(layer.depthWrite);
-		glDepthFunc(layer.depthTest ? GL_LESS : GL_ALWAYS);
+	auto& blending = rs.getBlending();
+	uint64_t blend = rs.isBlendingEnabled() ?
+		(1 | (_foldToBits(blending.src * 961 + blending.dest * 31 + blending.func + 1, SORT_BLEND_BITS - 1) << 1)) :
+		0;
+
+	uint64_t key = _foldPointer(rs.getShader().to_raw_ptr(), SORT_SHADER_BITS);
+	key = (key << SORT_TEXTURE_BITS) | (textureSet ? _foldToBits(textureSet, SORT_TEXTURE_BITS) : 0);
+	key = (key << SORT_MESH_BITS) | _foldPointer(mesh, SORT_MESH_BITS);
+	key = (key << SORT_BLEND_BITS) | blend;
+	return key;
+}
+
+//counts how many of the shader, textures, mesh and blending fields differ between two state keys
+int _countStateChanges(uint64_t a, uint64_t b) {
+	static const int fieldBits[] = { SORT_BLEND_BITS, SORT_MESH_BITS, SORT_TEXTURE_BITS, SORT_SHADER_BITS };
+
+	int changes = 0;
+	for (auto&& bits : fieldBits) {
+		auto mask = (1ull << bits) - 1;
+		changes += ((a ^ b) & mask) ? 1 : 0;
+		a >>= bits;
+		b >>= bits;
+	}
+	return changes;
+}
+
+//returns the diameter of the bounding sphere of a Renderable on screen, relative to the viewport height
+float _getScreenSize(const RenderQueue& queue, const Renderable& r) {
+	auto& bounds = r.getGraphicsAABB();
+
+	auto center = queue.view * glm::vec4(bounds.getCenter() + Vector(0, 0, queue.layer->zOffset), 1);
+	float distance = -center.z;
+	float radius = glm::length(bounds.getSize()) * 0.5f;
+
+	return distance > radius ? radius * queue.lodScale / distance : FLT_MAX;
+}
+
+//picks the LOD of the Renderable's Mesh that fits its size on screen
+Mesh& _selectLOD(Renderable& r, float screenSize) {
+	auto& mesh = r.getMesh().unwrap();
+
+	auto lod = mesh.selectLOD(screenSize, r.getLOD(), r.lodHysteresis);
+	r._setLOD(lod);
+	return mesh.getLOD(lod);
+}
+
+DrawPacket _makePacket(const RenderQueue& queue, Renderable& r, uint32_t index) {
+	DrawPacket packet;
+	packet.mesh = r.getMesh().to_raw_ptr();
+
+	//orthographic layers are drawn pixel-perfect, so they always want the full size
+	bool hasLODs = packet.mesh->getLODCount() > 1;
+	float screenSize = FLT_MAX;
+	if (queue.lodScale > 0 and (hasLODs or queue.pixelHeight > 0)) {
+		screenSize = _getScreenSize(queue, r);
+	}
+
+	if (queue.lodScale > 0 and hasLODs) {
+		packet.mesh = &_selectLOD(r, screenSize);
+	}
+
+	packet.state = _makeStateKey(r, packet.mesh);
+	packet.index = index;
+	packet.renderable = &r;
+	packet.shader = r.getShader().to_raw_ptr();
+	for (auto i : range(DOJO_MAX_TEXTURES)) {
+		packet.textures[i] = r.getTexture(i).to_raw_ptr();
+
+		if (packet.textures[i] and queue.pixelHeight > 0) {
+			packet.textures[i]->_requestScreenSize(screenSize < FLT_MAX ? screenSize * queue.pixelHeight : FLT_MAX);
+		}
+	}
+	packet.blending = r.isBlendingEnabled();
+
+	packet.world = r.getTransform();
+	packet.world[3][2] += queue.layer->zOffset;
+	packet.worldView = queue.view * packet.world;
+	packet.worldViewProjection = queue.projection * packet.worldView;
+
+	//both projections look down -z in view space and the far plane is the frustum one
+	float distance = -packet.worldView[3][2];
+	float normalizedDepth = glm::clamp(distance / queue.zFar, 0.f, 1.f);
+	uint64_t depth = (uint64_t)(normalizedDepth * SORT_DEPTH_MASK);
+
+	if (packet.blending or not queue.layer->depthTest) {
+		packet.key = SORT_TRANSLUCENT_BIT | ((SORT_DEPTH_MASK - depth) << SORT_STATE_BITS);
 	}
 	else {
-		glDisable(GL_DEPTH_TEST);
+		packet.key = (packet.state << SORT_DEPTH_BITS) | depth;
 	}
 
-	//set projection state
-	globalUniforms.projection = mRenderRotation * (layer.orthographic ? viewport.getOrthoProjectionTransform() : viewport.getPerspectiveProjectionTransform());
+	return packet;
+}
+
+void Renderer::_prepareQueues() {
+	mQueueCount = 0;
 
-	for (auto&& r : layer.elements) {
-		if (r->canBeRendered() and _cull(layer, viewport, *r)) {
-			_renderElement(layer, *r);
+	auto addQueue = [this](Viewport& viewport, RenderLayer::ID layerID) {
+		if (mQueueCount == mQueues.size()) {
+			mQueues.emplace_back();
+		}
+
+		auto& queue = mQueues[mQueueCount++];
+		queue.viewport = &viewport;
+		queue.layerID = layerID;
+
+		getLayer(layerID); //make sure it exists before pointers to the layers are taken
+	};
+
+	for (auto&& viewport : viewportList) {
+		viewport->_update();
+
+		if (viewport->getVisibleLayers().empty()) { //using the default layer ordering/visibility
+			for (auto i : range(layers.size())) {
+				addQueue(*viewport, (RenderLayer::ID)i);
+			}
+		}
+		else { //use the custom layer ordering/visibility
+			for (auto&& layer : viewport->getVisibleLayers()) {
+				addQueue(*viewport, layer);
+			}
+		}
+	}
+
+	//now that no more layers can be created, resolve them along with everything that needs the main thread
+	mCullChunks.clear();
+	for (auto i : range(mQueueCount)) {
+		auto& queue = mQueues[i];
+		auto& viewport = *queue.viewport;
+
+		queue.layer = &getLayer(queue.layerID);
+		queue.view = viewport.getViewTransform();
+		queue.zFar = viewport.getZFar();
+
+		//this also updates the frustum planes used to cull
+		queue.projection = mRenderRotation * (queue.layer->orthographic ? viewport.getOrthoProjectionTransform() : viewport.getPerspectiveProjectionTransform());
+		queue.viewProjection = queue.projection * queue.view;
+		queue.lodScale = queue.layer->orthographic ? 0.f : viewport.getPerspectiveProjectionTransform()[1][1];
+		queue.pixelHeight = mTextureStreamer ? (float)viewport.getFramebuffer().getHeight() : 0.f;
+
+		queue.packets.clear();
+		queue.stateChanges = queue.stateChangesAvoided = 0;
+		queue.occlusionEnabled = false;
+
+		auto& layer = *queue.layer;
+		if (layer.elements.empty() or not layer.visible) {
+			continue;
+		}
+
+		if (layer.occlusionCulling and not layer.orthographic) {
+			if (not queue.occlusion) {
+				queue.occlusion = make_unique<OcclusionBuffer>();
+			}
+			queue.occlusionEnabled = true;
+		}
+
+		//the visible list can hold every element, so that each chunk can write its own slice without syncing
+		auto elementCount = (uint32_t)layer.elements.size();
+		if (queue.visible.size() < elementCount) {
+			queue.visible.resize(elementCount);
+		}
+
+		if (not layer.orthographic and queue.bounds.size() < elementCount) {
+			queue.bounds.resize(elementCount);
+			queue.inFrustum.resize(elementCount);
+		}
+
+		//split the layer in fixed size chunks, so that a single huge layer still spreads across all the workers
+		//a spatial index is queried as a whole instead
+		auto chunkSize = layer.spatialIndex ? elementCount : CULL_CHUNK_SIZE;
+		for (uint32_t begin = 0; begin < elementCount; begin += chunkSize) {
+			CullChunk chunk;
+			chunk.queue = (uint32_t)i;
+			chunk.begin = begin;
+			chunk.end = std::min(begin + chunkSize, elementCount);
+			chunk.visibleCount = chunk.packetOffset = chunk.occludedCount = 0;
+			mCullChunks.push_back(chunk);
 		}
 	}
 }
 
-void Renderer::_renderViewport(Viewport& viewport) {
-	viewport._update();
+void Renderer::_cullChunk(CullChunk& chunk) {
+	auto& queue = mQueues[chunk.queue];
+	auto& layer = *queue.layer;
+	auto& viewport = *queue.viewport;
+
+	auto begin = queue.visible.data() + chunk.begin;
+	auto out = begin;
+
+	if (auto& index = layer.spatialIndex) {
+		SpatialIndex::BoundsTest test;
+		if (layer.orthographic) {
+			test = [&viewport](const AABB& bb) { return viewport.isInViewRect(bb); };
+		}
+		else {
+			test = [&viewport](const AABB& bb) { return viewport.isContainedInFrustum(bb); };
+		}
+
+		//the index returns candidates, the exact test below is the same as the linear one
+		//the proxies don't follow the insertion order, report the slot in the elements like the linear path does
+		index->query(test, [&out](Renderable& r, SpatialIndex::Proxy) {
+			*out++ = { &r, r._getLayerSlot() };
+		});
+
+		auto end = out;
+		out = begin;
+		for (auto candidate = begin; candidate < end; ++candidate) {
+			auto& r = *candidate->renderable;
+			if (r.canBeRendered() and _cull(layer, viewport, r)) {
+				*out++ = *candidate;
+			}
+		}
+
+		//the index doesn't keep the order, restore it
+		if (not layer.sortElements) {
+			std::sort(begin, out, [](const RenderQueue::VisibleElement& a, const RenderQueue::VisibleElement& b) {
+				return a.index < b.index;
+			});
+		}
+	}
+	else if (not layer.orthographic) {
+		//gather the world bounds of the candidates in the chunk's slice, then test them against the frustum in bulk
+		uint32_t candidates = chunk.begin;
+		for (auto i = chunk.begin; i < chunk.end; ++i) {
+			auto& r = *layer.elements[i];
+			if (r.canBeRendered()) {
+				auto& mesh = r.getMesh().unwrap();
+				queue.bounds.set(candidates, r.getObject().getWorldTransform(), mesh.getBounds().scale(r.scale));
+				queue.visible[candidates++] = { &r, i };
+			}
+		}
 
+		auto inFrustum = queue.inFrustum.data() + chunk.begin;
+		auto count = BoundsMath::cullFrustum(viewport.getFrustumPlanes(), queue.bounds, chunk.begin, candidates, inFrustum);
+
+		//the passing indices are ascending, so the list can be compacted in place
+		for (auto i : range(count)) {
+			*out++ = queue.visible[inFrustum[i]];
+		}
+	}
+	else {
+		for (auto i = chunk.begin; i < chunk.end; ++i) {
+			auto& r = *layer.elements[i];
+			if (r.canBeRendered() and _cull(layer, viewport, r)) {
+				*out++ = { &r, i };
+			}
+		}
+	}
+
+	chunk.visibleCount = (uint32_t)(out - begin);
+}
+
+void Renderer::_drawOccluders(RenderQueue& queue, uint32_t queueIdx) {
+	auto& buffer = *queue.occlusion;
+	buffer.clear();
+
+	//only the occluders that passed frustum culling are drawn
+	for (auto&& chunk : mCullChunks) {
+		if (chunk.queue != queueIdx) {
+			continue;
+		}
+
+		auto visible = queue.visible.data() + chunk.begin;
+		for (auto i : range(chunk.visibleCount)) {
+			auto& r = *visible[i].renderable;
+			if (auto occluder = r.getOccluderMesh().to_ref()) {
+				auto world = r.getTransform();
+				world[3][2] += queue.layer->zOffset;
+				buffer.drawMesh(occluder.get(), queue.viewProjection * world);
+			}
+		}
+	}
+
+	buffer.buildHierarchy();
+}
+
+void Renderer::_occludeChunk(CullChunk& chunk) {
+	auto& queue = mQueues[chunk.queue];
+	if (not queue.occlusionEnabled) {
+		return;
+	}
+
+	auto& buffer = *queue.occlusion;
+	auto zOffset = Vector(0, 0, queue.layer->zOffset);
+
+	//compact the visible list in place, keeping the order
+	auto begin = queue.visible.data() + chunk.begin;
+	auto out = begin;
+	for (auto i : range(chunk.visibleCount)) {
+		auto& bounds = begin[i].renderable->getGraphicsAABB();
+		if (buffer.isVisible({ bounds.min + zOffset, bounds.max + zOffset }, queue.viewProjection)) {
+			*out++ = begin[i];
+		}
+	}
+
+	auto visibleCount = (uint32_t)(out - begin);
+	chunk.occludedCount = chunk.visibleCount - visibleCount;
+	chunk.visibleCount = visibleCount;
+}
+
+void Renderer::_packChunk(const CullChunk& chunk) {
+	auto& queue = mQueues[chunk.queue];
+
+	auto visible = queue.visible.data() + chunk.begin;
+	auto out = queue.packets.data() + chunk.packetOffset;
+	for (auto i : range(chunk.visibleCount)) {
+		out[i] = _makePacket(queue, *visible[i].renderable, visible[i].index);
+	}
+}
+
+void Renderer::_sortQueue(RenderQueue& queue) {
+	auto& packets = queue.packets;
+
+	if (packets.empty() or not queue.layer->sortElements) {
+		return;
+	}
+
+#ifndef PUBLISH
+	int unsortedChanges = 0;
+	for (size_t i = 1; i < packets.size(); ++i) {
+		unsortedChanges += _countStateChanges(packets[i - 1].state, packets[i].state);
+	}
+#endif
+
+	std::sort(packets.begin(), packets.end());
+
+#ifndef PUBLISH
+	int sortedChanges = 0;
+	for (size_t i = 1; i < packets.size(); ++i) {
+		sortedChanges += _countStateChanges(packets[i - 1].state, packets[i].state);
+	}
+
+	queue.stateChanges = sortedChanges;
+	queue.stateChangesAvoided = unsortedChanges - sortedChanges;
+#endif
+}
+
+void Renderer::_beginViewport(Viewport& viewport) {
 	viewport.getFramebuffer().bind();
 
 	globalUniforms.targetDimension = {
@@ -364,18 +961,9 @@ void Renderer::_renderViewport(Viewport& viewport) {
 
 	globalUniforms.view = viewport.getViewTransform();
 	globalUniforms.viewDirection = viewport.getObject().getWorldDirection();
+}
 
-	if (viewport.getVisibleLayers().empty()) { //using the default layer ordering/visibility
-		for (auto&& l : layers) {
-			_renderLayer(viewport, l);
-		}
-	}
-	else { //use the custom layer ordering/visibility
-		for (auto&& layer : viewport.getVisibleLayers()) {
-			_renderLayer(viewport, getLayer(layer));
-		}
-	}
-
+void Renderer::_endViewport(Viewport& viewport) {
 	if(viewport.getInvalidatePreviousViewportsAfterFrame()) {
 		//invalidate all viewports before this one
 		for (auto&& v : viewportList) {
@@ -388,41 +976,372 @@ void Renderer::_renderViewport(Viewport& viewport) {
 	}
 }
 
-void Dojo::Renderer::_updateRenderables(LayerList& layers, float dt) {
-	for (auto&& layer : layers) {
-		do {
-			//repeat the update on the whole layer if any element is added or removed
-			//TODO this isn't risky but very inefficient, find another way!
-			layer.elementsChangedThisFrame = false;
-			for (auto&& r : layer.elements) {
-				if ((r->getObject().isActive() and r->isVisible()) or r->getGraphicsAABB().isEmpty()) {
-					r->update(dt);
-					if (layer.elementsChangedThisFrame) {
-						break;
-					}
-				}
+void Renderer::_uploadViewUniforms() {
+	if (not mUniformRing) {
+		return;
+	}
+
+	auto& dimension = globalUniforms.targetDimension;
+
+	ViewUniformBlock block;
+	block.view = globalUniforms.view;
+	block.projection = globalUniforms.projection;
+	block.viewProjection = globalUniforms.viewProjection;
+	block.viewDirection = glm::vec4(globalUniforms.viewDirection, 0.f);
+	block.targetDimension = { dimension.x, dimension.y, 1.f / dimension.x, 1.f / dimension.y };
+	block.time = { globalUniforms.time, 0.f, 0.f, 0.f };
+
+	//consecutive layers with the same projection keep using the same block
+	if (mViewBlockUploaded and memcmp(&block, &mLastViewBlock, sizeof(block)) == 0) {
+		return;
+	}
+
+	auto allocation = mUniformRing->map(sizeof(block));
+	memcpy(allocation.data, &block, sizeof(block));
+	mUniformRing->unmap();
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, enum_cast(Shader::UniformBlock::View), mUniformRing->getGLHandle(), allocation.offset, sizeof(block));
+
+	mLastViewBlock = block;
+	mViewBlockUploaded = true;
+}
+
+void Renderer::_uploadDrawUniforms(const RenderState& renderState) {
+	if (not mUniformRing or not renderState.getShader().unwrap().usesUniformBlock(Shader::UniformBlock::Draw)) {
+		return;
+	}
+
+	auto allocation = mUniformRing->map(sizeof(DrawUniformBlock));
+	auto& block = *(DrawUniformBlock*)allocation.data;
+	block.world = globalUniforms.world;
+	block.worldView = globalUniforms.worldView;
+	block.worldViewProjection = globalUniforms.worldViewProjection;
+	block.objectColor = { renderState.color.r, renderState.color.g, renderState.color.b, renderState.color.a };
+	mUniformRing->unmap();
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, enum_cast(Shader::UniformBlock::Draw), mUniformRing->getGLHandle(), allocation.offset, sizeof(DrawUniformBlock));
+}
+
+void Renderer::_submitQueue(const RenderQueue& queue) {
+	auto& layer = *queue.layer;
+	auto& viewport = *queue.viewport;
+
+	if (queue.packets.empty()) {
+		return;
+	}
+
+	//depth TEST actually is required even just to write...
+	if (layer.usesDepth()) {
+		DEBUG_ASSERT(viewport.getFramebuffer().hasDepth(), "Depth won't work without an attachment");
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(layer.depthWrite);
+		glDepthFunc(layer.depthTest ? GL_LESS : GL_ALWAYS);
+	}
+	else {
+		glDisable(GL_DEPTH_TEST);
+	}
+
+	//set projection state
+	globalUniforms.view = queue.view;
+	globalUniforms.projection = queue.projection;
+	globalUniforms.viewProjection = queue.viewProjection;
+
+	_uploadViewUniforms();
+
+	bool batchSprites = layer.batchSprites and layer.orthographic and not layer.usesDepth();
+
+	//draw, merging the runs of compatible elements that use an instanced shader, and the runs of sprites from the same atlas
+	auto packet = queue.packets.data();
+	auto end = packet + queue.packets.size();
+	while (packet < end) {
+		auto& r = *packet->renderable;
+
+		if (packet->shader->isInstanced()) {
+			auto runEnd = packet + 1;
+			//the packets know the LOD to draw, the Renderables still have the one of their last draw
+			while (runEnd < end and runEnd->mesh == packet->mesh and runEnd->renderable->canBeInstancedWith(r)) {
+				++runEnd;
+			}
+
+			_renderInstanced(layer, packet, runEnd);
+			packet = runEnd;
+			continue;
+		}
+
+		if (batchSprites and SpriteBatcher::isSprite(r)) {
+			auto runEnd = packet + 1;
+			while (runEnd < end and SpriteBatcher::canBatchTogether(r, *runEnd->renderable)) {
+				++runEnd;
 			}
-		} while (layer.elementsChangedThisFrame);
+
+			if (runEnd - packet > 1) {
+				_renderSpriteBatch(layer, packet, runEnd);
+				packet = runEnd;
+				continue;
+			}
+		}
+
+		_renderPacket(*packet);
+		++packet;
 	}
 }
 
+void Renderer::_updateElement(LayerList& layers, size_t layerIdx, size_t elementIdx, float dt) {
+	auto renderable = layers[layerIdx].elements[(int)elementIdx];
+
+	//removed earlier in this pass
+	if (not renderable) {
+		return;
+	}
+
+	if ((renderable->getObject().isActive() and renderable->isVisible()) or renderable->getGraphicsAABB().isEmpty()) {
+		auto bounds = renderable->getGraphicsAABB();
+		renderable->update(dt);
+
+		//the update might have removed the element itself, or added a layer
+		auto& layer = layers[layerIdx];
+		bool removed = layer.elements[(int)elementIdx] != renderable;
+		if (layer.spatialIndex and not removed and renderable->getGraphicsAABB() != bounds) {
+			layer._onElementMoved(*renderable);
+		}
+	}
+}
+
+void Renderer::_updateRenderables(LayerList& layers, float dt) {
+	//additions and removals are deferred until the end of the pass, so each element is updated exactly once
+	mUpdatingRenderables = true;
+
+	for (size_t i = 0; i < layers.size(); ++i) {
+		for (size_t j = 0; j < layers[i].elements.size(); ++j) {
+			_updateElement(layers, i, j, dt);
+		}
+	}
+
+	//apply the changes; the added elements weren't updated yet, and updating them can add or remove more
+	bool changed;
+	do {
+		changed = false;
+		for (size_t i = 0; i < layers.size(); ++i) {
+			auto& layer = layers[i];
+
+			if (layer.hasRemovedElements) {
+				layer.elements.eraseIf([](Renderable* r) { return r == nullptr; });
+				layer.hasRemovedElements = false;
+				layer._updateSlots(0);
+			}
+
+			if (layer.addedElements.empty()) {
+				continue;
+			}
+
+			changed = true;
+
+			auto first = layer.elements.size();
+			for (auto&& r : layer.addedElements) {
+				layer.elements.emplace(r);
+			}
+			layer.addedElements.clear();
+			layer._updateSlots(first);
+
+			for (auto j = first; j < layers[i].elements.size(); ++j) {
+				_updateElement(layers, i, j, dt);
+			}
+		}
+	} while (changed);
+
+	mUpdatingRenderables = false;
+}
+
 void Renderer::renderFrame(float dt) {
 	DEBUG_ASSERT(not frameStarted, "Tried to start rendering but the frame was already started" );
 
 	frameVertexCount = frameTriCount = frameBatchCount = 0;
+	frameStateChangeCount = frameStateChangesAvoided = 0;
+
+	//the objects were moved by the game before the frame started
+	frameTransformUpdateCount = (int)Object::gTransformUpdateCount;
+	Object::gTransformUpdateCount = 0;
+
+	frameVertexArrayHits = (int)Mesh::gVertexArrayHits;
+	frameVertexArrayMisses = (int)Mesh::gVertexArrayMisses;
+	Mesh::gVertexArrayHits = Mesh::gVertexArrayMisses = 0;
+
 	frameStarted = true;
 
+	globalUniforms.time += dt;
+	mViewBlockUploaded = false;
+
+	//streaming Meshes need to be bound again to notice that last frame's data is gone
+	Mesh::gBufferBindingsDirty = true;
+
+	auto stageStart = Timer::currentTime();
+
 	//update all the renderables
 	_updateRenderables(layers, dt);
 
-	//render all the viewports
+	auto cullStart = Timer::currentTime();
+	frameUpdateTime = cullStart - stageStart;
+
+	//build all the queues in parallel, the scene is only read from now on
+	_prepareQueues();
+
+	auto& pool = Platform::singleton().getBackgroundPool();
+
+	pool.parallelFor((uint32_t)mCullChunks.size(), [this](uint32_t i) {
+		_cullChunk(mCullChunks[i]);
+	});
+
+	//the occluders need the whole queue culled before they can hide anything
+	pool.parallelFor((uint32_t)mQueueCount, [this](uint32_t i) {
+		if (mQueues[i].occlusionEnabled) {
+			_drawOccluders(mQueues[i], i);
+		}
+	});
+
+	pool.parallelFor((uint32_t)mCullChunks.size(), [this](uint32_t i) {
+		_occludeChunk(mCullChunks[i]);
+	});
+
+	//lay out the visible elements of each chunk contiguously in its queue's packet list, which keeps its capacity across frames
+	frameOccludedCount = 0;
+	for (auto&& chunk : mCullChunks) {
+		frameOccludedCount += chunk.occludedCount;
+
+		auto& packets = mQueues[chunk.queue].packets;
+		chunk.packetOffset = (uint32_t)packets.size();
+		packets.resize(packets.size() + chunk.visibleCount);
+	}
+
+	pool.parallelFor((uint32_t)mCullChunks.size(), [this](uint32_t i) {
+		_packChunk(mCullChunks[i]);
+	});
+
+	pool.parallelFor((uint32_t)mQueueCount, [this](uint32_t i) {
+		_sortQueue(mQueues[i]);
+	});
+
+	auto submitStart = Timer::currentTime();
+	frameCullTime = submitStart - cullStart;
+
+	//the mips requested by this frame's packets are streamed in before they are drawn
+	if (mTextureStreamer) {
+		mTextureStreamer->update();
+	}
+
+	if (mGPUTimer) {
+		mGPUTimer->beginFrame();
+	}
+
+	//time queries can't be nested, so each step is timed on its own and the viewport is the sum of its steps
+	auto timeSection = [this](Viewport& viewport, RenderLayer::ID layerID, const std::function<void()>& section) {
+		if (mGPUTimer) {
+			mGPUTimer->begin({ &viewport, layerID });
+			section();
+			mGPUTimer->end();
+		}
+		else {
+			section();
+		}
+	};
+
+	//submit them in order on this thread
+	size_t queueIdx = 0;
 	for (auto&& viewport : viewportList) {
-		_renderViewport(*viewport);
+		timeSection(*viewport, RenderLayer::InvalidID, [&]() {
+			_beginViewport(*viewport);
+		});
+
+		for (; queueIdx < mQueueCount and mQueues[queueIdx].viewport == viewport; ++queueIdx) {
+			auto& queue = mQueues[queueIdx];
+			timeSection(*viewport, queue.layerID, [&]() {
+				_submitQueue(queue);
+			});
+
+			frameStateChangeCount += queue.stateChanges;
+			frameStateChangesAvoided += queue.stateChangesAvoided;
+		}
+
+		timeSection(*viewport, RenderLayer::InvalidID, [&]() {
+			_endViewport(*viewport);
+		});
+	}
+
+	if (mGPUTimer) {
+		mGPUTimer->endFrame();
 	}
 
+	_fenceStreams();
+
+	frameSubmitTime = Timer::currentTime() - submitStart;
+
 	frameStarted = false;
 }
 
+float Renderer::getLastFrameGPUTime() const {
+	return mGPUTimer ? mGPUTimer->getLastTimings().frame : 0.f;
+}
+
+float Renderer::getLastViewportGPUTime(const Viewport& viewport) const {
+	if (mGPUTimer) {
+		for (auto&& entry : mGPUTimer->getLastTimings().viewports) {
+			if (entry.first == &viewport) {
+				return entry.second;
+			}
+		}
+	}
+	return 0.f;
+}
+
+float Renderer::getLastLayerGPUTime(RenderLayer::ID layerID) const {
+	if (mGPUTimer) {
+		auto& layers = mGPUTimer->getLastTimings().layers;
+		if (layerID < layers.size()) {
+			return layers[layerID];
+		}
+	}
+	return 0.f;
+}
+
+optional_ref<TextureStreamer> Renderer::getTextureStreamer() {
+	if (mTextureStreamer) {
+		return *mTextureStreamer;
+	}
+	return{};
+}
+
+void Renderer::bindDefaultVertexArray() {
+	glBindVertexArray(mDefaultVAO);
+}
+
+optional_ref<StreamingBuffer> Renderer::getVertexStream() {
+	if (mVertexRing) {
+		return *mVertexRing;
+	}
+	return{};
+}
+
+optional_ref<StreamingBuffer> Renderer::getIndexStream() {
+	if (mIndexRing) {
+		return *mIndexRing;
+	}
+	return{};
+}
+
+void Renderer::_fenceStreams() {
+	frameStreamingWraps = frameStreamingFenceWaits = 0;
+
+	//the data streamed in this frame can be recycled once the GPU is done with it
+	for (auto ring : { mUniformRing.get(), mVertexRing.get(), mIndexRing.get() }) {
+		if (ring) {
+			ring->fence();
+
+			frameStreamingWraps += ring->getWrapCount();
+			frameStreamingFenceWaits += ring->getFenceWaitCount();
+			ring->resetStats();
+		}
+	}
+}
+
 void Renderer::endFrame() {
 	submitter.get().submitFrame();
 }
@@ -1,19 +1,166 @@
 #include "ResourceGroup.h"
 
 #include "Platform.h"
+#include "ResourceLoader.h"
 #include "Timer.h"
 #include "FrameSet.h"
 #include "Mesh.h"
+#include "MeshPack.h"
 #include "Font.h"
 #include "Table.h"
 #include "SoundSet.h"
 #include "SoundBuffer.h"
 
 #include "Texture.h"
+#include "TextureContainer.h"
+#include "AtlasPacker.h"
 #include "Path.h"
+#include "Base64.h"
+#include "TinySHA1.h"
+#include "range.h"
 
 using namespace Dojo;
 
+int64_t _getFileSize(utf::string_view path) {
+	auto file = Platform::singleton().getFile(path);
+	return file->open(Stream::Access::Read) ? file->getSize() : -1;
+}
+
+uint32_t _readBE(const uint8_t* data, int bytes) {
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; ++i) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+///reads the size of a PNG or JPEG image from its header, without decoding it
+bool _readImageSize(utf::string_view path, uint32_t& width, uint32_t& height) {
+	auto file = Platform::singleton().loadFileContent(path);
+	auto data = file.data();
+	auto size = file.size();
+
+	//PNG starts with the IHDR chunk
+	static const uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G' };
+	if (size >= 24 and memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+		width = _readBE(data + 16, 4);
+		height = _readBE(data + 20, 4);
+		return true;
+	}
+
+	//JPEG has to be scanned until the start of frame segment
+	if (size >= 4 and data[0] == 0xFF and data[1] == 0xD8) {
+		size_t pos = 2;
+		while (pos + 9 < size and data[pos] == 0xFF) {
+			auto marker = data[pos + 1];
+			if (marker == 0xFF) { //padding
+				++pos;
+				continue;
+			}
+
+			if (marker >= 0xC0 and marker <= 0xCF and marker != 0xC4 and marker != 0xC8 and marker != 0xCC) {
+				height = _readBE(data + pos + 5, 2);
+				width = _readBE(data + pos + 7, 2);
+				return true;
+			}
+
+			pos += 2 + _readBE(data + pos + 2, 2);
+		}
+	}
+
+	return false;
+}
+
+///packs the frames that are small enough, and returns the layout in the format of the cache
+Table _packFrames(const std::vector<Texture*>& frames, const std::vector<int64_t>& fileSizes) {
+	struct Rect {
+		uint32_t frame, width, height;
+	};
+
+	std::vector<Rect> rects;
+	for (auto i : range(frames.size())) {
+		uint32_t width, height;
+		if (fileSizes[i] >= 0 and _readImageSize(frames[i]->getFilePath(), width, height) and
+			width > 0 and height > 0 and width <= AtlasPage::MaxTileSide and height <= AtlasPage::MaxTileSide) {
+			rects.push_back({ (uint32_t)i, width, height });
+		}
+	}
+
+	//the skyline wastes less when the tallest go first
+	std::stable_sort(rects.begin(), rects.end(), [](const Rect& a, const Rect& b) {
+		return a.height > b.height or (a.height == b.height and a.width > b.width);
+	});
+
+	struct Placement {
+		int page = -1;
+		uint32_t x = 0, y = 0, width = 0, height = 0;
+	};
+
+	std::vector<Placement> placements(frames.size());
+	std::vector<AtlasPacker> packers;
+	std::vector<uint32_t> tileCounts;
+
+	for (auto&& rect : rects) {
+		auto& placement = placements[rect.frame];
+		uint32_t x, y;
+
+		for (auto i : range(packers.size())) {
+			if (packers[i].insert(rect.width + AtlasPage::Gutter, rect.height + AtlasPage::Gutter, x, y)) {
+				placement.page = (int)i;
+				break;
+			}
+		}
+
+		if (placement.page < 0) {
+			packers.emplace_back(AtlasPage::MaxSide, AtlasPage::MaxSide);
+			packers.back().insert(rect.width + AtlasPage::Gutter, rect.height + AtlasPage::Gutter, x, y);
+			placement.page = (int)packers.size() - 1;
+			tileCounts.push_back(0);
+		}
+
+		++tileCounts[placement.page];
+		placement.x = x + AtlasPage::Gutter / 2;
+		placement.y = y + AtlasPage::Gutter / 2;
+		placement.width = rect.width;
+		placement.height = rect.height;
+	}
+
+	//a page with a single tile saves nothing, its frame stays loose
+	Table layout;
+	auto& pages = layout.createTable("pages");
+	std::vector<int> pageIndices(packers.size(), -1);
+	int pageCount = 0;
+
+	for (auto i : range(packers.size())) {
+		if (tileCounts[i] > 1) {
+			auto& page = pages.createTable();
+			page.set("width", (float)glm::ceilPowerOfTwo(packers[i].getUsedWidth()));
+			page.set("height", (float)glm::ceilPowerOfTwo(packers[i].getUsedHeight()));
+			pageIndices[i] = pageCount++;
+		}
+	}
+
+	auto& entries = layout.createTable("frames");
+	for (auto i : range(frames.size())) {
+		auto& placement = placements[i];
+		auto& entry = entries.createTable();
+		entry.set("path", frames[i]->getFilePath().copy());
+		entry.set("bytes", fileSizes[i]);
+
+		auto page = placement.page >= 0 ? pageIndices[placement.page] : -1;
+		entry.set("page", (float)page);
+
+		if (page >= 0) {
+			entry.set("x", (float)placement.x);
+			entry.set("y", (float)placement.y);
+			entry.set("width", (float)placement.width);
+			entry.set("height", (float)placement.height);
+		}
+	}
+
+	return layout;
+}
+
 ResourceGroup::ResourceGroup() :
 	finalized(false),
 	disableBilinear(false),
@@ -168,6 +315,25 @@ void ResourceGroup::addMeshes(utf::string_view subdirectory) {
 
 		addMesh(make_unique<Mesh>(self, path), name);
 	}
+
+	//each pack holds many meshes, named as their entries; they are cooked already, so they aren't optimized
+	paths.clear();
+	Platform::singleton().getFilePathsForType("meshpack", subdirectory, paths);
+
+	for (auto&& path : paths) {
+		auto pack = std::make_shared<MeshPack>(path);
+
+		if (not pack->isValid()) {
+			DEBUG_MESSAGE("Skipping the invalid mesh pack " + path);
+			continue;
+		}
+
+		for (auto i : range(pack->getEntryCount())) {
+			if (pack->getEntry(i).lodOf == MeshPack::NotALOD) {
+				addMesh(make_unique<Mesh>(self, pack, i), pack->getEntryName(i));
+			}
+		}
+	}
 }
 
 void ResourceGroup::addSounds(utf::string_view subdirectory) {
@@ -231,27 +397,147 @@ void ResourceGroup::addShaders(utf::string_view folder) {
 }
 
 void ResourceGroup::loadResources(bool recursive) {
-	_load<FrameSet>(frameSets);
-	_load<Font>(fonts);
-	_load<Mesh>(meshes);
-	_load<SoundSet>(sounds);
-	_load<Table>(tables);
-	_load<ShaderProgram>(programs);
-	_load<Shader>(shaders);
+	_cancelLoading();
 
-	//load sets again to load missing atlases!
-	_load<FrameSet>(frameSets);
+	ResourceLoader(self, recursive).loadNow();
+}
 
-	if (recursive)
-		for (auto&& sub : subs) {
-			sub->loadResources(recursive);
+void ResourceGroup::loadResourcesAsync(AsyncCallback onLoaded, bool recursive) {
+	_cancelLoading();
+
+	mLoader = make_shared<ResourceLoader>(self, recursive);
+	mLoader->start(std::move(onLoaded));
+}
+
+bool ResourceGroup::isLoading() const {
+	return mLoader and not mLoader->isDone();
+}
+
+float ResourceGroup::getLoadingProgress() const {
+	return mLoader ? mLoader->getProgress() : 1.f;
+}
+
+void ResourceGroup::_cancelLoading() {
+	if (isLoading()) {
+		mLoader->cancel();
+	}
+
+	mLoader = {};
+}
+
+void ResourceGroup::_packLooseFrames() {
+	//the loose images that aren't loaded yet; compressed images stay loose, they come with their own mips
+	std::vector<Texture*> frames;
+	for (auto&& pair : frameSets) {
+		auto& set = *pair.second;
+		for (auto i : range(set.getFrameNumber())) {
+			auto& frame = set.getFrame(i);
+			auto owner = frame.getOwnerFrameSet().to_ref();
+
+			if (owner and &owner.get() == &set and frame.isReloadable() and not frame.isLoaded() and not frame.isPending() and
+				frame.getParentAtlas().is_none() and not TextureContainer::hasVariant(frame.getFilePath())) {
+				frames.push_back(&frame);
+			}
+		}
+	}
+
+	if (frames.size() < 2) {
+		return;
+	}
+
+	//the cache is named after the list of frames, and it's valid while the files keep their size
+	SHA1 sha;
+	std::vector<int64_t> fileSizes;
+	for (auto&& frame : frames) {
+		auto path = frame->getFilePath().copy();
+		sha.processBytes(path.bytes().data(), path.bytes().size());
+		fileSizes.push_back(_getFileSize(path));
+	}
+
+	SHA1::digest8_t digest;
+	utf::string cacheName = "atlas_" + Base64::fromBytes(sha.getDigestBytes(digest), sizeof(digest));
+	Path::removeInvalidChars(cacheName);
+
+	auto layout = Platform::singleton().load(cacheName);
+	auto& cachedFrames = layout.getTable("frames");
+
+	bool cached = cachedFrames.getArrayLength() == (int)frames.size();
+	for (int i = 0; cached and i < cachedFrames.getArrayLength(); ++i) {
+		auto& entry = cachedFrames.getTable(i);
+		cached = entry.getString("path") == frames[i]->getFilePath() and entry.getInt64("bytes", -2) == fileSizes[i];
+	}
+
+	if (not cached) {
+		layout = _packFrames(frames, fileSizes);
+		Platform::singleton().save(layout, cacheName);
+	}
+
+	auto firstPage = mAtlasPages.size();
+	auto& pages = layout.getTable("pages");
+	for (int i = 0; i < pages.getArrayLength(); ++i) {
+		auto& page = pages.getTable(i);
+		mAtlasPages.emplace_back(make_unique<AtlasPage>(self, page.getInt("width"), page.getInt("height")));
+	}
+
+	auto& entries = layout.getTable("frames");
+	int tileCount = 0;
+	for (auto i : range(frames.size())) {
+		auto& entry = entries.getTable((int)i);
+		auto page = entry.getInt("page", -1);
+		if (page < 0) {
+			continue;
+		}
+
+		auto& atlas = *mAtlasPages[firstPage + page];
+		int x = entry.getInt("x"), y = entry.getInt("y"), width = entry.getInt("width"), height = entry.getInt("height");
+
+		atlas.addTile(frames[i]->getFilePath(), x, y, width, height);
+		frames[i]->loadFromAtlas(atlas, x, y, width, height);
+		++tileCount;
+	}
+
+	if (logchanges) {
+		DEBUG_MESSAGE("packed " + utf::to_string(tileCount) + " frames in " + utf::to_string(pages.getArrayLength()) + " atlas pages" + (cached ? " (cached)" : ""));
+	}
+}
+
+void ResourceGroup::_unloadAtlasPages(bool soft) {
+	//the pages go after their tiles
+	for (auto&& page : mAtlasPages) {
+		if (page->isLoaded()) {
+			page->onUnload(soft);
+		}
+	}
+
+	if (not soft) {
+		//the frames packed in the pages are kept, and load from their own files again until they are packed anew
+		for (auto&& pair : frameSets) {
+			auto& set = *pair.second;
+			for (auto i : range(set.getFrameNumber())) {
+				auto& frame = set.getFrame(i);
+				auto atlas = frame.getParentAtlas().to_raw_ptr();
+
+				bool inPage = std::any_of(mAtlasPages.begin(), mAtlasPages.end(), [atlas](const Unique<AtlasPage>& page) {
+					return page.get() == atlas;
+				});
+
+				if (atlas and inPage) {
+					frame._detachFromAtlas();
+				}
+			}
 		}
+
+		mAtlasPages.clear();
+	}
 }
 
 void ResourceGroup::unloadResources(bool recursive) {
+	_cancelLoading();
+
 	//FONTS DEPEND ON SETS, DO NOT FREE BEFORE
 	_unload<Font>(fonts, false);
 	_unload<FrameSet>(frameSets, false);
+	_unloadAtlasPages(false);
 	_unload<Mesh>(meshes, false);
 	_unload<SoundSet>(sounds, false);
 	_unload<Table>(tables, false);
@@ -266,8 +552,11 @@ void ResourceGroup::unloadResources(bool recursive) {
 }
 
 void ResourceGroup::softUnloadResources(bool recursive) {
+	_cancelLoading();
+
 	_unload<Font>(fonts, true);
 	_unload<FrameSet>(frameSets, true);
+	_unloadAtlasPages(true);
 	_unload<Mesh>(meshes, true);
 	_unload<SoundSet>(sounds, true);
 	_unload<Table>(tables, true);
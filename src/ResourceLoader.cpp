@@ -0,0 +1,249 @@
+#include "ResourceLoader.h"
+
+#include "ResourceGroup.h"
+#include "Platform.h"
+#include "WorkerPool.h"
+#include "Texture.h"
+#include "Timer.h"
+#include "range.h"
+
+using namespace Dojo;
+
+//how long a batch of onLoad() calls can take on the main thread, in seconds
+static const double FINISH_BATCH_TIME = 0.004;
+
+ResourceLoader::ResourceLoader(ResourceGroup& group, bool recursive) {
+	std::vector<ResourceGroup*> groups;
+	_collectGroups(group, recursive, groups);
+
+	//the Textures are loaded on their own, so that the frames of a FrameSet are decoded in parallel
+	std::unordered_map<Texture*, uint32_t> textureNodes;
+	for (auto&& g : groups) {
+		if (g->packLooseFrames) {
+			g->_packLooseFrames();
+		}
+
+		for (auto&& page : g->mAtlasPages) {
+			if (not page->isLoaded()) {
+				textureNodes[page.get()] = _addNode(*page);
+			}
+		}
+
+		for (auto&& pair : g->frameSets) {
+			auto& set = *pair.second;
+			for (auto i : range(set.getFrameNumber())) {
+				auto& texture = set.getFrame(i);
+				auto owner = texture.getOwnerFrameSet().to_ref();
+
+				if (owner and &owner.get() == &set and not texture.isLoaded() and not texture.isPending()) {
+					textureNodes[&texture] = _addNode(texture);
+				}
+			}
+		}
+	}
+
+	//tiles wait for their atlas, even when it belongs to another FrameSet or to a subgroup
+	for (auto&& pair : textureNodes) {
+		if (auto atlas = pair.first->getParentAtlas().to_ref()) {
+			auto atlasNode = textureNodes.find(&atlas.get());
+			if (atlasNode != textureNodes.end()) {
+				_addDependency(pair.second, atlasNode->second);
+			}
+		}
+	}
+
+	for (auto&& g : groups) {
+		for (auto&& pair : g->frameSets) {
+			auto& set = *pair.second;
+			if (set.isLoaded()) {
+				continue;
+			}
+
+			auto node = _addNode(set);
+			for (auto i : range(set.getFrameNumber())) {
+				auto textureNode = textureNodes.find(&set.getFrame(i));
+				if (textureNode != textureNodes.end()) {
+					_addDependency(node, textureNode->second);
+				}
+			}
+		}
+	}
+
+	std::vector<uint32_t> programNodes, shaderNodes;
+	for (auto&& g : groups) {
+		_addAll(g->fonts);
+		_addAll(g->meshes);
+		_addAll(g->sounds);
+		_addAll(g->tables);
+		_addAll(g->programs, &programNodes);
+	}
+
+	//Shaders find their programs by name, in any group
+	for (auto&& g : groups) {
+		_addAll(g->shaders, &shaderNodes);
+	}
+
+	for (auto shader : shaderNodes) {
+		for (auto program : programNodes) {
+			_addDependency(shader, program);
+		}
+	}
+}
+
+void ResourceLoader::_collectGroups(ResourceGroup& group, bool recursive, std::vector<ResourceGroup*>& groups) {
+	if (std::find(groups.begin(), groups.end(), &group) != groups.end()) {
+		return;
+	}
+
+	groups.push_back(&group);
+
+	if (recursive) {
+		for (auto&& sub : group.subs) {
+			_collectGroups(*sub, recursive, groups);
+		}
+	}
+}
+
+uint32_t ResourceLoader::_addNode(Resource& resource) {
+	Node node;
+	node.resource = &resource;
+	mNodes.emplace_back(std::move(node));
+
+	return (uint32_t)mNodes.size() - 1;
+}
+
+void ResourceLoader::_addDependency(uint32_t node, uint32_t dependency) {
+	mNodes[dependency].dependents.push_back(node);
+	++mNodes[node].waitingFor;
+}
+
+float ResourceLoader::getProgress() const {
+	return mNodes.empty() ? 1.f : (float)mDoneCount / (float)mNodes.size();
+}
+
+void ResourceLoader::loadNow() {
+	std::vector<uint32_t> ready, next;
+	for (auto i : range(mNodes.size())) {
+		if (mNodes[i].waitingFor == 0) {
+			ready.push_back((uint32_t)i);
+		}
+	}
+
+	auto& pool = Platform::singleton().getBackgroundPool();
+
+	while (ready.size() > 0) {
+		pool.parallelFor((uint32_t)ready.size(), [&](uint32_t i) {
+			mNodes[ready[i]].resource->onPrepare();
+		});
+
+		next.clear();
+		for (auto node : ready) {
+			_finish(node, next);
+		}
+
+		std::swap(ready, next);
+	}
+
+	DEBUG_ASSERT(isDone(), "The Resources have a circular dependency");
+}
+
+void ResourceLoader::start(AsyncCallback callback) {
+	mCallback = std::move(callback);
+
+	for (auto i : range(mNodes.size())) {
+		if (mNodes[i].waitingFor == 0) {
+			_prepare((uint32_t)i);
+		}
+	}
+
+	if (isDone() and mCallback) {
+		mCallback();
+	}
+}
+
+void ResourceLoader::cancel() {
+	mCancelled = true;
+
+	//the Resources being prepared must not be destroyed under the workers
+	if (mInFlight > 0) {
+		Platform::singleton().getBackgroundPool().sync();
+	}
+}
+
+void ResourceLoader::_prepare(uint32_t node) {
+	auto loader = shared_from_this();
+	++mInFlight;
+
+	Platform::singleton().getBackgroundPool().queue([loader, node] {
+		if (not loader->mCancelled) {
+			loader->mNodes[node].resource->onPrepare();
+		}
+	},
+	[loader, node] { //then, on the main thread
+		--loader->mInFlight;
+
+		if (not loader->mCancelled) {
+			loader->mPrepared.push_back(node);
+			loader->_queueFinish();
+		}
+	});
+}
+
+void ResourceLoader::_queueFinish() {
+	if (mFinishQueued) {
+		return;
+	}
+
+	mFinishQueued = true;
+
+	auto loader = shared_from_this();
+	Platform::singleton().getMainThreadPool().queue([loader] {
+		loader->mFinishQueued = false;
+
+		if (not loader->mCancelled) {
+			loader->_finishPrepared();
+		}
+	});
+}
+
+void ResourceLoader::_finishPrepared() {
+	std::vector<uint32_t> ready;
+	Timer timer;
+
+	size_t finished = 0;
+	while (finished < mPrepared.size() and timer.getElapsedTime() < FINISH_BATCH_TIME) {
+		_finish(mPrepared[finished++], ready);
+	}
+
+	mPrepared.erase(mPrepared.begin(), mPrepared.begin() + finished);
+
+	for (auto node : ready) {
+		_prepare(node);
+	}
+
+	//the rest waits for the next batch
+	if (mPrepared.size() > 0) {
+		_queueFinish();
+	}
+	else if (isDone() and mCallback) {
+		auto callback = std::move(mCallback);
+		callback();
+	}
+}
+
+void ResourceLoader::_finish(uint32_t index, std::vector<uint32_t>& ready) {
+	auto& node = mNodes[index];
+
+	//a Resource can have been loaded by another one, eg. a ShaderProgram by its Shader
+	if (not node.resource->isLoaded()) {
+		node.resource->onLoad();
+	}
+
+	++mDoneCount;
+
+	for (auto dependent : node.dependents) {
+		if (--mNodes[dependent].waitingFor == 0) {
+			ready.push_back(dependent);
+		}
+	}
+}
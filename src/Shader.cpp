@@ -6,6 +6,7 @@
 #include "Viewport.h"
 #include "Renderer.h"
 #include "Texture.h"
+#include "Mesh.h"
 
 #include <glad/glad.h>
 #include "range.h"
@@ -35,11 +36,14 @@ void Shader::_populateUniformNameMap() {
 	sBuiltiInUniformsNameMap["PROJECTION"] = BU_PROJECTION;
 	sBuiltiInUniformsNameMap["WORLDVIEW"] = BU_WORLDVIEW;
 	sBuiltiInUniformsNameMap["WORLDVIEWPROJ"] = BU_WORLDVIEWPROJ;
+	sBuiltiInUniformsNameMap["VIEWPROJ"] = BU_VIEWPROJ;
 	sBuiltiInUniformsNameMap["VIEW_DIRECTION"] = BU_VIEW_DIRECTION;
 	sBuiltiInUniformsNameMap["OBJECT_COLOR"] = BU_OBJECT_COLOR;
 	sBuiltiInUniformsNameMap["TIME"] = BU_TIME;
 	sBuiltiInUniformsNameMap["TARGET_DIMENSION"] = BU_TARGET_DIMENSION;
 	sBuiltiInUniformsNameMap["TARGET_DIMENSION_INV"] = BU_TARGET_DIMENSION_INV;
+	sBuiltiInUniformsNameMap["POSITION_SCALE"] = BU_POSITION_SCALE;
+	sBuiltiInUniformsNameMap["POSITION_OFFSET"] = BU_POSITION_OFFSET;
 }
 
 void Shader::_populateAttributeNameMap() {
@@ -77,9 +81,21 @@ VertexField Shader::_getAttributeForName(const std::string& name) {
 	return elem != sBuiltInAttributeNameMap.end() ? elem->second : VertexField::None;
 }
 
+Shader::InstanceAttribute Shader::_getInstanceAttributeForName(const std::string& name) {
+	if (name == "INSTANCE_WORLD") {
+		return InstanceAttribute::World;
+	}
+	else if (name == "INSTANCE_COLOR") {
+		return InstanceAttribute::Color;
+	}
+	return InstanceAttribute::_Count;
+}
+
 Shader::Shader(optional_ref<ResourceGroup> creator, utf::string_view filePath) :
 	Resource(creator, filePath) {
 	memset(pProgram, 0, sizeof(pProgram)); //init to null
+	mInstanceAttributeLocations.fill(-1);
+	mUniformBlocks.fill(false);
 }
 
 ShaderProgram& Shader::_assignProgram(const Table& desc, ShaderProgramType type) {
@@ -152,6 +168,9 @@ const void* Shader::_getUniformData(const GlobalUniformData& currentState, const
 	case BU_WORLDVIEWPROJ:
 		return &currentState.worldViewProjection;
 
+	case BU_VIEWPROJ:
+		return &currentState.viewProjection;
+
 	case BU_OBJECT_COLOR:
 		return &user.color;
 
@@ -159,8 +178,7 @@ const void* Shader::_getUniformData(const GlobalUniformData& currentState, const
 		return &currentState.viewDirection;
 
 	case BU_TIME:
-		DEBUG_TODO;
-		return nullptr;
+		return &currentState.time;
 
 	case BU_TARGET_DIMENSION:
 		return &currentState.targetDimension;
@@ -171,6 +189,13 @@ const void* Shader::_getUniformData(const GlobalUniformData& currentState, const
 			1.f / currentState.targetDimension.y
 		};
 		return &tmpVec;
+
+	case BU_POSITION_SCALE:
+		return &user.getDrawnMesh().unwrap().getPositionScale();
+
+	case BU_POSITION_OFFSET:
+		return &user.getDrawnMesh().unwrap().getPositionOffset();
+
 	default: { //texture stuff
 		if (builtin >= BU_TEXTURE_0 and builtin <= BU_TEXTURE_N) {
 			tempInt[0] = builtin - BU_TEXTURE_0;
@@ -306,6 +331,9 @@ bool Shader::onLoad() {
 
 	int linked = 0;
 
+	mInstanceAttributeLocations.fill(-1);
+	mUniformBlocks.fill(false);
+
 	//load the descriptor table
 	auto desc = Table::loadFromFile(filePath);
 
@@ -402,7 +430,11 @@ bool Shader::onLoad() {
 			glGetActiveAttrib(mGLProgram, i, sizeof(namebuf), &nameLength, &size, &type, namebuf);
 			auto loc = glGetAttribLocation(mGLProgram, namebuf);
 
-			if (loc >= 0) {
+			auto instanceAttribute = _getInstanceAttributeForName(namebuf);
+			if (loc >= 0 and instanceAttribute != InstanceAttribute::_Count) {
+				mInstanceAttributeLocations[enum_cast(instanceAttribute)] = loc;
+			}
+			else if (loc >= 0) {
 				mAttributes.emplace_back(
 					loc,
 					size,
@@ -410,6 +442,35 @@ bool Shader::onLoad() {
 				);
 			}
 		}
+
+		//4 bits for each of the first 16 locations: the field read there, plus one
+		static_assert((int)VertexField::None < 15, "The vertex fields don't fit in the layout key");
+
+		mVertexLayout = 0;
+		for (auto&& attribute : mAttributes) {
+			if (attribute.location >= 16) {
+				mVertexLayout = 0;
+				break;
+			}
+
+			mVertexLayout |= (uint64_t)(enum_cast(attribute.builtInAttribute) + 1) << (attribute.location * 4);
+		}
+
+		//attach the built-in blocks to their binding points, uniform buffers need a GLES3-class context
+		if (GLAD_GL_ES_VERSION_3_0) {
+			static const char* blockNames[] = {
+				"VIEW_UNIFORMS",
+				"DRAW_UNIFORMS"
+			};
+
+			for (auto i : range(enum_cast(UniformBlock::_Count))) {
+				auto index = glGetUniformBlockIndex(mGLProgram, blockNames[i]);
+				if (index != GL_INVALID_INDEX) {
+					glUniformBlockBinding(mGLProgram, index, i);
+					mUniformBlocks[i] = true;
+				}
+			}
+		}
 	}
 
 	return loaded;
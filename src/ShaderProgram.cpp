@@ -107,21 +107,39 @@ void ShaderProgram::onUnload(bool soft /* = false */) {
 	loaded = false;
 }
 
-bool ShaderProgram::onLoad() {
-	DEBUG_ASSERT(not isLoaded(), "Cannot reload an already loaded program");
+bool ShaderProgram::_readFile() {
+	auto file = Platform::singleton().getFile(filePath);
 
-	if (getFilePath().not_empty()) { //try loading from file
-		auto file = Platform::singleton().getFile(filePath);
+	if (not file->open(Stream::Access::Read)) {
+		return false;
+	}
+
+	auto size = file->getSize();
+	mContentString.resize((size_t)size);
+
+	file->read((uint8_t*)mContentString.data(), size);
+	file->close(); //close as soon as possible to release the file if there's an error
+
+	return true;
+}
 
-		if (file->open(Stream::Access::Read)) {
-			auto size = file->getSize();
-			mContentString.resize((size_t)size);
+void ShaderProgram::onPrepare() {
+	DEBUG_ASSERT(not isLoaded(), "Cannot reload an already loaded program");
+
+	if (getFilePath().not_empty()) {
+		prepared = _readFile();
+	}
+}
 
-			file->read((uint8_t*)mContentString.data(), size);
-			file->close(); //close as soon as possible to release the file if there's an error
+bool ShaderProgram::onLoad() {
+	DEBUG_ASSERT(not isLoaded(), "Cannot reload an already loaded program");
 
+	if (getFilePath().not_empty()) { //try loading from file
+		if (prepared or _readFile()) {
 			loaded = _load(); //load from the temp buffer
 		}
+
+		prepared = false;
 	}
 	else { //load from the in-memory string
 		loaded = _load();
@@ -104,6 +104,12 @@ SoundBuffer::~SoundBuffer() {
 
 }
 
+void SoundBuffer::onPrepare() {
+	DEBUG_ASSERT( isLoaded() == false, "The SoundBuffer is already loaded" );
+
+	prepared = _openOggFile();
+}
+
 bool SoundBuffer::onLoad() {
 	DEBUG_ASSERT( isLoaded() == false, "The SoundBuffer is already loaded" );
 
@@ -111,7 +117,13 @@ bool SoundBuffer::onLoad() {
 
 	DEBUG_ASSERT( ext == "ogg", "Sound file extension is not ogg" );
 
-	_loadOggFromFile();
+	if (prepared or _openOggFile()) {
+		if (not isStreaming()) {
+			mChunks[0]->get();    //get() it to avoid that it is unloaded by the sources, and load synchronously
+		}
+	}
+
+	prepared = false;
 
 	return CHECK_AL_ERROR;
 }
@@ -236,7 +248,7 @@ void SoundBuffer::Chunk::onUnload(bool soft /* = false */) {
 	}
 }
 
-bool SoundBuffer::_loadOgg(Stream& source) {
+bool SoundBuffer::_readOggHeaders(Stream& source) {
 	if (not source.open(Stream::Access::Read)) {
 		DEBUG_ASSERT(source.isReadable(), "The data source for the Ogg stream could not be open, or isn't readable" );
 
@@ -295,20 +307,14 @@ bool SoundBuffer::_loadOgg(Stream& source) {
 
 	ov_clear(&file);
 
-	if (not isStreaming()) {
-		mChunks[0]->get();    //get() it to avoid that it is unloaded by the sources, and load synchronously
-	}
-
-	return true;
+	return not mChunks.empty();
 }
 
-bool SoundBuffer::_loadOggFromFile() {
+bool SoundBuffer::_openOggFile() {
 	mFile = Platform::singleton().getFile(filePath);
 	mSource = *mFile;
 
-	_loadOgg(mSource.unwrap());
-
-	return isLoaded();
+	return _readOggHeaders(mSource.unwrap());
 }
 
 SoundBuffer::Chunk& SoundBuffer::getChunk(int n, bool loadAsync /*= false */) {
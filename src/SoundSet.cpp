@@ -30,6 +30,14 @@ void SoundSet::addBuffer(std::unique_ptr<SoundBuffer> b) {
 	buffers.emplace_back(std::move(b));
 }
 
+void SoundSet::onPrepare() {
+	for (auto&& b : buffers) {
+		if (not b->isLoaded()) {
+			b->onPrepare();
+		}
+	}
+}
+
 bool SoundSet::onLoad() {
 	for (auto&& b : buffers) {
 		if (not b->isLoaded()) {
@@ -0,0 +1,5 @@
+#include "SpatialIndex.h"
+
+using namespace Dojo;
+
+const SpatialIndex::Proxy SpatialIndex::InvalidProxy = UINT32_MAX;
@@ -0,0 +1,142 @@
+#include "SpriteBatcher.h"
+
+#include "Renderable.h"
+#include "Texture.h"
+#include "Mesh.h"
+#include "range.h"
+
+using namespace Dojo;
+
+void SpriteBatcher::BatchState::setup(const Renderable& first, Mesh& batchMesh) {
+	auto& tex = first.getTexture().unwrap();
+
+	//bind the atlas directly, its tiles all share its GL texture
+	setTexture(tex.getParentAtlas().unwrap_or(tex));
+	setShader(first.getShader().unwrap());
+	setMesh(batchMesh);
+
+	blending = first.getBlending();
+	cullMode = first.cullMode;
+	color = first.color;
+
+	//the vertices are already in world space, only the depth is left to the transform
+	mTransform = glm::translate(Matrix(1), Vector(0, 0, first.getTransform()[3][2]));
+}
+
+SpriteBatcher::SpriteBatcher() :
+	mMesh(make_unique<Mesh>()) {
+	//same format as the optimal billboard, so every shader that can draw a sprite can draw a batch
+	mMesh->setVertexFields({ VertexField::Position2D, VertexField::UV0 });
+	mMesh->setIndexByteSize(4);
+	mMesh->setTriangleMode(PrimitiveMode::TriangleList);
+	mMesh->setStreaming(true);
+}
+
+SpriteBatcher::~SpriteBatcher() {
+	if (mMesh->isLoaded()) {
+		mMesh->onUnload();
+	}
+}
+
+bool SpriteBatcher::isSprite(const Renderable& r) {
+	auto tex = r.getTexture().to_raw_ptr();
+	auto mesh = r.getMesh().to_raw_ptr();
+	if (not tex or not mesh or r.getTexture(1).is_some()) {
+		return false;
+	}
+
+	return tex->isOptimalBillboard(*mesh);
+}
+
+bool SpriteBatcher::canBatchTogether(const Renderable& a, const Renderable& b) {
+	if (not isSprite(b)) {
+		return false;
+	}
+
+	auto& texA = a.getTexture().unwrap();
+	auto& texB = b.getTexture().unwrap();
+	auto& blendA = a.getBlending();
+	auto& blendB = b.getBlending();
+
+	return
+		&texA.getParentAtlas().unwrap_or(texA) == &texB.getParentAtlas().unwrap_or(texB) and
+		a.getShader().to_raw_ptr() == b.getShader().to_raw_ptr() and
+		a.color == b.color and
+		a.isBlendingEnabled() == b.isBlendingEnabled() and
+		blendA.src == blendB.src and
+		blendA.dest == blendB.dest and
+		blendA.func == blendB.func and
+		a.cullMode == b.cullMode and
+		a.getTransform()[3][2] == b.getTransform()[3][2];
+}
+
+//a sprite is drawn as two triangles
+static const uint32_t VERTICES_PER_SPRITE = 6;
+
+void SpriteBatcher::begin(const Renderable& first, uint32_t spriteCount) {
+	DEBUG_ASSERT(isSprite(first), "This Renderable can't be batched");
+	DEBUG_ASSERT(spriteCount > 0, "Beginning an empty batch");
+
+	auto vertexCount = spriteCount * VERTICES_PER_SPRITE;
+
+	mNextVertex = (Vertex*)mMesh->beginStream((Mesh::IndexType)vertexCount);
+	mStreamed = mNextVertex != nullptr;
+	if (not mStreamed) {
+		mVertices.resize(vertexCount);
+		mNextVertex = mVertices.data();
+	}
+
+	mEndVertex = mNextVertex + vertexCount;
+	mState.setup(first, *mMesh);
+}
+
+void SpriteBatcher::append(const Renderable& sprite) {
+	auto& tex = sprite.getTexture().unwrap();
+	auto& transform = sprite.getTransform();
+
+	auto& uvMin = tex.getUVOffset();
+	auto uvMax = uvMin + tex.getUVSize();
+
+	//the same corners as Texture::getOptimalBillboard, with v flipped the same way
+	static const Vector corners[] = {
+		{ -0.5f, -0.5f },
+		{ 0.5f, -0.5f },
+		{ -0.5f, 0.5f },
+		{ 0.5f, 0.5f }
+	};
+
+	const uint32_t uvs[] = {
+		glm::packHalf2x16({ uvMin.x, uvMax.y }),
+		glm::packHalf2x16({ uvMax.x, uvMax.y }),
+		glm::packHalf2x16({ uvMin.x, uvMin.y }),
+		glm::packHalf2x16({ uvMax.x, uvMin.y })
+	};
+
+	Vertex quad[4];
+	for (auto i : range(4)) {
+		auto world = transform * glm::vec4(corners[i].x, corners[i].y, 0.f, 1.f);
+		quad[i] = { world.x, world.y, uvs[i] };
+	}
+
+	DEBUG_ASSERT(mNextVertex + VERTICES_PER_SPRITE <= mEndVertex, "The batch holds more sprites than begin() was told");
+
+	//the strip 0 1 2 3 as a list of two triangles
+	for (auto i : { 0, 1, 2, 2, 1, 3 }) {
+		*mNextVertex++ = quad[i];
+	}
+}
+
+const RenderState& SpriteBatcher::end() {
+	DEBUG_ASSERT(mNextVertex == mEndVertex, "The batch holds fewer sprites than begin() was told");
+
+	if (mStreamed) {
+		mMesh->endStream();
+	}
+	else {
+		mMesh->begin((Mesh::IndexType)mVertices.size());
+		mMesh->appendRawVertexData(mVertices.data(), (Mesh::IndexType)mVertices.size());
+		mMesh->end();
+	}
+
+	return mState;
+}
@@ -0,0 +1,127 @@
+#include "StreamingBuffer.h"
+
+#include <glad/glad.h>
+
+using namespace Dojo;
+
+StreamingBuffer::StreamingBuffer(uint32_t target, uint32_t size, uint32_t alignment) :
+	mTarget(target),
+	mSize(size),
+	mAlignment(std::max(alignment, 1u)) {
+	DEBUG_ASSERT(size > 0, "Invalid size");
+
+	glGenBuffers(1, &mGLHandle);
+	glBindBuffer(mTarget, mGLHandle);
+
+#ifdef GL_EXT_buffer_storage
+	if (GLAD_GL_EXT_buffer_storage) {
+		//map the whole ring once and keep it mapped, coherent so that no flushes are needed
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+		glBufferStorageEXT(mTarget, mSize, nullptr, flags);
+		mPersistentData = (uint8_t*)glMapBufferRange(mTarget, 0, mSize, flags);
+	}
+#endif
+
+	if (not mPersistentData) {
+		glBufferData(mTarget, mSize, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+StreamingBuffer::~StreamingBuffer() {
+	for (auto&& fence : mFences) {
+		glDeleteSync((GLsync)fence.sync);
+	}
+
+	if (mPersistentData) {
+		glBindBuffer(mTarget, mGLHandle);
+		glUnmapBuffer(mTarget);
+	}
+
+	glDeleteBuffers(1, &mGLHandle);
+}
+
+void StreamingBuffer::_retireSignaledFences() {
+	while (mFences.size() and glClientWaitSync((GLsync)mFences.front().sync, 0, 0) != GL_TIMEOUT_EXPIRED) {
+		glDeleteSync((GLsync)mFences.front().sync);
+		mUsed -= mFences.front().bytes;
+		mFences.pop_front();
+	}
+}
+
+void StreamingBuffer::_waitOldestFence() {
+	//the current frame alone filled the ring, fence it to wait for its draws
+	if (mFences.empty()) {
+		fence();
+	}
+
+	auto& oldest = mFences.front();
+	++mFenceWaitCount;
+
+	GLenum result;
+	do {
+		result = glClientWaitSync((GLsync)oldest.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		DEBUG_ASSERT(result != GL_WAIT_FAILED, "Waiting on a streaming buffer fence failed");
+	} while (result == GL_TIMEOUT_EXPIRED);
+
+	glDeleteSync((GLsync)oldest.sync);
+	mUsed -= oldest.bytes;
+	mFences.pop_front();
+}
+
+StreamingBuffer::Allocation StreamingBuffer::map(uint32_t size) {
+	DEBUG_ASSERT(not mMapped, "The previous allocation wasn't unmapped");
+	DEBUG_ASSERT(size > 0 and size <= mSize, "Invalid allocation size");
+
+	uint32_t start = ((mHead + mAlignment - 1) / mAlignment) * mAlignment;
+	if (start + size > mSize) {
+		//the tail end of the ring is wasted, start over
+		start = 0;
+		++mWrapCount;
+	}
+
+	//the padding or the wasted tail are in use too, until this frame is retired
+	uint32_t consumed = (start >= mHead ? start - mHead : mSize - mHead) + size;
+
+	_retireSignaledFences();
+	while (mUsed + consumed > mSize) {
+		_waitOldestFence();
+	}
+
+	mHead = start + size;
+	mUsed += consumed;
+	mUnfenced += consumed;
+
+	glBindBuffer(mTarget, mGLHandle);
+
+	Allocation allocation;
+	allocation.offset = start;
+
+	if (mPersistentData) {
+		allocation.data = mPersistentData + start;
+	}
+	else {
+		//unsynchronized is safe as the fences already guarantee that the GPU is done with the range
+		allocation.data = glMapBufferRange(mTarget, start, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		DEBUG_ASSERT(allocation.data, "Cannot map the streaming buffer");
+		mMapped = true;
+	}
+
+	return allocation;
+}
+
+void StreamingBuffer::unmap() {
+	if (mMapped) {
+		glBindBuffer(mTarget, mGLHandle);
+		glUnmapBuffer(mTarget);
+		mMapped = false;
+	}
+}
+
+void StreamingBuffer::fence() {
+	if (mUnfenced > 0) {
+		mFences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mUnfenced });
+		mUnfenced = 0;
+	}
+
+	++mFrame;
+}
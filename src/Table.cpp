@@ -28,6 +28,15 @@ Table Table::loadFromFile(utf::string_view path) {
 	return dest;
 }
 
+void Table::onPrepare() {
+	DEBUG_ASSERT(not isLoaded(), "The Table is already loaded" );
+
+	if (isReloadable()) {
+		self = Platform::singleton().load(filePath);
+		prepared = true;
+	}
+}
+
 bool Table::onLoad() {
 	//loads itself from file
 	DEBUG_ASSERT(not isLoaded(), "The Table is already loaded" );
@@ -36,7 +45,11 @@ bool Table::onLoad() {
 		return false;
 	}
 
-	self = Platform::singleton().load(filePath);
+	if (not prepared) {
+		self = Platform::singleton().load(filePath);
+	}
+
+	prepared = false;
 
 	return (loaded = not isEmpty());
 }
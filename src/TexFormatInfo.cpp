@@ -2,6 +2,32 @@
 
 #include <glad/glad.h>
 
+//the compressed formats that come from extensions might not be in the GL headers
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+#ifndef GL_COMPRESSED_RED_RGTC1_EXT
+	#define GL_COMPRESSED_RED_RGTC1_EXT 0x8DBB
+	#define GL_COMPRESSED_RED_GREEN_RGTC2_EXT 0x8DBD
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM_EXT
+	#define GL_COMPRESSED_RGBA_BPTC_UNORM_EXT 0x8E8C
+	#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_EXT 0x8E8D
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+	#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+#endif
+
 namespace Dojo {
 	const Dojo::TexFormatInfo& TexFormatInfo::getFor(PixelFormat format) {
 		static const TexFormatInfo GLFormat[] = {
@@ -15,11 +41,80 @@ namespace Dojo {
 			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_RED, GL_UNSIGNED_BYTE, false },
 			{ 2, GL_RG8, GL_UNSIGNED_BYTE,					2, GL_RG, GL_UNSIGNED_BYTE, false },
 			{ 1, GL_R8, GL_UNSIGNED_BYTE,					1, GL_ALPHA, GL_UNSIGNED_BYTE, true },
+
+			{ 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0,			0, 0, 0, true,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0,		0, 0, 0, true,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0,			0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0,		0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_RED_RGTC1_EXT, 0,				0, 0, 0, false,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_RED_GREEN_RGTC2_EXT, 0,			0, 0, 0, false,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_BPTC_UNORM_EXT, 0,			0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_EXT, 0,	0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGB8_ETC2, 0,					0, 0, 0, false,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_SRGB8_ETC2, 0,					0, 0, 0, false,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_RGBA8_ETC2_EAC, 0,				0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0,		0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_R11_EAC, 0,						0, 0, 0, false,		4, 4, 8 },
+			{ 0, GL_COMPRESSED_RG11_EAC, 0,						0, 0, 0, false,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 0,			0, 0, 0, true,		4, 4, 16 },
+			{ 0, GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 0,	0, 0, 0, true,		4, 4, 16 },
+
 			{ 0, 0, 0, 0, 0 },
 		};
 
 		return GLFormat[enum_cast(format)];
 	}
 
-}
+	bool TexFormatInfo::isSupported(PixelFormat format) {
+		switch (format) {
+		case PixelFormat::BC1_RGBA:
+		case PixelFormat::BC3_RGBA:
+#ifdef GL_EXT_texture_compression_s3tc
+			return GLAD_GL_EXT_texture_compression_s3tc != 0;
+#else
+			return false;
+#endif
+		case PixelFormat::BC1_RGBA_SRGB:
+		case PixelFormat::BC3_RGBA_SRGB:
+#ifdef GL_EXT_texture_compression_s3tc_srgb
+			return GLAD_GL_EXT_texture_compression_s3tc_srgb != 0;
+#else
+			return false;
+#endif
+		case PixelFormat::BC4_R:
+		case PixelFormat::BC5_RG:
+#ifdef GL_EXT_texture_compression_rgtc
+			return GLAD_GL_EXT_texture_compression_rgtc != 0;
+#else
+			return false;
+#endif
+		case PixelFormat::BC7_RGBA:
+		case PixelFormat::BC7_RGBA_SRGB:
+#ifdef GL_EXT_texture_compression_bptc
+			return GLAD_GL_EXT_texture_compression_bptc != 0;
+#else
+			return false;
+#endif
+		case PixelFormat::ETC2_RGB:
+		case PixelFormat::ETC2_RGB_SRGB:
+		case PixelFormat::ETC2_RGBA:
+		case PixelFormat::ETC2_RGBA_SRGB:
+		case PixelFormat::EAC_R:
+		case PixelFormat::EAC_RG:
+			//part of core GLES 3.0
+			return GLAD_GL_ES_VERSION_3_0 != 0;
+		case PixelFormat::ASTC_4x4_RGBA:
+		case PixelFormat::ASTC_4x4_RGBA_SRGB:
+#ifdef GL_KHR_texture_compression_astc_ldr
+			return GLAD_GL_KHR_texture_compression_astc_ldr != 0;
+#else
+			return false;
+#endif
+		case PixelFormat::Unknown:
+			return false;
+		default:
+			return true;
+		}
+	}
 
+}
@@ -4,11 +4,109 @@
 #include "ResourceGroup.h"
 #include "Mesh.h"
 #include "TexFormatInfo.h"
+#include "Renderer.h"
+#include "TextureStreamer.h"
+#include "TextureContainer.h"
+#include "WorkerPool.h"
+#include "range.h"
 
 #include <glad/glad.h>
 
 using namespace Dojo;
 
+//how many rows of a mip level a single background task filters
+static const uint32_t MIP_ROWS_PER_TASK = 32;
+
+//no RenderState uses this unit, so creating and filling textures on it leaves the bound ones alone
+static const uint32_t SETUP_TEXTURE_UNIT = DOJO_MAX_TEXTURES;
+
+bool Texture::gBindingsDirty = true;
+
+void _bindForSetup(uint32_t handle) {
+	glActiveTexture(GL_TEXTURE0 + SETUP_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, handle);
+}
+
+uint32_t _getLevelSide(uint32_t side, uint8_t level) {
+	return std::max(1u, side >> level);
+}
+
+uint8_t _getMipCount(uint32_t width, uint32_t height) {
+	uint8_t count = 1;
+	while ((std::max(width, height) >> count) > 0) {
+		++count;
+	}
+	return count;
+}
+
+//box-filters a RGBA8 level down to the next one, with its rows split over the background workers
+//a worker can't spread work on its own pool, so it filters the whole level by itself
+void _downsampleRGBA8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, std::vector<uint8_t>& dest, bool parallel = true) {
+	auto width = _getLevelSide(srcWidth, 1), height = _getLevelSide(srcHeight, 1);
+	dest.resize(width * height * 4);
+
+	auto out = dest.data();
+	auto taskCount = (height + MIP_ROWS_PER_TASK - 1) / MIP_ROWS_PER_TASK;
+
+	auto filterRows = [=](uint32_t task) {
+		auto end = std::min(height, (task + 1) * MIP_ROWS_PER_TASK);
+
+		for (auto y = task * MIP_ROWS_PER_TASK; y < end; ++y) {
+			auto y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+			for (uint32_t x = 0; x < width; ++x) {
+				auto x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+				auto a = src + (y0 * srcWidth + x0) * 4, b = src + (y0 * srcWidth + x1) * 4;
+				auto c = src + (y1 * srcWidth + x0) * 4, d = src + (y1 * srcWidth + x1) * 4;
+				auto pixel = out + (y * width + x) * 4;
+
+				for (auto i : range(4)) {
+					pixel[i] = (uint8_t)((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+				}
+			}
+		}
+	};
+
+	if (parallel) {
+		Platform::singleton().getBackgroundPool().parallelFor(taskCount, filterRows);
+	}
+	else {
+		for (uint32_t task = 0; task < taskCount; ++task) {
+			filterRows(task);
+		}
+	}
+}
+
+bool _hasTransparentPixels(const uint8_t* imageData, uint32_t width, uint32_t height) {
+	auto end = imageData + (width * height * 4);
+	for (auto alpha = imageData + 3; alpha < end; alpha += 4) {
+		if (*alpha < 250) {
+			return true;
+		}
+	}
+	return false;
+}
+
+struct Texture::AsyncLoad {
+	utf::string path;
+	bool mipmaps, NPOTEnabled;
+
+	//set on the main thread when the texture doesn't want the result anymore
+	bool cancelled = false;
+
+	//written by the decode task
+	PixelFormat format = PixelFormat::Unknown;
+	uint32_t width = 0, height = 0;
+	bool transparent = false;
+	std::vector<std::vector<uint8_t>> levels;
+
+	//the pixel unpack buffer the levels are copied into, and where each of them starts
+	uint32_t PBO = 0;
+	uint8_t* mappedPBO = nullptr;
+	std::vector<size_t> offsets;
+};
+
 Texture::Texture(optional_ref<ResourceGroup> creator) :
 	Resource(creator),
 	internalWidth(0),
@@ -26,59 +124,167 @@ Texture::Texture(optional_ref<ResourceGroup> creator, utf::string_view path) :
 Texture::~Texture() {
 	OBB.reset();
 
-	if (loaded) {
+	if (loaded or mPending) {
 		onUnload();
 	}
 }
 
 void Texture::bind(uint32_t index) {
+	if (mPending) {
+		Platform::singleton().getRenderer().getPlaceholderTexture().bind(index);
+		return;
+	}
+
+	//tiles bind their atlas, whose GL texture is replaced when its mips are streamed
+	auto handle = parentAtlas.is_some() ? parentAtlas.unwrap().glhandle : glhandle;
+
 	//create the gl texture if still not created!
-	DEBUG_ASSERT(glhandle, "This texture wasn't created yet");
+	DEBUG_ASSERT(handle, "This texture wasn't created yet");
 
 	glActiveTexture(GL_TEXTURE0 + index);
-	glBindTexture(GL_TEXTURE_2D, glhandle);
+	glBindTexture(GL_TEXTURE_2D, handle);
 }
 
 void Texture::enableAnisotropicFiltering(float level) {
+	mAnisotropy = level;
+
 	bind(0);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, level);
 }
 
 void Texture::disableAnisotropicFiltering() {
+	mAnisotropy = 0;
+
 	bind(0);
 	glTexParameterf(GL_TEXTURE_2D, GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, 0);
 }
 
 void Texture::enableBilinearFiltering() {
-	bind(0);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	mBilinear = true;
 
+	if (glhandle) {
+		bind(0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
 }
 
 void Texture::disableBilinearFiltering() {
-	bind(0);
+	mBilinear = false;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	if (glhandle) {
+		bind(0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
 }
 
 void Texture::enableTiling() {
-	bind(0);
+	mTiling = true;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	if (glhandle) {
+		bind(0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
 }
 
 void Texture::disableTiling() {
-	bind(0);
+	mTiling = false;
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if (glhandle) {
+		bind(0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+}
+
+void Texture::_applyParameters() {
+	bool mipmapped = mLevelCount - mResidentLevel > 1;
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mBilinear ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, mTiling ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, mTiling ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+
+	if (mAnisotropy > 0) {
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, mAnisotropy);
+	}
+}
+
+size_t Texture::getVRAMSize(uint8_t firstLevel) const {
+	auto& formatInfo = TexFormatInfo::getFor(internalFormat);
+
+	size_t size = 0;
+	for (uint8_t level = firstLevel; level < mLevelCount; ++level) {
+		size += formatInfo.getImageSize(_getLevelSide(internalWidth, level), _getLevelSide(internalHeight, level));
+	}
+	return size;
+}
+
+void Texture::_allocateLevels(uint8_t firstLevel) {
+	DEBUG_ASSERT(firstLevel < mLevelCount, "Invalid mip level");
+
+	//immutable storage can't be resized, so a new texture object replaces the old one
+	if (glhandle) {
+		glDeleteTextures(1, &glhandle);
+	}
+
+	glGenTextures(1, &glhandle);
+	_bindForSetup(glhandle);
+
+	//the old handle might still be bound on the units that draw this texture
+	gBindingsDirty = true;
+
+	mResidentLevel = firstLevel;
+
+	glTexStorage2D(
+		GL_TEXTURE_2D,
+		mLevelCount - firstLevel,
+		TexFormatInfo::getFor(internalFormat).internalFormat,
+		_getLevelSide(internalWidth, firstLevel),
+		_getLevelSide(internalHeight, firstLevel)
+	);
+
+	_applyParameters();
+}
+
+void Texture::_uploadLevel(uint8_t level, const uint8_t* data) {
+	DEBUG_ASSERT(level >= mResidentLevel and level < mLevelCount, "This mip level isn't allocated");
+
+	auto& formatDesc = TexFormatInfo::getFor(internalFormat);
+	auto levelWidth = _getLevelSide(width, level), levelHeight = _getLevelSide(height, level);
+
+	if (formatDesc.isCompressed()) {
+		glCompressedTexSubImage2D(
+			GL_TEXTURE_2D,
+			level - mResidentLevel,
+			0,
+			0,
+			levelWidth,
+			levelHeight,
+			formatDesc.internalFormat,
+			(GLsizei)formatDesc.getImageSize(levelWidth, levelHeight),
+			data
+		);
+	}
+	else {
+		glTexSubImage2D(
+			GL_TEXTURE_2D,
+			level - mResidentLevel,
+			0,
+			0,
+			levelWidth,
+			levelHeight,
+			formatDesc.sourceFormat,
+			formatDesc.sourceElementType,
+			data
+		);
+	}
 }
 
 void Dojo::Texture::_addAsAttachment(uint32_t index, uint32_t width, uint32_t height, uint8_t miplevel) {
-	DEBUG_ASSERT(width == getWidth() and height == getHeight(), "Cannot add texture as attachment");
-	DEBUG_ASSERT(miplevel == 0, "Mipmaps aren't supported anymore :(");
+	DEBUG_ASSERT(not isStreamed(), "Streamed textures can't be rendered to");
+	DEBUG_ASSERT(miplevel < mLevelCount, "This mip level isn't allocated");
+	DEBUG_ASSERT(width == _getLevelSide(getWidth(), miplevel) and height == _getLevelSide(getHeight(), miplevel), "Cannot add texture as attachment");
 
 	bind(0);
 
@@ -93,7 +299,7 @@ void Dojo::Texture::_addAsAttachment(uint32_t index, uint32_t width, uint32_t he
 
 }
 
-bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID) {
+bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID, uint8_t levelCount) {
 	width = w;
 	height = h;
 
@@ -105,15 +311,6 @@ bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID)
 
 	DEBUG_ASSERT(formatInfo.isGPUFormat(), "This format can't be loaded on the GPU!");
 
-	if (not glhandle) {
-		glGenTextures(1, &glhandle);
-	}
-	glBindTexture(GL_TEXTURE_2D, glhandle);
-
-	//TODO add back manually generated mipmaps
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-
 	uint32_t destWidth, destHeight;
 
 	//if the platforms supports NPOT, or the dimensions are already POT, direct copy
@@ -126,24 +323,23 @@ bool Dojo::Texture::_createStorage(uint32_t w, uint32_t h, PixelFormat formatID)
 		destHeight = glm::ceilPowerOfTwo(height);
 	}
 
-	//check if the texture has to be recreated (changed dimensions)
-	if (destWidth != internalWidth or destHeight != internalHeight or oldFormat.internalFormat != formatInfo.internalFormat) {
+	//check if the texture has to be recreated (changed dimensions or levels)
+	if (not glhandle or destWidth != internalWidth or destHeight != internalHeight or oldFormat.internalFormat != formatInfo.internalFormat or levelCount != mLevelCount) {
 		internalWidth = destWidth;
 		internalHeight = destHeight;
 		internalFormat = formatID;
+		mLevelCount = levelCount;
 
 		auto internalSize = internalWidth * internalHeight * formatInfo.sourcePixelSize;
 		DEBUG_ASSERT(internalSize % 4 == 0, "OpenGL implementations choke on non-4-aligned buffers");
 
-		glTexStorage2D(
-			GL_TEXTURE_2D,
-			1, //TODO multiple levels?
-			formatInfo.internalFormat,
-			internalWidth,
-			internalHeight
-		);
-
+		_allocateLevels(0);
+	}
+	else {
+		_bindForSetup(glhandle);
 
+		//a pending texture was bound as the placeholder until now
+		gBindingsDirty = true;
 	}
 
 	UVSize.x = (float)width / (float)internalWidth;
@@ -187,7 +383,7 @@ const uint8_t* convertToGPUFormat(const uint8_t* imageData, uint32_t width, uint
 	}
 }
 
-bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat format) {
+bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t height, PixelFormat format, bool mipmaps) {
 	DEBUG_ASSERT(imageData, "null image data");
 	DEBUG_ASSERT(width > 0 and height > 0, "Invalid dimensions");
 
@@ -195,31 +391,66 @@ bool Texture::loadFromMemory(const uint8_t* imageData, uint32_t width, uint32_t
 	std::vector<uint8_t> conversionBuffer;
 	imageData = convertToGPUFormat(imageData, width, height, format, conversionBuffer);
 
-	_createStorage(width, height, format);
+	//padded textures would filter the padding into their mips
+	bool padded = not (glm::isPowerOfTwo(width) and glm::isPowerOfTwo(height)) and not Platform::singleton().isNPOTEnabled();
+	uint8_t levelCount = (mipmaps and not padded) ? _getMipCount(width, height) : 1;
+
+	_createStorage(width, height, format, levelCount);
 
 	auto& formatDesc = TexFormatInfo::getFor(format);
 
-	mTransparency = false;
-	if (formatDesc.hasAlpha) {
-		auto end = imageData + (width * height * 4);
-		for (auto alpha = imageData + 3; alpha < end; alpha += 4) {
-			if (*alpha < 250) {
-				mTransparency = true;
-				break;
-			}
-		}
+	mTransparency = formatDesc.hasAlpha and _hasTransparentPixels(imageData, width, height);
+
+	if (levelCount == 1) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, formatDesc.sourceFormat, formatDesc.sourceElementType, imageData);
+		return loaded = true;
+	}
+
+	//build the whole chain, each level from the previous one
+	mMipData.resize(levelCount);
+	auto level = imageData;
+	for (uint8_t i = 1; i < levelCount; ++i) {
+		_downsampleRGBA8(level, _getLevelSide(width, i - 1), _getLevelSide(height, i - 1), mMipData[i]);
+		level = mMipData[i].data();
 	}
 
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, formatDesc.sourceFormat, formatDesc.sourceElementType, imageData);
+	if (auto streamer = Platform::singleton().getRenderer().getTextureStreamer().to_ref()) {
+		//the streamer uploads the low mips now and the others when something needs them
+		mMipData[0].assign(imageData, imageData + width * height * 4);
+		loaded = true;
+		streamer.get().add(self);
+	}
+	else {
+		_uploadLevel(0, imageData);
+		for (uint8_t i = 1; i < levelCount; ++i) {
+			_uploadLevel(i, mMipData[i].data());
+		}
+		mMipData.clear();
+	}
 
 	return loaded = true;
 }
 
+void Texture::_applyCreatorSampling() {
+	if (creator.is_some() and creator.unwrap().disableBilinear) {
+		disableBilinearFiltering();
+	}
+	else {
+		enableBilinearFiltering();
+	}
+
+	enableTiling();
+}
+
 bool Texture::loadFromFile(utf::string_view path) {
 	DEBUG_ASSERT(not isLoaded(), "The Texture is already loaded");
 
-	if (not glhandle) {
-		glGenTextures(1, &glhandle);
+	_applyCreatorSampling();
+
+	//prefer a compressed variant, it's already mipped and smaller in VRAM
+	TextureContainer container;
+	if (container.loadVariantOf(path)) {
+		return loadFromContainer(container);
 	}
 
 	int pixelSize;
@@ -228,23 +459,253 @@ bool Texture::loadFromFile(utf::string_view path) {
 
 	DEBUG_ASSERT_INFO(format != PixelFormat::Unknown, "Cannot load an image file", "path = " + path);
 
-	if (creator.is_some() and creator.unwrap().disableBilinear) {
-		disableBilinearFiltering();
+	bool mipmaps = creator.is_none() or not creator.unwrap().disableMipmaps;
+	loadFromMemory(imageData.data(), width, height, format, mipmaps);
+
+	return loaded;
+}
+
+bool Texture::loadFromContainer(const TextureContainer& container) {
+	auto format = container.getFormat();
+	auto levelCount = container.getLevelCount();
+
+	DEBUG_ASSERT(TexFormatInfo::isSupported(format), "This format isn't supported by the GPU");
+	DEBUG_ASSERT(levelCount > 0, "The container is empty");
+
+	auto w = container.getWidth(), h = container.getHeight();
+	DEBUG_ASSERT((glm::isPowerOfTwo(w) and glm::isPowerOfTwo(h)) or Platform::singleton().isNPOTEnabled(), "Compressed textures can't be padded to a power of 2");
+
+	_createStorage(w, h, format, levelCount);
+
+	//the blocks can't be scanned cheaply, so trust the format
+	mTransparency = TexFormatInfo::getFor(format).hasAlpha;
+
+	auto streamer = Platform::singleton().getRenderer().getTextureStreamer().to_ref();
+	if (streamer and levelCount > 1) {
+		mMipData.resize(levelCount);
+		for (uint8_t i = 0; i < levelCount; ++i) {
+			auto& level = container.getLevel(i);
+			mMipData[i].assign(level.data, level.data + level.size);
+		}
+
+		loaded = true;
+		streamer.get().add(self);
 	}
 	else {
-		enableBilinearFiltering();
+		for (uint8_t i = 0; i < levelCount; ++i) {
+			_uploadLevel(i, container.getLevel(i).data);
+		}
 	}
 
-	enableTiling();
+	return loaded = true;
+}
 
-	loadFromMemory(imageData.data(), width, height, format);
+bool Texture::loadAsync() {
+	DEBUG_ASSERT(isReloadable(), "Only textures with a file path can be loaded in the background");
+	DEBUG_ASSERT(not isLoaded() and not isPending(), "The Texture is already loaded");
 
-	return loaded;
+	_applyCreatorSampling();
+
+	auto load = make_shared<AsyncLoad>();
+	load->path = filePath;
+	load->mipmaps = creator.is_none() or not creator.unwrap().disableMipmaps;
+	load->NPOTEnabled = Platform::singleton().isNPOTEnabled();
+
+	mAsyncLoad = load;
+	mPending = true;
+
+	Platform::singleton().getBackgroundPool().queue([load] {
+		_decode(*load);
+	},
+	[this, load] { //then, on the main thread
+		if (not load->cancelled) {
+			_onDecoded(load);
+		}
+	});
+
+	return false;
+}
+
+void Texture::_decode(AsyncLoad& load) {
+	//same as loadFromFile, a supported compressed variant comes already mipped
+	TextureContainer container;
+	if (container.loadVariantOf(load.path)) {
+		load.format = container.getFormat();
+		load.width = container.getWidth();
+		load.height = container.getHeight();
+		load.transparent = TexFormatInfo::getFor(load.format).hasAlpha;
+
+		load.levels.resize(container.getLevelCount());
+		for (auto i : range(container.getLevelCount())) {
+			auto& level = container.getLevel((uint8_t)i);
+			load.levels[i].assign(level.data, level.data + level.size);
+		}
+		return;
+	}
+
+	int pixelSize;
+	std::vector<uint8_t> imageData;
+	auto format = Platform::singleton().loadImageFile(imageData, load.path, load.width, load.height, pixelSize);
+	if (format == PixelFormat::Unknown) {
+		return;
+	}
+
+	std::vector<uint8_t> conversionBuffer;
+	auto converted = convertToGPUFormat(imageData.data(), load.width, load.height, format, conversionBuffer);
+
+	load.format = format;
+	load.transparent = TexFormatInfo::getFor(format).hasAlpha and _hasTransparentPixels(converted, load.width, load.height);
+
+	bool padded = not (glm::isPowerOfTwo(load.width) and glm::isPowerOfTwo(load.height)) and not load.NPOTEnabled;
+	uint8_t levelCount = (load.mipmaps and not padded) ? _getMipCount(load.width, load.height) : 1;
+
+	load.levels.resize(levelCount);
+	load.levels[0] = converted == imageData.data() ? std::move(imageData) : std::move(conversionBuffer);
+
+	for (uint8_t i = 1; i < levelCount; ++i) {
+		_downsampleRGBA8(load.levels[i - 1].data(), _getLevelSide(load.width, i - 1), _getLevelSide(load.height, i - 1), load.levels[i], false);
+	}
+}
+
+bool Texture::_loadDecoded(AsyncLoad& load) {
+	if (load.format == PixelFormat::Unknown) {
+		DEBUG_MESSAGE("Cannot load an image file: " + load.path);
+		return false;
+	}
+
+	auto levelCount = (uint8_t)load.levels.size();
+
+	_createStorage(load.width, load.height, load.format, levelCount);
+	mTransparency = load.transparent;
+
+	//streamed textures keep their chain in memory anyway, and only upload the low mips now
+	auto streamer = Platform::singleton().getRenderer().getTextureStreamer().to_ref();
+	if (streamer and levelCount > 1) {
+		mMipData = std::move(load.levels);
+
+		loaded = true;
+		streamer.get().add(self);
+		return true;
+	}
+
+	for (uint8_t i = 0; i < levelCount; ++i) {
+		_uploadLevel(i, load.levels[i].data());
+	}
+
+	return loaded = true;
+}
+
+void Texture::_onDecoded(const std::shared_ptr<AsyncLoad>& load) {
+	//failures and streamed textures don't need the unpack buffer
+	auto streamed = Platform::singleton().getRenderer().getTextureStreamer().is_some() and load->levels.size() > 1;
+	if (load->format == PixelFormat::Unknown or streamed) {
+		_loadDecoded(*load);
+		mPending = false;
+		mAsyncLoad.reset();
+		_updateOptimalBillboard();
+		_releaseWaitingTiles();
+		return;
+	}
+
+	size_t size = 0;
+	for (auto&& level : load->levels) {
+		load->offsets.push_back(size);
+		size += level.size();
+	}
+
+	glGenBuffers(1, &load->PBO);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, load->PBO);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	load->mappedPBO = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	DEBUG_ASSERT(load->mappedPBO, "Cannot map the pixel unpack buffer");
+
+	//the copy into the mapped buffer happens on a worker too
+	Platform::singleton().getBackgroundPool().queue([load] {
+		for (auto i : range(load->levels.size())) {
+			memcpy(load->mappedPBO + load->offsets[i], load->levels[i].data(), load->levels[i].size());
+		}
+		load->levels.clear();
+	},
+	[this, load] {
+		if (not load->cancelled) {
+			_finishAsyncLoad(*load);
+			return;
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, load->PBO);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &load->PBO);
+	});
+}
+
+void Texture::_finishAsyncLoad(AsyncLoad& load) {
+	auto levelCount = (uint8_t)load.offsets.size();
+
+	_createStorage(load.width, load.height, load.format, levelCount);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, load.PBO);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	//with a bound unpack buffer, the data pointers are offsets in it
+	for (uint8_t i = 0; i < levelCount; ++i) {
+		_uploadLevel(i, (const uint8_t*)(uintptr_t)load.offsets[i]);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	//GL keeps the storage alive until the uploads are done
+	glDeleteBuffers(1, &load.PBO);
+
+	mTransparency = load.transparent;
+	mPending = false;
+	mAsyncLoad.reset();
+	loaded = true;
+
+	_updateOptimalBillboard();
+	_releaseWaitingTiles();
+}
+
+void Texture::_cancelAsyncLoad() {
+	if (mAsyncLoad) {
+		mAsyncLoad->cancelled = true;
+		mAsyncLoad.reset();
+	}
+
+	//a tile just stops waiting for its atlas
+	if (auto atlas = parentAtlas.to_ref()) {
+		auto& waiting = atlas.get().mWaitingTiles;
+		waiting.erase(std::remove(waiting.begin(), waiting.end(), this), waiting.end());
+	}
+
+	mPending = false;
+	_releaseWaitingTiles();
+}
+
+void Texture::_releaseWaitingTiles() {
+	//the tiles set up from this atlas, or stop pending if it didn't load
+	for (auto&& tile : mWaitingTiles) {
+		tile->_setupAtlas();
+	}
+	mWaitingTiles.clear();
 }
 
 bool Texture::_setupAtlas() {
 	auto& atlas = parentAtlas.unwrap();
 
+	//the tile is pending until the atlas is done
+	if (atlas.isPending()) {
+		if (not mPending) {
+			mPending = true;
+			atlas.mWaitingTiles.push_back(this);
+		}
+		return (loaded = false);
+	}
+
+	mPending = false;
+
 	if (not atlas.isLoaded()) {
 		return (loaded = false);
 	}
@@ -252,6 +713,9 @@ bool Texture::_setupAtlas() {
 	internalWidth = atlas.getInternalWidth();
 	internalHeight = atlas.getInternalHeight();
 
+	//the atlas is usually added before it's loaded
+	mTransparency = atlas.mTransparency;
+
 	DEBUG_ASSERT(width > 0 and height > 0 and internalWidth > 0 and internalHeight > 0, "One or more texture dimensions are invalid (less or equal to 0)");
 
 	//copy bind handle
@@ -265,6 +729,8 @@ bool Texture::_setupAtlas() {
 	UVSize.x = (float)width / (float)internalWidth;
 	UVSize.y = (float)height / (float)internalHeight;
 
+	_updateOptimalBillboard();
+
 	return (loaded = true);
 }
 
@@ -285,25 +751,72 @@ bool Texture::loadFromAtlas(Texture& tex, int x, int y, int sx, int sy) {
 	return false;
 }
 
+void Texture::_detachFromAtlas() {
+	DEBUG_ASSERT(parentAtlas.is_some(), "This texture isn't an atlas tile");
+	DEBUG_ASSERT(not isLoaded() and not isPending(), "The tile must be unloaded first");
+
+	parentAtlas = {};
+	mAtlasOriginX = mAtlasOriginY = 0;
+
+	//the handle was the atlas'
+	glhandle = 0;
+	internalWidth = internalHeight = 0;
+	mTransparency = false;
+}
+
+void Texture::onPrepare() {
+	DEBUG_ASSERT(not isLoaded() and not isPending(), "The texture is already loaded");
+
+	if (not isReloadable() or parentAtlas.is_some() or (creator.is_some() and creator.unwrap().asyncTextureLoading)) {
+		return;
+	}
+
+	auto load = make_shared<AsyncLoad>();
+	load->path = filePath;
+	load->mipmaps = creator.is_none() or not creator.unwrap().disableMipmaps;
+	load->NPOTEnabled = Platform::singleton().isNPOTEnabled();
+
+	_decode(*load);
+
+	mPreparedLoad = std::move(load);
+	prepared = true;
+}
+
 bool Texture::onLoad() {
-	DEBUG_ASSERT(not isLoaded(), "The texture is already loaded");
+	DEBUG_ASSERT(not isLoaded() and not isPending(), "The texture is already loaded");
 
 	//invalidate the OBB
 	OBB.reset();
 
-	if (isReloadable()) {
-		return loadFromFile(filePath);
+	if (prepared) {
+		auto load = std::move(mPreparedLoad);
+		prepared = false;
+
+		_applyCreatorSampling();
+		return _loadDecoded(*load);
 	}
 	else if (parentAtlas.is_some()) {
+		//loose frames packed in an AtlasPage keep their path, but load from the page
 		return _setupAtlas();
 	}
+	else if (isReloadable()) {
+		if (creator.is_some() and creator.unwrap().asyncTextureLoading) {
+			return loadAsync();
+		}
+		return loadFromFile(filePath);
+	}
 	else {
 		return false;
 	}
 }
 
 void Texture::onUnload(bool soft) {
-	DEBUG_ASSERT(isLoaded(), "The Texture is not loaded");
+	DEBUG_ASSERT(isLoaded() or isPending(), "The Texture is not loaded");
+
+	if (mPending) {
+		_cancelAsyncLoad();
+		return;
+	}
 
 	if (not soft or isReloadable()) {
 		if (OBB) {
@@ -312,8 +825,16 @@ void Texture::onUnload(bool soft) {
 
 		if (parentAtlas.is_none()) { //don't unload parent texture!
 			DEBUG_ASSERT(glhandle, "Tried to unload a texture but the texture handle was invalid");
+
+			if (auto streamer = mStreamer.to_ref()) {
+				streamer.get().remove(self);
+			}
+
 			glDeleteTextures(1, &glhandle);
 
+			mMipData.clear();
+			mLevelCount = 1;
+			mResidentLevel = 0;
 			internalWidth = internalHeight = 0;
 			internalFormat = PixelFormat::Unknown;
 			glhandle = 0;
@@ -333,6 +854,10 @@ void Texture::_rebuildOptimalBillboard() {
 		//build or rebuild the OBB
 		OBB->setVertexFields({ VertexField::Position2D, VertexField::UV0 });
 	}
+	else if (OBB->isLoaded()) {
+		//the OBB is static, and the Renderables that use it keep a reference to it
+		OBB->onUnload();
+	}
 
 	OBB->begin(4);
 
@@ -355,6 +880,12 @@ void Texture::_rebuildOptimalBillboard() {
 	OBB->end();
 }
 
+void Texture::_updateOptimalBillboard() {
+	if (OBB) {
+		_rebuildOptimalBillboard();
+	}
+}
+
 Mesh& Texture::getOptimalBillboard() {
 	if (not OBB) {
 		_rebuildOptimalBillboard();
@@ -368,6 +899,58 @@ void Texture::_notifyScreenSize(const Vector& ss) {
 	screenSize.y = ss.y;
 }
 
+void Texture::_requestScreenSize(float pixels) {
+	//a tile covers a part of its atlas, that needs to be as much bigger
+	if (auto atlas = parentAtlas.to_ref()) {
+		atlas.get()._requestScreenSize(pixels * atlas.get().getWidth() / width);
+		return;
+	}
+
+	if (not isStreamed()) {
+		return;
+	}
+
+	auto current = mRequestedSize.load(std::memory_order_relaxed);
+	while (pixels > current and not mRequestedSize.compare_exchange_weak(current, pixels, std::memory_order_relaxed)) {
+	}
+}
+
+uint8_t Texture::_takeRequestedLevel() {
+	auto pixels = mRequestedSize.exchange(0.f, std::memory_order_relaxed);
+	if (pixels <= 0) {
+		return NotRequested;
+	}
+
+	//the most detailed level that still has at least a texel per pixel
+	auto side = (float)std::max(width, height);
+	if (pixels >= side) {
+		return 0;
+	}
+
+	return (uint8_t)std::min((int)std::log2(side / pixels), mLevelCount - 1);
+}
+
+void Texture::_setResidentLevel(uint8_t level) {
+	DEBUG_ASSERT(isStreamed(), "Only streamed textures keep their mips to upload them again");
+
+	_allocateLevels(level);
+
+	for (auto i = level; i < mLevelCount; ++i) {
+		_uploadLevel(i, mMipData[i].data());
+	}
+}
+
+void Texture::_attachStreamer(TextureStreamer& streamer) {
+	DEBUG_ASSERT(mMipData.size() == mLevelCount, "The mip chain must be in memory to be streamed");
+
+	mStreamer = streamer;
+}
+
+void Texture::_detachStreamer() {
+	mStreamer = {};
+	mMipData.clear();
+}
+
 void Texture::_notifyOwnerFrameSet(FrameSet& s) {
 	DEBUG_ASSERT(ownerFrameSet.is_none(), "Tried to set an owner on an already owned Texture");
 
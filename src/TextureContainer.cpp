@@ -0,0 +1,230 @@
+#include "TextureContainer.h"
+
+#include "Path.h"
+#include "Platform.h"
+#include "TexFormatInfo.h"
+
+using namespace Dojo;
+
+static const uint8_t KTX2_IDENTIFIER[] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const size_t KTX2_HEADER_SIZE = 80, KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+static const size_t DDS_HEADER_SIZE = 4 + 124, DDS_DX10_HEADER_SIZE = 20;
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_VOLUME = 0x200000;
+
+//the variants an image can have, from the one that compresses best
+static const char* VARIANT_SUFFIXES[] = { ".astc.ktx2", ".bc.ktx2", ".dds", ".etc2.ktx2" };
+
+template<typename T>
+T _readLE(const std::vector<uint8_t>& data, size_t offset) {
+	T value;
+	memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
+constexpr uint32_t _fourCC(char a, char b, char c, char d) {
+	return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+//the length of a full mip chain, down to 1x1
+uint32_t _getMaxLevelCount(uint32_t width, uint32_t height) {
+	uint32_t count = 1;
+	for (auto side = std::max(width, height); side > 1; side >>= 1) {
+		++count;
+	}
+	return count;
+}
+
+bool _isInside(uint64_t offset, uint64_t size, size_t dataSize) {
+	return offset <= dataSize and size <= dataSize - offset;
+}
+
+PixelFormat _formatFromVk(uint32_t vkFormat) {
+	switch (vkFormat) {
+	case 133: return PixelFormat::BC1_RGBA;
+	case 134: return PixelFormat::BC1_RGBA_SRGB;
+	case 137: return PixelFormat::BC3_RGBA;
+	case 138: return PixelFormat::BC3_RGBA_SRGB;
+	case 139: return PixelFormat::BC4_R;
+	case 141: return PixelFormat::BC5_RG;
+	case 145: return PixelFormat::BC7_RGBA;
+	case 146: return PixelFormat::BC7_RGBA_SRGB;
+	case 147: return PixelFormat::ETC2_RGB;
+	case 148: return PixelFormat::ETC2_RGB_SRGB;
+	case 151: return PixelFormat::ETC2_RGBA;
+	case 152: return PixelFormat::ETC2_RGBA_SRGB;
+	case 153: return PixelFormat::EAC_R;
+	case 155: return PixelFormat::EAC_RG;
+	case 157: return PixelFormat::ASTC_4x4_RGBA;
+	case 158: return PixelFormat::ASTC_4x4_RGBA_SRGB;
+	default: return PixelFormat::Unknown;
+	}
+}
+
+PixelFormat _formatFromDXGI(uint32_t dxgiFormat) {
+	switch (dxgiFormat) {
+	case 71: return PixelFormat::BC1_RGBA;
+	case 72: return PixelFormat::BC1_RGBA_SRGB;
+	case 77: return PixelFormat::BC3_RGBA;
+	case 78: return PixelFormat::BC3_RGBA_SRGB;
+	case 80: return PixelFormat::BC4_R;
+	case 83: return PixelFormat::BC5_RG;
+	case 98: return PixelFormat::BC7_RGBA;
+	case 99: return PixelFormat::BC7_RGBA_SRGB;
+	default: return PixelFormat::Unknown;
+	}
+}
+
+PixelFormat _formatFromFourCC(uint32_t fourCC) {
+	switch (fourCC) {
+	case _fourCC('D', 'X', 'T', '1'): return PixelFormat::BC1_RGBA;
+	case _fourCC('D', 'X', 'T', '5'): return PixelFormat::BC3_RGBA;
+	case _fourCC('A', 'T', 'I', '1'):
+	case _fourCC('B', 'C', '4', 'U'): return PixelFormat::BC4_R;
+	case _fourCC('A', 'T', 'I', '2'):
+	case _fourCC('B', 'C', '5', 'U'): return PixelFormat::BC5_RG;
+	default: return PixelFormat::Unknown;
+	}
+}
+
+bool TextureContainer::load(utf::string_view path) {
+	return loadFromMemory(Platform::singleton().loadFileContent(path));
+}
+
+bool TextureContainer::loadFromMemory(std::vector<uint8_t> fileData) {
+	mData = std::move(fileData);
+	mLevels.clear();
+	mFormat = PixelFormat::Unknown;
+
+	bool valid = false;
+	if (mData.size() >= KTX2_HEADER_SIZE and memcmp(mData.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+		valid = _parseKTX2();
+	}
+	else if (mData.size() >= DDS_HEADER_SIZE and _readLE<uint32_t>(mData, 0) == _fourCC('D', 'D', 'S', ' ')) {
+		valid = _parseDDS();
+	}
+
+	if (not valid or not TexFormatInfo::isSupported(mFormat)) {
+		mData.clear();
+		mLevels.clear();
+		mFormat = PixelFormat::Unknown;
+		return false;
+	}
+	return true;
+}
+
+bool TextureContainer::loadVariantOf(utf::string_view imagePath) {
+	auto ext = Path::getFileExtension(imagePath);
+	if (ext == "ktx2" or ext == "dds") {
+		return load(imagePath);
+	}
+
+	utf::string_view base{ imagePath.begin(), imagePath.find_last_of('.') };
+
+	//a variant in a format the GPU lacks is skipped for the next one
+	for (auto&& suffix : VARIANT_SUFFIXES) {
+		auto path = base + suffix;
+		if (Path::isFile(path) and load(path)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TextureContainer::hasVariant(utf::string_view imagePath) {
+	utf::string_view base{ imagePath.begin(), imagePath.find_last_of('.') };
+
+	for (auto&& suffix : VARIANT_SUFFIXES) {
+		if (Path::isFile(base + suffix)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TextureContainer::_parseKTX2() {
+	auto vkFormat = _readLE<uint32_t>(mData, 12);
+	mWidth = _readLE<uint32_t>(mData, 20);
+	mHeight = _readLE<uint32_t>(mData, 24);
+	auto depth = _readLE<uint32_t>(mData, 28);
+	auto layerCount = _readLE<uint32_t>(mData, 32);
+	auto faceCount = _readLE<uint32_t>(mData, 36);
+	auto levelCount = std::max(_readLE<uint32_t>(mData, 40), 1u);
+	auto supercompression = _readLE<uint32_t>(mData, 44);
+
+	if (depth > 0 or layerCount > 0 or faceCount != 1 or supercompression != 0 or mWidth == 0 or mHeight == 0) {
+		return false;
+	}
+
+	mFormat = _formatFromVk(vkFormat);
+	if (mFormat == PixelFormat::Unknown or levelCount > _getMaxLevelCount(mWidth, mHeight) or KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE > mData.size()) {
+		return false;
+	}
+
+	auto& info = TexFormatInfo::getFor(mFormat);
+
+	//the level index starts from the most detailed level
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		auto entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+		auto offset = _readLE<uint64_t>(mData, entry);
+		auto size = _readLE<uint64_t>(mData, entry + 8);
+
+		//the levels are uploaded with the size their format gives them, so they must have exactly that size
+		if (not _isInside(offset, size, mData.size()) or size != info.getImageSize(std::max(1u, mWidth >> i), std::max(1u, mHeight >> i))) {
+			return false;
+		}
+
+		mLevels.push_back({ mData.data() + offset, (size_t)size });
+	}
+
+	return true;
+}
+
+bool TextureContainer::_parseDDS() {
+	auto flags = _readLE<uint32_t>(mData, 8);
+	mHeight = _readLE<uint32_t>(mData, 12);
+	mWidth = _readLE<uint32_t>(mData, 16);
+	auto levelCount = (flags & DDSD_MIPMAPCOUNT) ? std::max(_readLE<uint32_t>(mData, 28), 1u) : 1u;
+	auto fourCC = _readLE<uint32_t>(mData, 84);
+	auto caps2 = _readLE<uint32_t>(mData, 112);
+
+	if ((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) or mWidth == 0 or mHeight == 0) {
+		return false;
+	}
+
+	size_t offset = DDS_HEADER_SIZE;
+	if (fourCC == _fourCC('D', 'X', '1', '0')) {
+		if (mData.size() < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) {
+			return false;
+		}
+
+		mFormat = _formatFromDXGI(_readLE<uint32_t>(mData, DDS_HEADER_SIZE));
+		auto arraySize = _readLE<uint32_t>(mData, DDS_HEADER_SIZE + 12);
+		if (arraySize > 1) {
+			return false;
+		}
+
+		offset += DDS_DX10_HEADER_SIZE;
+	}
+	else {
+		mFormat = _formatFromFourCC(fourCC);
+	}
+
+	return mFormat != PixelFormat::Unknown and levelCount <= _getMaxLevelCount(mWidth, mHeight) and _addPackedLevels(offset, levelCount);
+}
+
+bool TextureContainer::_addPackedLevels(size_t offset, uint32_t levelCount) {
+	auto& info = TexFormatInfo::getFor(mFormat);
+
+	for (uint32_t i = 0; i < levelCount; ++i) {
+		auto size = info.getImageSize(std::max(1u, mWidth >> i), std::max(1u, mHeight >> i));
+		if (not _isInside(offset, size, mData.size())) {
+			return false;
+		}
+
+		mLevels.push_back({ mData.data() + offset, size });
+		offset += size;
+	}
+	return true;
+}
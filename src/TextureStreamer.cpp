@@ -0,0 +1,131 @@
+#include "TextureStreamer.h"
+
+#include "Texture.h"
+
+using namespace Dojo;
+
+TextureStreamer::TextureStreamer(size_t VRAMBudget) :
+	mBudget(VRAMBudget) {
+
+}
+
+TextureStreamer::~TextureStreamer() {
+	for (auto&& entry : mEntries) {
+		entry.texture->_detachStreamer();
+	}
+}
+
+uint8_t TextureStreamer::getInitialLevel(const Texture& texture) {
+	uint8_t level = 0;
+	while (level + 1 < texture.getLevelCount() and (std::max(texture.getWidth(), texture.getHeight()) >> level) > InitialResidentSize) {
+		++level;
+	}
+	return level;
+}
+
+void TextureStreamer::add(Texture& texture) {
+	texture._attachStreamer(*this);
+
+	auto level = getInitialLevel(texture);
+	texture._setResidentLevel(level);
+
+	mEntries.push_back({ &texture, mFrame, level });
+	mResidentSize += texture.getVRAMSize(level);
+}
+
+void TextureStreamer::remove(Texture& texture) {
+	for (auto&& entry : mEntries) {
+		if (entry.texture == &texture) {
+			mResidentSize -= texture.getVRAMSize(texture.getResidentLevel());
+
+			entry = mEntries.back();
+			mEntries.pop_back();
+			break;
+		}
+	}
+
+	texture._detachStreamer();
+}
+
+void TextureStreamer::update() {
+	++mFrame;
+	mUploadCount = mEvictionCount = 0;
+
+	//find the level each texture wants; the ones that weren't drawn keep what they have until the budget runs out
+	size_t total = 0;
+	for (auto&& entry : mEntries) {
+		auto& texture = *entry.texture;
+		auto resident = texture.getResidentLevel();
+		auto requested = texture._takeRequestedLevel();
+
+		if (requested != Texture::NotRequested) {
+			entry.lastRequestFrame = mFrame;
+			entry.target = std::min(requested, resident);
+		}
+		else {
+			entry.target = resident;
+		}
+
+		total += texture.getVRAMSize(entry.target);
+	}
+
+	if (total > mBudget) {
+		mOrder.resize(mEntries.size());
+		for (uint32_t i = 0; i < mOrder.size(); ++i) {
+			mOrder[i] = i;
+		}
+
+		//least recently drawn first, then the biggest
+		std::sort(mOrder.begin(), mOrder.end(), [this](uint32_t a, uint32_t b) {
+			auto& ea = mEntries[a];
+			auto& eb = mEntries[b];
+			if (ea.lastRequestFrame != eb.lastRequestFrame) {
+				return ea.lastRequestFrame < eb.lastRequestFrame;
+			}
+			return ea.texture->getVRAMSize(ea.target) > eb.texture->getVRAMSize(eb.target);
+		});
+
+		//textures drawn in the same frame lose a level each in turn, so that no single one is stripped down to its low mips
+		size_t groupBegin = 0;
+		while (total > mBudget and groupBegin < mOrder.size()) {
+			auto frame = mEntries[mOrder[groupBegin]].lastRequestFrame;
+			auto groupEnd = groupBegin;
+			while (groupEnd < mOrder.size() and mEntries[mOrder[groupEnd]].lastRequestFrame == frame) {
+				++groupEnd;
+			}
+
+			bool evicted = true;
+			while (total > mBudget and evicted) {
+				evicted = false;
+				for (auto i = groupBegin; i < groupEnd and total > mBudget; ++i) {
+					auto& entry = mEntries[mOrder[i]];
+					if (entry.target < getInitialLevel(*entry.texture)) {
+						total -= entry.texture->getVRAMSize(entry.target) - entry.texture->getVRAMSize(entry.target + 1);
+						++entry.target;
+						evicted = true;
+					}
+				}
+			}
+
+			groupBegin = groupEnd;
+		}
+	}
+
+	//evictions free VRAM right away, while uploads are spread over the frames one level at a time
+	mResidentSize = 0;
+	for (auto&& entry : mEntries) {
+		auto& texture = *entry.texture;
+		auto resident = texture.getResidentLevel();
+
+		if (entry.target > resident) {
+			texture._setResidentLevel(entry.target);
+			++mEvictionCount;
+		}
+		else if (entry.target < resident and mUploadCount < mUploadsPerFrame) {
+			texture._setResidentLevel(resident - 1);
+			++mUploadCount;
+		}
+
+		mResidentSize += texture.getVRAMSize(texture.getResidentLevel());
+	}
+}
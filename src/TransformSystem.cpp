@@ -0,0 +1,150 @@
+#include "TransformSystem.h"
+
+#include "Object.h"
+#include "WorkerPool.h"
+
+using namespace Dojo;
+
+TransformSystem::Handle TransformSystem::addRoot(Object& object) {
+	return _add(object, 0, 0);
+}
+
+TransformSystem::Handle TransformSystem::add(Object& object, const Handle& parent) {
+	DEBUG_ASSERT(parent.depth < mLevels.size() and parent.index < mLevels[parent.depth].size(), "Invalid parent handle");
+
+	return _add(object, parent.depth + 1, parent.index);
+}
+
+TransformSystem::Handle TransformSystem::_add(Object& object, uint32_t depth, uint32_t parentIndex) {
+	if (depth >= mLevels.size()) {
+		mLevels.resize(depth + 1);
+	}
+
+	auto& level = mLevels[depth];
+
+	Handle handle;
+	handle.depth = depth;
+	handle.index = (uint32_t)level.size();
+
+	level.positions.emplace_back(object.position);
+	level.rotations.emplace_back(object.getRotation());
+	level.parents.emplace_back(parentIndex);
+	level.world.emplace_back(object.getWorldTransform());
+	level.versions.emplace_back(mPass);
+	level.dirty.emplace_back(1);
+	level.owners.emplace_back(&object);
+
+	return handle;
+}
+
+void TransformSystem::remove(const Handle& handle) {
+	auto& level = mLevels[handle.depth];
+	auto last = (uint32_t)level.size() - 1;
+
+	DEBUG_ASSERT(handle.index <= last, "Invalid handle");
+
+	//move the last entry in the hole, its Object and its children have to know
+	if (handle.index != last) {
+		level.positions[handle.index] = level.positions[last];
+		level.rotations[handle.index] = level.rotations[last];
+		level.parents[handle.index] = level.parents[last];
+		level.world[handle.index] = level.world[last];
+		level.versions[handle.index] = level.versions[last];
+		level.dirty[handle.index] = level.dirty[last];
+		level.owners[handle.index] = level.owners[last];
+
+		level.owners[handle.index]->_setTransformIndex(handle.index);
+	}
+
+	level.positions.pop_back();
+	level.rotations.pop_back();
+	level.parents.pop_back();
+	level.world.pop_back();
+	level.versions.pop_back();
+	level.dirty.pop_back();
+	level.owners.pop_back();
+
+	while (mLevels.size() > 0 and mLevels.back().size() == 0) {
+		mLevels.pop_back();
+	}
+}
+
+void TransformSystem::setLocal(const Handle& handle, const Vector& position, const Quaternion& rotation) {
+	auto& level = mLevels[handle.depth];
+
+	if (level.positions[handle.index] != position or level.rotations[handle.index] != rotation) {
+		level.positions[handle.index] = position;
+		level.rotations[handle.index] = rotation;
+		level.dirty[handle.index] = 1;
+	}
+}
+
+void TransformSystem::updateNow(const Handle& handle, const Vector& position, const Quaternion& rotation) {
+	auto& level = mLevels[handle.depth];
+	level.positions[handle.index] = position;
+	level.rotations[handle.index] = rotation;
+
+	_computeWorld(handle.depth, handle.index);
+	level.versions[handle.index] = ++mPass;
+
+	//stays dirty so that the descendants follow in the next update
+	level.dirty[handle.index] = 1;
+}
+
+void TransformSystem::_computeWorld(uint32_t depth, uint32_t index) {
+	auto& level = mLevels[depth];
+
+	auto local = glm::translate(Matrix{ 1 }, level.positions[index]) * glm::mat4_cast(level.rotations[index]);
+
+	if (depth > 0) {
+		level.world[index] = mLevels[depth - 1].world[level.parents[index]] * local;
+	}
+	else {
+		level.world[index] = local;
+	}
+}
+
+uint32_t TransformSystem::update(WorkerPool& pool) {
+	std::atomic<uint32_t> updated = { 0 };
+	++mPass;
+
+	//each level only reads the previous one, so its chunks can run in parallel
+	for (uint32_t depth = 0; depth < mLevels.size(); ++depth) {
+		auto& level = mLevels[depth];
+		auto count = (uint32_t)level.size();
+		auto chunkCount = (count + ChunkSize - 1) / ChunkSize;
+
+		const uint8_t* parentDirty = depth > 0 ? mLevels[depth - 1].dirty.data() : nullptr;
+
+		pool.parallelFor(chunkCount, [&, depth, count, parentDirty](uint32_t chunk) {
+			auto end = std::min(count, (chunk + 1) * ChunkSize);
+			uint32_t chunkUpdated = 0;
+
+			for (auto i = chunk * ChunkSize; i < end; ++i) {
+				if (level.dirty[i] or (parentDirty and parentDirty[level.parents[i]])) {
+					_computeWorld(depth, i);
+					level.versions[i] = mPass;
+					level.dirty[i] = 1;
+					++chunkUpdated;
+				}
+			}
+
+			updated += chunkUpdated;
+		});
+	}
+
+	//the flags were needed by the children until the last level was done
+	for (auto&& level : mLevels) {
+		std::fill(level.dirty.begin(), level.dirty.end(), 0);
+	}
+
+	return updated;
+}
+
+size_t TransformSystem::size() const {
+	size_t count = 0;
+	for (auto&& level : mLevels) {
+		count += level.size();
+	}
+	return count;
+}
@@ -126,6 +126,9 @@ void Viewport::_updateFrustum() {
 		//far plane
 		mWorldFrustumPlanes[4].setup(mWorldFrustumVertices[2], mWorldFrustumVertices[1], mWorldFrustumVertices[0]);
 
+		//culling only uses the side planes
+		mFrustumPlanes.setup(mWorldFrustumPlanes);
+
 		mFrustumDirty = false;
 	}
 }
@@ -184,20 +187,15 @@ void Viewport::addVisibleLayersRange(RenderLayer::ID min, RenderLayer::ID max) {
 
 bool Viewport::isContainedInFrustum(const Renderable& r) const {
 	if (auto mesh = r.getMesh().to_ref()) {
-		AABB bb = r.getObject().transformAABB(mesh.get().getBounds().scale(r.scale));
-
-		//for each plane, check where the AABB is placed
-		for (auto&& i : range(4)) {
-			if (mWorldFrustumPlanes[i].getSide(bb) < 0) {
-				return false;
-			}
-		}
-
-		return true;
+		return isContainedInFrustum(r.getObject().transformAABB(mesh.get().getBounds().scale(r.scale)));
 	}
 	return false;
 }
 
+bool Viewport::isContainedInFrustum(const AABB& bb) const {
+	return BoundsMath::isInFrustum(mFrustumPlanes, bb);
+}
+
 bool Viewport::isInViewRect(const Renderable& r) const {
 	return isInViewRect(r.getGraphicsAABB());
 }
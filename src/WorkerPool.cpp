@@ -4,6 +4,20 @@
 
 using namespace Dojo;
 
+struct WorkerPool::ParallelFor {
+	std::atomic<uint32_t> references = { 0 };
+	std::atomic<uint32_t> next = { 0 }, done = { 0 };
+	uint32_t count = 0;
+	const ParallelTask* task = nullptr;
+
+	void run() {
+		for (uint32_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+			(*task)(i);
+			done.fetch_add(1, std::memory_order_release);
+		}
+	}
+};
+
 WorkerPool::WorkerPool(uint32_t workerCount, bool async, bool allowMultipleProducers) :
 isAsync(async) {
 	DEBUG_ASSERT(workerCount > 0, "Invalid worker count");
@@ -61,3 +75,59 @@ bool WorkerPool::runOneCallback() {
 
 	return false;
 }
+
+void WorkerPool::parallelFor(uint32_t count, const ParallelTask& task) {
+	if (count == 0) {
+		return;
+	}
+
+	if (not isAsync or count == 1) {
+		for (uint32_t i = 0; i < count; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+	//find a state that no helper job is using anymore
+	ParallelFor* state = nullptr;
+	for (auto&& s : mParallelForStates) {
+		if (s->references == 0) {
+			state = s.get();
+			break;
+		}
+	}
+
+	if (not state) {
+		mParallelForStates.emplace_back(make_unique<ParallelFor>());
+		state = mParallelForStates.back().get();
+	}
+
+	auto helpers = std::min<uint32_t>((uint32_t)mWorkers.size(), count - 1);
+
+	state->task = &task;
+	state->count = count;
+	state->done = 0;
+	state->next = 0;
+	state->references = helpers + 1;
+
+	for (uint32_t i = 0; i < helpers; ++i) {
+		//no status and no callback, so that queueing doesn't allocate
+		AsyncJob job;
+		job.task = [state] {
+			state->run();
+			--state->references;
+		};
+
+		mWorkers[mNextWorker]->queueJob(std::move(job));
+		mNextWorker = (mNextWorker + 1) % mWorkers.size();
+	}
+
+	state->run();
+
+	//wait for the indices still being processed by the helpers; the ones not started yet will find nothing to do
+	while (state->done.load(std::memory_order_acquire) < count) {
+		std::this_thread::yield();
+	}
+
+	--state->references;
+}